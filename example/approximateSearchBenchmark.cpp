@@ -0,0 +1,103 @@
+#include "../source/hotsBlocs.hpp"
+#include "../source/productQuantizationCluster.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// the dimensions of the third layer of hotsMain
+#define NCENTERS 128
+#define NEIGHBORHOOD 416
+#define NEVENTS 20000
+#define PROTOTYPES 16
+
+struct ClusterEvent{
+  std::array<double, NEIGHBORHOOD> context;
+};
+
+typedef std::array<std::array<double, NEIGHBORHOOD>, NCENTERS> Centers;
+
+/// measure runs a cluster over the events, and returns its throughput in events per second
+template<typename Cluster>
+double measure(const std::vector<ClusterEvent>& events, Cluster& cluster){
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& event: events){
+    cluster(event);
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(events.size())/(static_cast<double>(duration.count())/1e6);
+}
+
+/// report prints the recall and the speed of an approximate cluster against the exact polarities
+template<typename Metric>
+void report(const Centers& centers, const std::vector<ClusterEvent>& events, const std::vector<int64_t>& expected, double exactSpeed,
+            std::size_t numberOfSubspaces, std::size_t numberOfCodes, std::size_t numberOfCandidates, Metric metric){
+  std::vector<int64_t> polarities;
+  polarities.reserve(events.size());
+  auto cluster = tarsier::make_productQuantizationCluster<NCENTERS, NEIGHBORHOOD, true, ClusterEvent, int64_t>(
+    centers, numberOfSubspaces, numberOfCodes, numberOfCandidates, metric,
+    [](const ClusterEvent&, int64_t p){
+      return p;
+    },
+    [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  const auto speed = measure(events, cluster);
+  std::size_t matches = 0;
+  for(std::size_t index = 0; index < events.size(); index++){
+    matches += (polarities[index] == expected[index]) ? 1 : 0;
+  }
+  std::cout << numberOfSubspaces << " subspaces, " << numberOfCodes << " codes, " << numberOfCandidates << " candidates\t-> recall: "
+            << static_cast<double>(matches)/events.size() << ", speed: " << speed << " evs/secs (x" << speed/exactSpeed << ")" << std::endl;
+}
+
+template<typename Metric>
+void compare(const std::string& name, const Centers& centers, const std::vector<ClusterEvent>& events, Metric metric){
+  std::vector<int64_t> expected;
+  expected.reserve(events.size());
+  auto exact = tarsier::make_iiwkCluster<NCENTERS, NEIGHBORHOOD, true, false, ClusterEvent, int64_t>(
+    2e-4, 2e-4, 1., centers, metric,
+    [](const ClusterEvent&, int64_t p){
+      return p;
+    },
+    [&expected](int64_t p){
+      expected.push_back(p);
+    });
+  const auto exactSpeed = measure(events, exact);
+  std::cout << name << " exact\t-> speed: " << exactSpeed << " evs/secs" << std::endl;
+  for(auto&& numberOfSubspaces: {8, 26, 52}){
+    for(auto&& numberOfCodes: {16, 64}){
+      for(auto&& numberOfCandidates: {1, 4, 16}){
+        report(centers, events, expected, exactSpeed, numberOfSubspaces, numberOfCodes, numberOfCandidates, metric);
+      }
+    }
+  }
+}
+
+int main(void){
+  srand(0);
+  // sparse centers sharing a few prototypes, and noisy contexts around them, like the time surfaces of a trained layer
+  std::array<std::array<double, NEIGHBORHOOD>, PROTOTYPES> prototypes;
+  for(auto&& prototype: prototypes){
+    for(auto&& value: prototype){
+      value = (rand()%4 == 0) ? static_cast<double>(rand())/RAND_MAX : 0.;
+    }
+  }
+  Centers centers;
+  for(std::size_t i = 0; i < NCENTERS; i++){
+    for(std::size_t j = 0; j < NEIGHBORHOOD; j++){
+      centers[i][j] = 0.01 + 0.6*prototypes[i%PROTOTYPES][j] + ((rand()%8 == 0) ? 0.4*static_cast<double>(rand())/RAND_MAX : 0.);
+    }
+  }
+  std::vector<ClusterEvent> events(NEVENTS);
+  for(auto&& event: events){
+    const auto& center = centers[rand()%NCENTERS];
+    for(std::size_t j = 0; j < NEIGHBORHOOD; j++){
+      event.context[j] = center[j]*(0.5 + static_cast<double>(rand())/RAND_MAX) + 0.2*static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  compare("Euclidean", centers, events, tarsier::EuclideanMetric());
+  compare("Bhattacharyya", centers, events, tarsier::BhattacharyyaMetric());
+  return 0;
+}
@@ -0,0 +1,64 @@
+#include "../source/computeFlow.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// compile with -O3 -march=native to enable the AVX2 / SSE4.2 kernels
+
+#define WIDTH 640
+#define HEIGHT 480
+#define NEVENTS 5000000
+#define N 8
+#define LIFESPAN 20000
+
+struct Event{
+  uint16_t x;
+  uint16_t y;
+  uint64_t timestamp;
+} __attribute__((packed));
+
+struct FlowEvent{
+  uint64_t timestamp;
+  double vx;
+  double vy;
+};
+
+template<uint64_t window>
+void benchmark(const std::vector<Event>& events){
+  std::size_t flowEvents = 0;
+  auto computeFlow = tarsier::make_computeFlow<Event, FlowEvent, WIDTH, HEIGHT, window, N, LIFESPAN>(
+    [](Event ev, double vx, double vy){
+      return FlowEvent{ev.timestamp, vx, vy};
+    },
+    [&flowEvents](FlowEvent){
+      flowEvents++;
+    });
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    computeFlow(ev);
+  }
+  auto duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+  std::cout << "window " << window << "\t-> Speed: " << static_cast<double>(events.size())/(static_cast<double>(duration.count())/1000.) << " evs/secs, "
+            << static_cast<double>(flowEvents)/(static_cast<double>(duration.count())/1000.) << " flow evs/secs" << std::endl;
+}
+
+int main(void){
+  // a vertical bar moving to the right, with 25% background noise
+  std::vector<Event> events;
+  events.reserve(NEVENTS);
+  srand(0);
+  for(uint64_t t = 0; t < NEVENTS; t++){
+    auto x = static_cast<uint16_t>((t/20)%WIDTH);
+    if(rand()%4 == 0){
+      x = rand()%WIDTH;
+    }
+    events.push_back(Event{x, static_cast<uint16_t>(rand()%HEIGHT), t});
+  }
+  benchmark<2>(events);
+  benchmark<3>(events);
+  benchmark<4>(events);
+  benchmark<5>(events);
+  return 0;
+}
@@ -0,0 +1,147 @@
+#include "../source/timeSurfaceGenerator.hpp"
+#include "../source/hotsBlocs.hpp"
+#include "../source/dynamicTimeSurfaceGenerator.hpp"
+#include "../source/dynamicHotsBlocs.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#define XSIZE 346
+#define YSIZE 260
+#define NP 2
+#define RADIUS_1D 6
+#define RADIUS_2D 4
+#define TAU 1000.
+#define INIT_MEMORY -1000000
+#define NCENTERS 32
+#define NEIGHBORHOOD 72
+#define NEVENTS 500000
+
+struct Event{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+};
+
+struct Event1d{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+};
+
+struct ClusterEvent{
+  std::array<double, NEIGHBORHOOD> context;
+};
+
+/// EuclideanDistance works with the iterators of the templated clusters and the pointers of the dynamic ones
+struct EuclideanDistance{
+  template<typename CenterIterator, typename ContextIterator>
+  double operator()(CenterIterator centerBegin, CenterIterator centerEnd, ContextIterator contextBegin) const {
+    auto distance = 0.;
+    for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+      distance += (*centerBegin - *contextBegin)*(*centerBegin - *contextBegin);
+    }
+    return distance;
+  }
+};
+
+/// measure returns the throughput of handler over the events, in events per second
+template<typename Events, typename Handler>
+double measure(const Events& events, Handler& handler){
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    handler(ev);
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(events.size())/(static_cast<double>(duration.count())/1e6);
+}
+
+void report(const std::string& name, double templatedSpeed, double dynamicSpeed){
+  std::cout << name << "\t-> templated: " << templatedSpeed << " evs/secs, dynamic: " << dynamicSpeed
+            << " evs/secs (" << 100.*(dynamicSpeed/templatedSpeed - 1.) << "%)" << std::endl;
+}
+
+int main(void){
+  srand(0);
+  std::vector<Event> events;
+  std::vector<Event1d> events1d;
+  std::vector<ClusterEvent> clusterEvents;
+  for(int64_t i = 0; i < NEVENTS; i++){
+    events.push_back(Event{i*10, rand()%XSIZE, rand()%YSIZE, rand()%NP});
+    events1d.push_back(Event1d{i*10, rand()%XSIZE, rand()%NP});
+  }
+  for(int64_t i = 0; i < NEVENTS/10; i++){
+    ClusterEvent event;
+    for(auto&& value: event.context){
+      value = static_cast<double>(rand())/RAND_MAX;
+    }
+    clusterEvents.push_back(event);
+  }
+
+  double checksum = 0;
+  auto handler = [&checksum](double value){
+    checksum += value;
+  };
+
+  // 1D time surfaces
+  auto templatedTs1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS_1D, INIT_MEMORY, Event1d, double>(
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU),
+    [](Event1d, const std::array<double, (2*RADIUS_1D+1)*NP>& context){
+      return context[RADIUS_1D];
+    },
+    handler);
+  auto dynamicTs1d = tarsier::make_dynamicTimeSurfaceGenerator<Event1d, double>(
+    XSIZE, NP, RADIUS_1D, INIT_MEMORY,
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU),
+    [](Event1d, const tarsier::DynamicBuffer<double>& context){
+      return context[RADIUS_1D];
+    },
+    handler);
+  const auto templatedTs1dSpeed = measure(events1d, templatedTs1d);
+  const auto dynamicTs1dSpeed = measure(events1d, dynamicTs1d);
+  report("1D time surface", templatedTs1dSpeed, dynamicTs1dSpeed);
+
+  // 2D time surfaces
+  auto templatedTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event, double>(
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU),
+    [](Event, const std::array<double, (2*RADIUS_2D+1)*(2*RADIUS_2D+1)*NP>& context){
+      return context[RADIUS_2D];
+    },
+    handler);
+  auto dynamicTs2d = tarsier::make_dynamicTimeSurfaceGenerator<Event, double>(
+    XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY,
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU),
+    [](Event, const tarsier::DynamicBuffer<double>& context){
+      return context[RADIUS_2D];
+    },
+    handler);
+  const auto templatedTs2dSpeed = measure(events, templatedTs2d);
+  const auto dynamicTs2dSpeed = measure(events, dynamicTs2d);
+  report("2D time surface", templatedTs2dSpeed, dynamicTs2dSpeed);
+
+  // clusters
+  auto fromClusterEvent = [](ClusterEvent, int64_t p){
+    return static_cast<double>(p);
+  };
+  auto templatedIiwk = tarsier::make_iiwkCluster<NCENTERS, NEIGHBORHOOD, true, true, ClusterEvent, double>(
+    2e-4, 2e-4, 1., EuclideanDistance(), fromClusterEvent, handler);
+  auto dynamicIiwk = tarsier::make_dynamicIiwkCluster<true, true, ClusterEvent, double>(
+    NCENTERS, NEIGHBORHOOD, 2e-4, 2e-4, 1., EuclideanDistance(), fromClusterEvent, handler);
+  const auto templatedIiwkSpeed = measure(clusterEvents, templatedIiwk);
+  const auto dynamicIiwkSpeed = measure(clusterEvents, dynamicIiwk);
+  report("iiwk cluster", templatedIiwkSpeed, dynamicIiwkSpeed);
+
+  auto templatedStd = tarsier::make_stdCluster<NCENTERS, NEIGHBORHOOD, true, true, ClusterEvent, double>(
+    0.5, 500, EuclideanDistance(), fromClusterEvent, handler);
+  auto dynamicStd = tarsier::make_dynamicStdCluster<true, true, ClusterEvent, double>(
+    NCENTERS, NEIGHBORHOOD, 0.5, 500, EuclideanDistance(), fromClusterEvent, handler);
+  const auto templatedStdSpeed = measure(clusterEvents, templatedStd);
+  const auto dynamicStdSpeed = measure(clusterEvents, dynamicStd);
+  report("std cluster", templatedStdSpeed, dynamicStdSpeed);
+
+  std::cout << "checksum: " << checksum << std::endl;
+  return 0;
+}
@@ -1,5 +1,7 @@
 #include "../source/timeSurfaceGenerator.hpp"
+#include "../source/sparseTimeSurfaceGenerator.hpp"
 #include "../source/hotsBlocs.hpp"
+#include "../source/pipelineStage.hpp"
 
 #include <chrono>
 #include <vector>
@@ -41,56 +43,58 @@ struct Event{ // minimum field require to build 1D TS
   int64_t p;
 };
 
+// the lineage holds the input polarity and the polarity of each layer, inline
+typedef tarsier::Lineage<4> Lineage;
+
 struct HotsEvent{
   int64_t t;
   int64_t x;
   int64_t p;
-  std::vector<int64_t> lp;
+  Lineage lp;
 };
 
+// the contexts refer to the buffers of the time surface generators, which stay valid while the event goes through the cluster
 struct TsEvent1{
   int64_t t;
   int64_t x;
   int64_t p;
-  std::vector<int64_t> lp;
-  TS1 context;
+  Lineage lp;
+  const TS1& context;
 };
 struct TsEvent2{
   int64_t t;
   int64_t x;
   int64_t p;
-  std::vector<int64_t> lp;
-  TS2 context;
+  Lineage lp;
+  const TS2& context;
 };
 struct TsEvent3{
   int64_t t;
   int64_t x;
   int64_t p;
-  std::vector<int64_t> lp;
-  TS3 context;
+  Lineage lp;
+  const TS3& context;
 };
 
 double bata1(TS1::iterator beg1, TS1::iterator end1, TS1::iterator beg2);
 double bata2(TS2::iterator beg1, TS2::iterator end1, TS2::iterator beg2);
 double bata3(TS3::iterator beg1, TS3::iterator end1, TS3::iterator beg2);
 
-double kernel1(HotsEvent evRef, HotsEvent evNeighbor);
-double kernel2(HotsEvent evRef, HotsEvent evNeighbor);
-double kernel3(HotsEvent evRef, HotsEvent evNeighbor);
-
 HotsEvent hotsEventFromEvent(Event ev){
-  return HotsEvent{ev.t, ev.x, ev.p, std::vector<int64_t>(1,ev.p)};
+  HotsEvent hev{ev.t, ev.x, ev.p, Lineage()};
+  hev.lp.push_back(ev.p);
+  return hev;
 }
 
 template<typename TsEvent>
-HotsEvent hotsEventFromTsEvent(TsEvent tsEv, int64_t out_p){
+HotsEvent hotsEventFromTsEvent(const TsEvent& tsEv, int64_t out_p){
   HotsEvent hev{tsEv.t, tsEv.x, out_p, tsEv.lp};
   hev.lp.push_back(out_p);
   return hev;
 }
 
 template<typename TsEvent, typename TS>
-TsEvent tsEventFromHotsEvent(HotsEvent hev, TS context){
+TsEvent tsEventFromHotsEvent(const HotsEvent& hev, const TS& context){
   return TsEvent{hev.t, hev.x, hev.p, hev.lp, context};
 }
 
@@ -105,29 +109,63 @@ int main(void){
 
   auto L3 = tarsier::make_iiwkCluster<NC3,CS3,true,false,TsEvent3,HotsEvent>
     (KSI1,KSI2,NPOW,bata3,hotsEventFromTsEvent<TsEvent3>,handlerL3);
-  auto linkL2L3 = tarsier::make_timeSurfaceGenerator<XSIZE, NC2, R3,INIT_MEMORY, HotsEvent, TsEvent3>
-    (kernel3,tsEventFromHotsEvent<TsEvent3, TS3>, L3);
+  // the deeper layers have many polarities, most of them inactive at a given pixel
+  auto linkL2L3 = tarsier::make_sparseTimeSurfaceGenerator<XSIZE, NC2, R3, HotsEvent, TsEvent3>
+    (tarsier::ExponentialDecayKernel(T3, 3*T3),3*T3,tsEventFromHotsEvent<TsEvent3, TS3>, L3);
 
   auto L2 = tarsier::make_iiwkCluster<NC2,CS2,true,false,TsEvent2,HotsEvent>
     (KSI1, KSI2,NPOW,bata2,hotsEventFromTsEvent<TsEvent2>,linkL2L3);
-  auto linkL1L2 = tarsier::make_timeSurfaceGenerator<XSIZE, NC1, R2,INIT_MEMORY, HotsEvent, TsEvent2>
-    (kernel2,tsEventFromHotsEvent<TsEvent2, TS2>, L2);
+  auto linkL1L2 = tarsier::make_sparseTimeSurfaceGenerator<XSIZE, NC1, R2, HotsEvent, TsEvent2>
+    (tarsier::ExponentialDecayKernel(T2, 3*T2),3*T2,tsEventFromHotsEvent<TsEvent2, TS2>, L2);
 
   auto L1 = tarsier::make_iiwkCluster<NC1,CS1,true,false,TsEvent1,HotsEvent>
     (KSI1,KSI2,NPOW,bata1,hotsEventFromTsEvent<TsEvent1>,linkL1L2);
   auto hots = tarsier::make_timeSurfaceGenerator<XSIZE, NP, R1,INIT_MEMORY, HotsEvent, TsEvent1>
-    (kernel1,tsEventFromHotsEvent<TsEvent1, TS1>, L1);
+    (tarsier::ExponentialDecayKernel(T1, 3*T1),tsEventFromHotsEvent<TsEvent1, TS1>, L1);
 
   srand(time(NULL));
   auto Nevents = 1000000;
-  auto start = std::chrono::steady_clock::now();
+  std::vector<Event> events;
   for(auto i = 0; i  < Nevents; i++){
-    hots(hotsEventFromEvent(Event{i*10,rand()%XSIZE,i%2}));
+    events.push_back(Event{i*10,rand()%XSIZE,i%2});
+  }
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    hots(hotsEventFromEvent(ev));
     // standardLayerL(TsEvent{3,std::array<double,TSSIZE>{0.576950, 0.606531, 0.637628, 0.670320, 0.704688, 0.740818, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 0.000000, 1.000000, 0.951229, 0.904837, 0.860708, 0.818731, 0.778801}});
   }
   auto duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
   std::cout << "STD learning\t-> Speed: " << static_cast<double>(Nevents)/(static_cast<double>(duration.count())/1000.) << " evs/secs" << std::endl;
 
+  // the same network with the second and third layers on their own threads
+  // the clusters do not learn and start from the same fixed centers, and each layer sees the events in the same order,
+  // hence the pipelined network assigns the same polarities
+  auto pipelinedL3 = tarsier::make_iiwkCluster<NC3,CS3,true,false,TsEvent3,HotsEvent>
+    (KSI1,KSI2,NPOW,bata3,hotsEventFromTsEvent<TsEvent3>,handlerL3);
+  auto stageL3 = tarsier::make_pipelineStage<HotsEvent>
+    (tarsier::make_sparseTimeSurfaceGenerator<XSIZE, NC2, R3, HotsEvent, TsEvent3>
+     (tarsier::ExponentialDecayKernel(T3, 3*T3),3*T3,tsEventFromHotsEvent<TsEvent3, TS3>, pipelinedL3));
+
+  auto pipelinedL2 = tarsier::make_iiwkCluster<NC2,CS2,true,false,TsEvent2,HotsEvent>
+    (KSI1, KSI2,NPOW,bata2,hotsEventFromTsEvent<TsEvent2>,stageL3);
+  auto stageL2 = tarsier::make_pipelineStage<HotsEvent>
+    (tarsier::make_sparseTimeSurfaceGenerator<XSIZE, NC1, R2, HotsEvent, TsEvent2>
+     (tarsier::ExponentialDecayKernel(T2, 3*T2),3*T2,tsEventFromHotsEvent<TsEvent2, TS2>, pipelinedL2));
+
+  auto pipelinedL1 = tarsier::make_iiwkCluster<NC1,CS1,true,false,TsEvent1,HotsEvent>
+    (KSI1,KSI2,NPOW,bata1,hotsEventFromTsEvent<TsEvent1>,stageL2);
+  auto pipelinedHots = tarsier::make_timeSurfaceGenerator<XSIZE, NP, R1,INIT_MEMORY, HotsEvent, TsEvent1>
+    (tarsier::ExponentialDecayKernel(T1, 3*T1),tsEventFromHotsEvent<TsEvent1, TS1>, pipelinedL1);
+
+  start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    pipelinedHots(hotsEventFromEvent(ev));
+  }
+  stageL2.flush();
+  stageL3.flush();
+  duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+  std::cout << "STD pipelined\t-> Speed: " << static_cast<double>(Nevents)/(static_cast<double>(duration.count())/1000.) << " evs/secs" << std::endl;
+
   return 0;
 }
 
@@ -202,16 +240,3 @@ double bata3(TS3::iterator beg1, TS3::iterator end1, TS3::iterator beg2){
                   );
   return (std::isinf(d)) ? LIM_INF_BATA : (d < LIM_ZERO) ? 0 : d;
 };
-
-double kernel1(HotsEvent evRef, HotsEvent evNeighbor){
-  auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
-  return (diff < 3*T1) ? exp(-(diff)/T1) : 0;
-};
-double kernel2(HotsEvent evRef, HotsEvent evNeighbor){
-  auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
-  return (diff < 3*T2) ? exp(-(diff)/T2) : 0;
-};
-double kernel3(HotsEvent evRef, HotsEvent evNeighbor){
-  auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
-  return (diff < 3*T3) ? exp(-(diff)/T3) : 0;
-};
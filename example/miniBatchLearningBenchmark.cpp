@@ -0,0 +1,68 @@
+#include "../source/hotsBlocs.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// the dimensions of the third layer of hotsMain
+#define NCENTERS 128
+#define NEIGHBORHOOD 416
+#define NEVENTS 20000
+#define MINIBATCH 1024
+
+struct ClusterEvent{
+  std::array<double, NEIGHBORHOOD> context;
+};
+
+/// measure returns the throughput of learn over the events, in events per second
+template<typename Learn>
+double measure(std::vector<ClusterEvent>& events, Learn learn){
+  auto start = std::chrono::steady_clock::now();
+  learn(events.data(), events.data() + events.size());
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(events.size())/(static_cast<double>(duration.count())/1e6);
+}
+
+int main(void){
+  srand(0);
+  std::vector<ClusterEvent> events(NEVENTS);
+  for(auto&& event: events){
+    for(auto&& value: event.context){
+      value = static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  std::array<std::array<double, NEIGHBORHOOD>, NCENTERS> centers;
+  for(auto&& center: centers){
+    for(auto&& value: center){
+      value = static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  int64_t checksum = 0;
+  auto iiwk = tarsier::make_iiwkCluster<NCENTERS, NEIGHBORHOOD, true, true, ClusterEvent, int64_t>(
+    2e-4, 2e-4, 1., centers, tarsier::EuclideanMetric(),
+    [](ClusterEvent, int64_t p){
+      return p;
+    },
+    [&checksum](int64_t p){
+      checksum += p;
+    });
+
+  auto sequential = iiwk;
+  std::cout << "Sequential\t-> Speed: " << measure(events, [&sequential](ClusterEvent* begin, ClusterEvent* end){
+      for(; begin != end; ++begin){
+        sequential(*begin);
+      }
+    }) << " evs/secs" << std::endl;
+
+  const auto maximumThreads = std::max(1u, std::thread::hardware_concurrency());
+  for(std::size_t numberOfThreads = 1; numberOfThreads <= maximumThreads; numberOfThreads *= 2){
+    auto parallel = iiwk;
+    std::cout << numberOfThreads << " thread(s)\t-> Speed: " << measure(events, [&parallel, numberOfThreads](ClusterEvent* begin, ClusterEvent* end){
+        parallel.learn(begin, end, numberOfThreads, MINIBATCH);
+      }) << " evs/secs" << std::endl;
+  }
+  std::cout << "checksum " << checksum << std::endl;
+  return 0;
+}
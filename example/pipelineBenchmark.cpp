@@ -0,0 +1,71 @@
+#include "../source/mirrorX.hpp"
+#include "../source/shiftX.hpp"
+#include "../source/selectRectangle.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#define WIDTH 304
+#define HEIGHT 240
+#define NEVENTS 20000000
+#define REPETITIONS 5
+
+struct Event{
+  uint16_t x;
+  uint16_t y;
+  uint64_t timestamp;
+} __attribute__((packed));
+
+/// benchmark is not inlined, so that the pipeline is only known through a reference
+template<typename Pipeline>
+__attribute__((noinline)) void benchmark(const std::string& name, Pipeline& pipeline, const std::vector<Event>& events, const uint64_t& count){
+  auto start = std::chrono::steady_clock::now();
+  for(auto repetition = 0; repetition < REPETITIONS; repetition++){
+    for(auto&& ev: events){
+      pipeline(ev);
+    }
+  }
+  auto duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+  std::cout << name << "\t-> Speed: " << static_cast<double>(events.size()*REPETITIONS)/(static_cast<double>(duration.count())/1000.) << " evs/secs (checksum " << count << ")" << std::endl;
+}
+
+int main(void){
+  std::vector<Event> events;
+  events.reserve(NEVENTS);
+  srand(0);
+  for(auto i = 0; i < NEVENTS; i++){
+    events.push_back(Event{static_cast<uint16_t>(rand()%WIDTH), static_cast<uint16_t>(rand()%HEIGHT), static_cast<uint64_t>(i)});
+  }
+
+  uint64_t virtualCount = 0;
+  auto virtualPipeline = tarsier::make_mirrorX<Event, WIDTH>(
+    tarsier::make_shiftX<Event, WIDTH, 10>(
+      tarsier::make_selectRectangle<Event, 20, 20, 200, 200>([&virtualCount](Event ev){
+        virtualCount += ev.x;
+      })));
+  benchmark("Per event", virtualPipeline, events, virtualCount);
+
+  uint64_t batchCount = 0;
+  auto batchPipeline = tarsier::make_mirrorX<Event, WIDTH>(
+    tarsier::make_shiftX<Event, WIDTH, 10>(
+      tarsier::make_selectRectangle<Event, 20, 20, 200, 200>([&batchCount](Event ev){
+        batchCount += ev.x;
+      })));
+  // the batch entry point modifies the events in place, hence the copy to a buffer
+  std::vector<Event> buffer(1024);
+  auto start = std::chrono::steady_clock::now();
+  for(auto repetition = 0; repetition < REPETITIONS; repetition++){
+    for(std::size_t i = 0; i < events.size(); i+=buffer.size()){
+      auto end = std::min(i+buffer.size(), events.size());
+      std::copy(events.begin()+i, events.begin()+end, buffer.begin());
+      batchPipeline(buffer.data(), buffer.data()+(end-i));
+    }
+  }
+  auto duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+  std::cout << "Batch\t-> Speed: " << static_cast<double>(events.size()*REPETITIONS)/(static_cast<double>(duration.count())/1000.) << " evs/secs (checksum " << batchCount << ")" << std::endl;
+
+  return 0;
+}
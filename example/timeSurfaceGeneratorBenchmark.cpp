@@ -0,0 +1,109 @@
+#include "../source/timeSurfaceGenerator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// compile with -O3 -march=native to enable the AVX2 approximate kernel
+
+#define NP 2
+#define RADIUS 6
+#define TAU 100.
+#define XSIZE 200
+#define YSIZE 200
+#define INIT_MEMORY -1000
+#define NEVENTS 1000000
+
+#define CONTEXT_SIZE_1D (2*RADIUS+1)*NP
+#define CONTEXT_SIZE_2D (2*RADIUS+1)*(2*RADIUS+1)*NP
+
+struct HotsEvent{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+  std::vector<int64_t> lp;
+};
+
+struct HotsEvent2d{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+  std::vector<int64_t> lp;
+};
+
+/// kernel is the per-event kernel used by hotsMain before the lookup table kernels
+double kernel(HotsEvent evRef, HotsEvent evNeighbor){
+  auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+  return (diff < 3*TAU) ? exp(-(diff)/TAU) : 0;
+}
+
+double kernel2d(HotsEvent2d evRef, HotsEvent2d evNeighbor){
+  auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+  return (diff < 3*TAU) ? exp(-(diff)/TAU) : 0;
+}
+
+template<typename Event, typename TimeSurfaceGenerator>
+double run(TimeSurfaceGenerator& timeSurfaceGenerator, const std::vector<Event>& events){
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    timeSurfaceGenerator(ev);
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return static_cast<double>(events.size())/(static_cast<double>(duration.count())/1e6);
+}
+
+int main(void){
+  srand(0);
+  std::vector<HotsEvent> events;
+  std::vector<HotsEvent2d> events2d;
+  events.reserve(NEVENTS);
+  events2d.reserve(NEVENTS);
+  for(int64_t i = 0; i < NEVENTS; i++){
+    events.push_back(HotsEvent{i*10, rand()%XSIZE, i%NP, std::vector<int64_t>(1, i%NP)});
+    events2d.push_back(HotsEvent2d{i*10, rand()%XSIZE, rand()%YSIZE, i%NP, std::vector<int64_t>(1, i%NP)});
+  }
+
+  double checksum = 0;
+  auto fromEvent1d = [](HotsEvent, std::array<double, CONTEXT_SIZE_1D> context){
+    return context;
+  };
+  auto fromEvent2d = [](HotsEvent2d, std::array<double, CONTEXT_SIZE_2D> context){
+    return context;
+  };
+  auto handler1d = [&checksum](std::array<double, CONTEXT_SIZE_1D> context){
+    checksum += context[RADIUS];
+  };
+  auto handler2d = [&checksum](std::array<double, CONTEXT_SIZE_2D> context){
+    checksum += context[RADIUS];
+  };
+
+  auto eventsKernel1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent, std::array<double, CONTEXT_SIZE_1D>>(
+    kernel, fromEvent1d, handler1d);
+  auto tableKernel1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent, std::array<double, CONTEXT_SIZE_1D>>(
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU), fromEvent1d, handler1d);
+  auto approximateKernel1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent, std::array<double, CONTEXT_SIZE_1D>>(
+    tarsier::ApproximateExponentialDecayKernel(TAU, 3*TAU), fromEvent1d, handler1d);
+  auto eventsKernel2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent2d, std::array<double, CONTEXT_SIZE_2D>>(
+    kernel2d, fromEvent2d, handler2d);
+  auto tableKernel2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent2d, std::array<double, CONTEXT_SIZE_2D>>(
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU), fromEvent2d, handler2d);
+  auto approximateKernel2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS, INIT_MEMORY, HotsEvent2d, std::array<double, CONTEXT_SIZE_2D>>(
+    tarsier::ApproximateExponentialDecayKernel(TAU, 3*TAU), fromEvent2d, handler2d);
+
+  const auto events1dSpeed = run<HotsEvent>(eventsKernel1d, events);
+  const auto table1dSpeed = run<HotsEvent>(tableKernel1d, events);
+  const auto approximate1dSpeed = run<HotsEvent>(approximateKernel1d, events);
+  const auto events2dSpeed = run<HotsEvent2d>(eventsKernel2d, events2d);
+  const auto table2dSpeed = run<HotsEvent2d>(tableKernel2d, events2d);
+  const auto approximate2dSpeed = run<HotsEvent2d>(approximateKernel2d, events2d);
+  std::cout << "1D events kernel\t-> Speed: " << events1dSpeed << " evs/secs" << std::endl;
+  std::cout << "1D table kernel\t\t-> Speed: " << table1dSpeed << " evs/secs (x" << table1dSpeed/events1dSpeed << ")" << std::endl;
+  std::cout << "1D approximate kernel\t-> Speed: " << approximate1dSpeed << " evs/secs (x" << approximate1dSpeed/events1dSpeed << ")" << std::endl;
+  std::cout << "2D events kernel\t-> Speed: " << events2dSpeed << " evs/secs" << std::endl;
+  std::cout << "2D table kernel\t\t-> Speed: " << table2dSpeed << " evs/secs (x" << table2dSpeed/events2dSpeed << ")" << std::endl;
+  std::cout << "2D approximate kernel\t-> Speed: " << approximate2dSpeed << " evs/secs (x" << approximate2dSpeed/events2dSpeed << ")" << std::endl;
+  std::cout << "checksum: " << checksum << std::endl;
+  return 0;
+}
@@ -0,0 +1,69 @@
+#include "../source/timeSurfaceGenerator.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define NP 2
+#define TAU 10000.
+#define INIT_MEMORY -1000000
+#define NEVENTS 200000
+
+struct Event{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+};
+
+/// benchmark measures the context generation throughput for a sensor, a radius and an output order
+template<int64_t X, int64_t Y, int64_t radius, tarsier::ContextOrder order>
+void benchmark(const std::string& name){
+  typedef std::array<double, (2*radius+1)*(2*radius+1)*NP> Context;
+  std::vector<Event> events;
+  events.reserve(NEVENTS);
+  srand(0);
+  for(int64_t i = 0; i < NEVENTS; i++){
+    events.push_back(Event{i*10, rand()%X, rand()%Y, rand()%NP});
+  }
+
+  double checksum = 0;
+  auto fromEvent = [](Event, Context context){
+    return context;
+  };
+  auto handler = [&checksum](Context context){
+    checksum += context[context.size()/2];
+  };
+  auto timeSurfaceGenerator = tarsier::make_timeSurfaceGenerator<X, Y, NP, radius, INIT_MEMORY, Event, Context, order, tarsier::HugePageStorage>(
+    tarsier::ExponentialDecayKernel(TAU, 3*TAU), fromEvent, handler);
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    timeSurfaceGenerator(ev);
+  }
+  auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << X << "x" << Y << "\tradius " << radius << "\t" << name << "\t-> Speed: "
+            << static_cast<double>(NEVENTS)/(static_cast<double>(duration.count())/1e6) << " evs/secs"
+            << " (checksum " << checksum << ")" << std::endl;
+}
+
+template<int64_t X, int64_t Y, int64_t radius>
+void benchmarkOrders(){
+  benchmark<X, Y, radius, tarsier::ContextOrder::polarityMajor>("polarity-major");
+  benchmark<X, Y, radius, tarsier::ContextOrder::pixelMajor>("pixel-major");
+}
+
+template<int64_t X, int64_t Y>
+void benchmarkSensor(){
+  benchmarkOrders<X, Y, 2>();
+  benchmarkOrders<X, Y, 4>();
+  benchmarkOrders<X, Y, 6>();
+  benchmarkOrders<X, Y, 8>();
+}
+
+int main(void){
+  benchmarkSensor<346, 260>();
+  benchmarkSensor<1280, 720>();
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include "../source/trackBlobs.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#define WIDTH 640
+#define HEIGHT 480
+#define NEVENTS 100000
+#define SKIP 1000
+
+struct Event{
+  uint16_t x;
+  uint16_t y;
+  uint64_t timestamp;
+} __attribute__((packed));
+
+/// blobsOnGrid spreads side x side hidden blobs on the sensor
+std::vector<tarsier::Blob> blobsOnGrid(std::size_t side){
+  std::vector<tarsier::Blob> blobs;
+  const auto xSpacing = static_cast<double>(WIDTH)/side;
+  const auto ySpacing = static_cast<double>(HEIGHT)/side;
+  for(std::size_t row = 0; row < side; row++){
+    for(std::size_t column = 0; column < side; column++){
+      blobs.push_back(tarsier::Blob{(column+0.5)*xSpacing, (row+0.5)*ySpacing, std::pow(xSpacing/4, 2), 0, std::pow(ySpacing/4, 2)});
+    }
+  }
+  return blobs;
+}
+
+template<typename WinnerSearch, typename Repulsion>
+void benchmark(const std::string& name, std::size_t side){
+  const auto blobs = blobsOnGrid(side);
+
+  // events are drawn around a few active blobs, so that some of them are promoted and deleted
+  std::vector<Event> events;
+  events.reserve(NEVENTS);
+  srand(0);
+  for(auto i = 0; i < NEVENTS; i++){
+    const auto& blob = blobs[(rand()%8)*(blobs.size()/8) + (i/10000)%(blobs.size()/8)];
+    const auto x = blob.x + (rand()%5 - 2)*std::sqrt(blob.squaredSigmaX)/2;
+    const auto y = blob.y + (rand()%5 - 2)*std::sqrt(blob.squaredSigmaY)/2;
+    events.push_back(Event{
+      static_cast<uint16_t>(std::min(std::max(x, 0.), WIDTH - 1.)),
+      static_cast<uint16_t>(std::min(std::max(y, 0.), HEIGHT - 1.)),
+      static_cast<uint64_t>(i)*10});
+  }
+
+  std::size_t updates = 0;
+  const auto count = [&updates](std::size_t, const tarsier::Blob&){
+    updates++;
+  };
+  auto trackBlobs = tarsier::make_trackBlobs<Event, WinnerSearch, Repulsion>(
+    blobs, 1e3, 1e-6, 0.38, 0.2, 0.9, 0.9, 0.2, WIDTH/side/2., 0.2, WIDTH/side, SKIP,
+    count, count, count, count, count, count, count);
+  auto start = std::chrono::steady_clock::now();
+  for(auto&& ev: events){
+    trackBlobs(ev);
+  }
+  auto duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
+  std::cout << name << " " << side*side << " blobs\t-> Speed: " << static_cast<double>(events.size())/(static_cast<double>(duration.count())/1000.) << " evs/secs (" << updates << " callbacks)" << std::endl;
+}
+
+int main(void){
+  for(auto side: {4, 16, 64}){
+    benchmark<tarsier::ExhaustiveWinnerSearch, tarsier::PairwiseRepulsion>("exhaustive, pairwise", side);
+    benchmark<tarsier::GridWinnerSearch<WIDTH, HEIGHT, 16>, tarsier::CellListRepulsion<5>>("grid, cell list\t", side);
+  }
+  return 0;
+}
@@ -43,8 +43,8 @@ solution 'tarsier'
 
         -- Linux specific settings
         configuration 'linux'
-            buildoptions {'-std=c++11'}
-            linkoptions {'-std=c++11'}
+            buildoptions {'-std=c++11', '-pthread'}
+            linkoptions {'-std=c++11', '-pthread'}
             postbuildcommands {
                 'rm -rf /usr/local/include/tarsier',
                 'mkdir /usr/local/include/tarsier',
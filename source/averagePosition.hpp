@@ -49,6 +49,13 @@ namespace tarsier {
                 }
             }
 
+            /// operator() handles a contiguous range of events.
+            void operator()(const Event* begin, const Event* end) {
+                for (; begin != end; ++begin) {
+                    AveragePosition::operator()(*begin);
+                }
+            }
+
         protected:
             const double _inertia;
             std::size_t _eventsToReceive;
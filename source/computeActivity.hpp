@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <vector>
+#include "forwardEvents.hpp"
 
 namespace tarsier {
 
@@ -36,6 +38,32 @@ public:
   }
 
   virtual void operator()(Event event) {
+    auto forwardActivityEvent = [this](ActivityEvent activityEvent) -> void {
+      forwardEvent(_handleActivityEvent, activityEvent);
+    };
+    compute(event, forwardActivityEvent);
+  }
+
+  /// operator() handles a contiguous range of events, and forwards the
+  /// activity events as a single range
+  void operator()(Event *begin, Event *end) {
+    _activityEvents.clear();
+    auto bufferActivityEvent = [this](ActivityEvent activityEvent) -> void {
+      _activityEvents.push_back(activityEvent);
+    };
+    for (; begin != end; ++begin) {
+      compute(*begin, bufferActivityEvent);
+    }
+    forwardEvents(_handleActivityEvent, _activityEvents.data(),
+                  _activityEvents.data() + _activityEvents.size());
+  }
+
+protected:
+  /// compute updates the activities and sends the activity event to the given
+  /// functor
+  template <typename HandleComputedActivityEvent>
+  void compute(Event event,
+               HandleComputedActivityEvent &handleComputedActivityEvent) {
     _currentTimeStamp = event.timestamp;
     activityIncrease(_activity, _currentTimeStamp, _lastTimeStamp);
     _lastTimeStamp = _currentTimeStamp;
@@ -48,11 +76,10 @@ public:
       activityIncrease(_activityOFF, _currentTimeStamp, _lastTimeStampOFF);
       _lastTimeStampOFF = _currentTimeStamp;
     }
-    _handleActivityEvent(
+    handleComputedActivityEvent(
         _activityEventFromEvent(event, _activity, _activityON, _activityOFF));
   }
 
-protected:
   ActivityEventFromEvent _activityEventFromEvent;
   const uint64_t _lifespan;
   uint64_t _currentTimeStamp;
@@ -63,6 +90,7 @@ protected:
   double _activityOFF;
   uint64_t _lastTimeStampOFF;
   HandleActivityEvent _handleActivityEvent;
+  std::vector<ActivityEvent> _activityEvents;
 };
 
 template <typename Event, typename ActivityEvent, uint64_t lifespan,
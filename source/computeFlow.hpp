@@ -7,11 +7,355 @@
 #include <vector>
 #include <limits>
 #include <algorithm>
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
 
+    /// FitPlane estimates the optical flow from a map of timestamps.
+    /// It fits a plane to the numberOfMostRecentEvents most recent timestamps in a square window around a pixel.
+    /// The candidates are stored in a preallocated scratch buffer, so that estimations do not allocate memory.
+    /// The window scan and the moments accumulation use AVX2 or SSE4.2 when the compiler targets them
+    /// (for example with -march=native), and scalar loops otherwise.
+    template <uint64_t window, std::size_t numberOfMostRecentEvents, uint64_t lifespan>
+    class FitPlane {
+        static_assert(numberOfMostRecentEvents > 0, "numberOfMostRecentEvents must be strictly positive");
+        static_assert(
+            numberOfMostRecentEvents <= (2 * window + 1) * (2 * window + 1),
+            "numberOfMostRecentEvents must be smaller than or equal to the number of pixels in the window"
+        );
+        static_assert(window < 128, "window must be smaller than 128");
+        static_assert(lifespan < (static_cast<uint64_t>(1) << 48), "lifespan must be smaller than 2^48");
+        static_assert(
+            lifespan <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) / (numberOfMostRecentEvents * (window + 1)),
+            "the moments of the time deltas must fit in 64 bits"
+        );
+        public:
+
+            /// operator() estimates the flow at the given pixel and timestamp.
+            /// timestamps must point to a row-major map with the given width and height.
+            /// If the estimation succeeds, vx and vy are set and true is returned.
+            bool operator()(
+                const uint64_t* timestamps,
+                uint64_t width,
+                uint64_t height,
+                uint64_t x,
+                uint64_t y,
+                uint64_t timestamp,
+                double& vx,
+                double& vy
+            ) {
+                const auto xMinimum = (x <= window ? 0 : x - window);
+                const auto xMaximum = (x >= width - 1 - window ? width - 1 : x + window);
+                const auto yMinimum = (y <= window ? 0 : y - window);
+                const auto yMaximum = (y >= height - 1 - window ? height - 1 : y + window);
+                const auto lifespanThreshold = (timestamp <= lifespan ? 0 : timestamp - lifespan);
+
+                // each candidate is packed in a single integer, with the time delta in the high bits
+                // and the position in the window in the low bits, so that the selection compares integers
+                std::size_t size = 0;
+                for (auto yIndex = yMinimum; yIndex <= yMaximum; ++yIndex) {
+                    size = scanRow(
+                        timestamps + yIndex * width,
+                        xMinimum,
+                        xMaximum + 1,
+                        ((yIndex + window - y) << 8) + window - x,
+                        timestamp,
+                        lifespanThreshold,
+                        size
+                    );
+                }
+                if (size < numberOfMostRecentEvents) {
+                    return false;
+                }
+
+                // the most recent candidates are selected with a bounded max-heap
+                if (size > numberOfMostRecentEvents) {
+                    std::make_heap(_candidates.begin(), std::next(_candidates.begin(), numberOfMostRecentEvents));
+                    for (std::size_t index = numberOfMostRecentEvents; index < size; ++index) {
+                        if (_candidates[index] < _candidates.front()) {
+                            std::pop_heap(_candidates.begin(), std::next(_candidates.begin(), numberOfMostRecentEvents));
+                            _candidates[numberOfMostRecentEvents - 1] = _candidates[index];
+                            std::push_heap(_candidates.begin(), std::next(_candidates.begin(), numberOfMostRecentEvents));
+                        }
+                    }
+                }
+                // the time deltas are measured from a selected candidate, which keeps the moments small with old neighbourhoods
+                std::array<int64_t, 8> moments;
+                accumulate(static_cast<int64_t>(_candidates.front() >> positionBits), moments);
+                return solve(moments, vx, vy);
+            }
+
+        protected:
+
+            /// positionBits is the number of bits used to encode a position in the window.
+            /// The x coordinate uses the lowest 8 bits, and the y coordinate the next 8 bits.
+            static constexpr uint64_t positionBits = 16;
+
+            /// padding is the number of extra candidates written past the end by vector stores.
+            static constexpr std::size_t padding = 4;
+
+            /// moment indices in the array filled by accumulate.
+            enum Moment {
+                xSum,
+                ySum,
+                timeDeltaSum,
+                xSquaredSum,
+                ySquaredSum,
+                xySum,
+                xTimeDeltaSum,
+                yTimeDeltaSum,
+            };
+
+            /// scanRowScalar packs the timestamps of [begin, end) younger than the threshold, starting at index size.
+            /// It returns the new number of candidates.
+            std::size_t scanRowScalar(
+                const uint64_t* row,
+                uint64_t begin,
+                uint64_t end,
+                uint64_t position,
+                uint64_t timestamp,
+                uint64_t lifespanThreshold,
+                std::size_t size
+            ) {
+                for (auto xIndex = begin; xIndex < end; ++xIndex) {
+                    _candidates[size] = ((timestamp - row[xIndex]) << positionBits) | (position + xIndex);
+                    size += (row[xIndex] > lifespanThreshold);
+                }
+                return size;
+            }
+
+#if defined(__AVX2__)
+            /// scanRow loads four timestamps at a time, masks the old ones and left-packs the others.
+            std::size_t scanRow(
+                const uint64_t* row,
+                uint64_t begin,
+                uint64_t end,
+                uint64_t position,
+                uint64_t timestamp,
+                uint64_t lifespanThreshold,
+                std::size_t size
+            ) {
+                const auto signBit = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+                const auto threshold = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<int64_t>(lifespanThreshold)), signBit);
+                const auto timestamps = _mm256_set1_epi64x(static_cast<int64_t>(timestamp));
+                auto positions = _mm256_add_epi64(
+                    _mm256_set1_epi64x(static_cast<int64_t>(position + begin)),
+                    _mm256_setr_epi64x(0, 1, 2, 3)
+                );
+                const auto step = _mm256_set1_epi64x(4);
+                auto xIndex = begin;
+                for (; xIndex + 4 <= end; xIndex += 4) {
+                    const auto values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + xIndex));
+                    const auto mask = _mm256_movemask_pd(_mm256_castsi256_pd(
+                        _mm256_cmpgt_epi64(_mm256_xor_si256(values, signBit), threshold)
+                    ));
+                    const auto candidates = _mm256_or_si256(
+                        _mm256_slli_epi64(_mm256_sub_epi64(timestamps, values), positionBits),
+                        positions
+                    );
+                    _mm256_storeu_si256(
+                        reinterpret_cast<__m256i*>(_candidates.data() + size),
+                        _mm256_permutevar8x32_epi32(candidates, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(leftPack(mask))))
+                    );
+                    size += static_cast<std::size_t>(__builtin_popcount(mask));
+                    positions = _mm256_add_epi64(positions, step);
+                }
+                return scanRowScalar(row, xIndex, end, position, timestamp, lifespanThreshold, size);
+            }
+
+            /// leftPack returns the 32-bit lanes permutation which moves the selected 64-bit lanes to the front.
+            static const int32_t* leftPack(int mask) {
+                static const int32_t permutations[16][8] = {
+                    {0, 1, 2, 3, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7}, {2, 3, 0, 1, 4, 5, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7},
+                    {4, 5, 0, 1, 2, 3, 6, 7}, {0, 1, 4, 5, 2, 3, 6, 7}, {2, 3, 4, 5, 0, 1, 6, 7}, {0, 1, 2, 3, 4, 5, 6, 7},
+                    {6, 7, 0, 1, 2, 3, 4, 5}, {0, 1, 6, 7, 2, 3, 4, 5}, {2, 3, 6, 7, 0, 1, 4, 5}, {0, 1, 2, 3, 6, 7, 4, 5},
+                    {4, 5, 6, 7, 0, 1, 2, 3}, {0, 1, 4, 5, 6, 7, 2, 3}, {2, 3, 4, 5, 6, 7, 0, 1}, {0, 1, 2, 3, 4, 5, 6, 7},
+                };
+                return permutations[mask];
+            }
+#elif defined(__SSE4_2__)
+            /// scanRow loads two timestamps at a time, masks the old ones and packs the others.
+            std::size_t scanRow(
+                const uint64_t* row,
+                uint64_t begin,
+                uint64_t end,
+                uint64_t position,
+                uint64_t timestamp,
+                uint64_t lifespanThreshold,
+                std::size_t size
+            ) {
+                const auto signBit = _mm_set1_epi64x(std::numeric_limits<int64_t>::min());
+                const auto threshold = _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(lifespanThreshold)), signBit);
+                const auto timestamps = _mm_set1_epi64x(static_cast<int64_t>(timestamp));
+                auto positions = _mm_add_epi64(
+                    _mm_set1_epi64x(static_cast<int64_t>(position + begin)),
+                    _mm_set_epi64x(1, 0)
+                );
+                const auto step = _mm_set1_epi64x(2);
+                auto xIndex = begin;
+                for (; xIndex + 2 <= end; xIndex += 2) {
+                    const auto values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + xIndex));
+                    const auto mask = _mm_movemask_pd(_mm_castsi128_pd(
+                        _mm_cmpgt_epi64(_mm_xor_si128(values, signBit), threshold)
+                    ));
+                    const auto candidates = _mm_or_si128(
+                        _mm_slli_epi64(_mm_sub_epi64(timestamps, values), positionBits),
+                        positions
+                    );
+                    _candidates[size] = static_cast<uint64_t>(_mm_cvtsi128_si64(candidates));
+                    size += (mask & 1);
+                    _candidates[size] = static_cast<uint64_t>(_mm_extract_epi64(candidates, 1));
+                    size += (mask >> 1);
+                    positions = _mm_add_epi64(positions, step);
+                }
+                return scanRowScalar(row, xIndex, end, position, timestamp, lifespanThreshold, size);
+            }
+#else
+            /// scanRow packs the timestamps of [begin, end) younger than the threshold, starting at index size.
+            std::size_t scanRow(
+                const uint64_t* row,
+                uint64_t begin,
+                uint64_t end,
+                uint64_t position,
+                uint64_t timestamp,
+                uint64_t lifespanThreshold,
+                std::size_t size
+            ) {
+                return scanRowScalar(row, begin, end, position, timestamp, lifespanThreshold, size);
+            }
+#endif
+
+            /// accumulateScalar calculates the raw moments of the selected candidates from the given index on.
+            /// The time deltas are offset by -reference.
+            void accumulateScalar(std::size_t begin, int64_t reference, std::array<int64_t, 8>& moments) const {
+                for (auto index = begin; index < numberOfMostRecentEvents; ++index) {
+                    const auto xDelta = static_cast<int64_t>(_candidates[index] & 0xff) - static_cast<int64_t>(window);
+                    const auto yDelta = static_cast<int64_t>((_candidates[index] >> 8) & 0xff) - static_cast<int64_t>(window);
+                    const auto timeDelta = static_cast<int64_t>(_candidates[index] >> positionBits) - reference;
+                    moments[xSum] += xDelta;
+                    moments[ySum] += yDelta;
+                    moments[timeDeltaSum] += timeDelta;
+                    moments[xSquaredSum] += xDelta * xDelta;
+                    moments[ySquaredSum] += yDelta * yDelta;
+                    moments[xySum] += xDelta * yDelta;
+                    moments[xTimeDeltaSum] += xDelta * timeDelta;
+                    moments[yTimeDeltaSum] += yDelta * timeDelta;
+                }
+            }
+
+#if defined(__AVX2__)
+            /// accumulate calculates the raw moments of the selected candidates, four candidates at a time.
+            /// The 32-bit multiplications require time deltas within (-2^31, 2^31), hence the scalar path for long lifespans.
+            void accumulate(int64_t reference, std::array<int64_t, 8>& moments) const {
+                moments.fill(0);
+                if (lifespan >= (static_cast<uint64_t>(1) << 31)) {
+                    accumulateScalar(0, reference, moments);
+                    return;
+                }
+                const auto byteMask = _mm256_set1_epi64x(0xff);
+                const auto offset = _mm256_set1_epi64x(static_cast<int64_t>(window));
+                const auto references = _mm256_set1_epi64x(reference);
+                __m256i sums[8];
+                std::fill(std::begin(sums), std::end(sums), _mm256_setzero_si256());
+                std::size_t index = 0;
+                for (; index + 4 <= numberOfMostRecentEvents; index += 4) {
+                    const auto candidates = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_candidates.data() + index));
+                    const auto xDeltas = _mm256_sub_epi64(_mm256_and_si256(candidates, byteMask), offset);
+                    const auto yDeltas = _mm256_sub_epi64(_mm256_and_si256(_mm256_srli_epi64(candidates, 8), byteMask), offset);
+                    const auto timeDeltas = _mm256_sub_epi64(_mm256_srli_epi64(candidates, positionBits), references);
+                    sums[xSum] = _mm256_add_epi64(sums[xSum], xDeltas);
+                    sums[ySum] = _mm256_add_epi64(sums[ySum], yDeltas);
+                    sums[timeDeltaSum] = _mm256_add_epi64(sums[timeDeltaSum], timeDeltas);
+                    sums[xSquaredSum] = _mm256_add_epi64(sums[xSquaredSum], _mm256_mul_epi32(xDeltas, xDeltas));
+                    sums[ySquaredSum] = _mm256_add_epi64(sums[ySquaredSum], _mm256_mul_epi32(yDeltas, yDeltas));
+                    sums[xySum] = _mm256_add_epi64(sums[xySum], _mm256_mul_epi32(xDeltas, yDeltas));
+                    sums[xTimeDeltaSum] = _mm256_add_epi64(sums[xTimeDeltaSum], _mm256_mul_epi32(xDeltas, timeDeltas));
+                    sums[yTimeDeltaSum] = _mm256_add_epi64(sums[yTimeDeltaSum], _mm256_mul_epi32(yDeltas, timeDeltas));
+                }
+                for (std::size_t moment = 0; moment < 8; ++moment) {
+                    alignas(32) std::array<int64_t, 4> lanes;
+                    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes.data()), sums[moment]);
+                    moments[moment] = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                }
+                accumulateScalar(index, reference, moments);
+            }
+#elif defined(__SSE4_2__)
+            /// accumulate calculates the raw moments of the selected candidates, two candidates at a time.
+            /// The 32-bit multiplications require time deltas within (-2^31, 2^31), hence the scalar path for long lifespans.
+            void accumulate(int64_t reference, std::array<int64_t, 8>& moments) const {
+                moments.fill(0);
+                if (lifespan >= (static_cast<uint64_t>(1) << 31)) {
+                    accumulateScalar(0, reference, moments);
+                    return;
+                }
+                const auto byteMask = _mm_set1_epi64x(0xff);
+                const auto offset = _mm_set1_epi64x(static_cast<int64_t>(window));
+                const auto references = _mm_set1_epi64x(reference);
+                __m128i sums[8];
+                std::fill(std::begin(sums), std::end(sums), _mm_setzero_si128());
+                std::size_t index = 0;
+                for (; index + 2 <= numberOfMostRecentEvents; index += 2) {
+                    const auto candidates = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_candidates.data() + index));
+                    const auto xDeltas = _mm_sub_epi64(_mm_and_si128(candidates, byteMask), offset);
+                    const auto yDeltas = _mm_sub_epi64(_mm_and_si128(_mm_srli_epi64(candidates, 8), byteMask), offset);
+                    const auto timeDeltas = _mm_sub_epi64(_mm_srli_epi64(candidates, positionBits), references);
+                    sums[xSum] = _mm_add_epi64(sums[xSum], xDeltas);
+                    sums[ySum] = _mm_add_epi64(sums[ySum], yDeltas);
+                    sums[timeDeltaSum] = _mm_add_epi64(sums[timeDeltaSum], timeDeltas);
+                    sums[xSquaredSum] = _mm_add_epi64(sums[xSquaredSum], _mm_mul_epi32(xDeltas, xDeltas));
+                    sums[ySquaredSum] = _mm_add_epi64(sums[ySquaredSum], _mm_mul_epi32(yDeltas, yDeltas));
+                    sums[xySum] = _mm_add_epi64(sums[xySum], _mm_mul_epi32(xDeltas, yDeltas));
+                    sums[xTimeDeltaSum] = _mm_add_epi64(sums[xTimeDeltaSum], _mm_mul_epi32(xDeltas, timeDeltas));
+                    sums[yTimeDeltaSum] = _mm_add_epi64(sums[yTimeDeltaSum], _mm_mul_epi32(yDeltas, timeDeltas));
+                }
+                for (std::size_t moment = 0; moment < 8; ++moment) {
+                    moments[moment] = _mm_cvtsi128_si64(sums[moment]) + _mm_extract_epi64(sums[moment], 1);
+                }
+                accumulateScalar(index, reference, moments);
+            }
+#else
+            /// accumulate calculates the raw moments of the selected candidates.
+            void accumulate(int64_t reference, std::array<int64_t, 8>& moments) const {
+                moments.fill(0);
+                accumulateScalar(0, reference, moments);
+            }
+#endif
+
+            /// solve calculates the flow from the raw moments of the selected candidates.
+            /// The centered sums are calculated in double precision, since the products of the moments may overflow 64-bit integers.
+            static bool solve(const std::array<int64_t, 8>& moments, double& vx, double& vy) {
+                const auto count = static_cast<double>(numberOfMostRecentEvents);
+                const auto moment = [&moments](Moment index) {
+                    return static_cast<double>(moments[index]);
+                };
+                const auto xCenteredSquaredSum = moment(xSquaredSum) - moment(xSum) * moment(xSum) / count;
+                const auto yCenteredSquaredSum = moment(ySquaredSum) - moment(ySum) * moment(ySum) / count;
+                const auto xyCenteredSum = moment(xySum) - moment(xSum) * moment(ySum) / count;
+                const auto xTimeDeltaCenteredSum = moment(xTimeDeltaSum) - moment(xSum) * moment(timeDeltaSum) / count;
+                const auto yTimeDeltaCenteredSum = moment(yTimeDeltaSum) - moment(ySum) * moment(timeDeltaSum) / count;
+                const auto determinant = xCenteredSquaredSum * yCenteredSquaredSum - xyCenteredSum * xyCenteredSum;
+                if (std::abs(determinant) > 1) {
+                    const auto xCoefficient = (xTimeDeltaCenteredSum * yCenteredSquaredSum - yTimeDeltaCenteredSum * xyCenteredSum) / determinant;
+                    const auto yCoefficient = (yTimeDeltaCenteredSum * xCenteredSquaredSum - xTimeDeltaCenteredSum * xyCenteredSum) / determinant;
+                    const auto invertedSquaredCoefficientsSum = 1.0 / (xCoefficient * xCoefficient + yCoefficient * yCoefficient);
+                    if (invertedSquaredCoefficientsSum > 1e-10 && invertedSquaredCoefficientsSum < 4e-6) {
+                        vx = -xCoefficient * invertedSquaredCoefficientsSum;
+                        vy = -yCoefficient * invertedSquaredCoefficientsSum;
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            std::array<uint64_t, (2 * window + 1) * (2 * window + 1) + padding> _candidates;
+    };
+
     /// ComputeFlow evaluates the optical flow.
+    /// Only the numberOfMostRecentEvents most recent events in the window around each event are used.
     template <
         typename Event,
         typename FlowEvent,
@@ -39,75 +383,43 @@ namespace tarsier {
 
             /// operator() handles an event.
             virtual void operator()(Event event) {
-                _timestamps[event.x + event.y * width] = event.timestamp;
-                const auto lifespanThreshold = (event.timestamp <= lifespan ? 0 : event.timestamp - lifespan);
-                auto mostRecentXsAndYsAndTimeDeltas = std::vector<std::array<double, 3>>{};
-                mostRecentXsAndYsAndTimeDeltas.reserve(window * window);
-                for (uint64_t x = (event.x <= window ? 0 : event.x - window); x <= (event.x >= width - 1 - window ? width - 1 : event.x + window); ++x) {
-                    for (uint64_t y = (event.y <= window ? 0 : event.y - window); y <= (event.y >= height - 1 - window ? height - 1 : event.y + window); ++y) {
-                        const auto& timestamp = _timestamps[x + y * width];
-                        if (timestamp > lifespanThreshold) {
-                            mostRecentXsAndYsAndTimeDeltas.push_back({{
-                                static_cast<double>(x),
-                                static_cast<double>(y),
-                                static_cast<double>(event.timestamp - timestamp),
-                            }});
-                        }
-                    }
-                }
-                if (mostRecentXsAndYsAndTimeDeltas.size() >= numberOfMostRecentEvents) {
-                    std::sort(mostRecentXsAndYsAndTimeDeltas.begin(), mostRecentXsAndYsAndTimeDeltas.end());
-                    auto xMean = 0.0;
-                    auto yMean = 0.0;
-                    auto timeDeltaMean = 0.0;
-                    for (
-                        auto mostRecentXAndYAndTimeDeltaIterator = mostRecentXsAndYsAndTimeDeltas.begin();
-                        mostRecentXAndYAndTimeDeltaIterator != std::next(mostRecentXsAndYsAndTimeDeltas.begin(), numberOfMostRecentEvents);
-                        ++ mostRecentXAndYAndTimeDeltaIterator
-                    ) {
-                        xMean += std::get<0>(*mostRecentXAndYAndTimeDeltaIterator) / numberOfMostRecentEvents;
-                        yMean += std::get<1>(*mostRecentXAndYAndTimeDeltaIterator) / numberOfMostRecentEvents;
-                        timeDeltaMean += std::get<2>(*mostRecentXAndYAndTimeDeltaIterator) / numberOfMostRecentEvents;
-                    }
-                    auto xSquaredSum = 0.0;
-                    auto ySquaredSum = 0.0;
-                    auto xySum = 0.0;
-                    auto xTimeDeltaSum = 0.0;
-                    auto yTimeDeltaSum = 0.0;
-                    for (
-                        auto mostRecentXAndYAndTimeDeltaIterator = mostRecentXsAndYsAndTimeDeltas.begin();
-                        mostRecentXAndYAndTimeDeltaIterator != std::next(mostRecentXsAndYsAndTimeDeltas.begin(), numberOfMostRecentEvents);
-                        ++ mostRecentXAndYAndTimeDeltaIterator
-                    ) {
-                        const auto xDelta = std::get<0>(*mostRecentXAndYAndTimeDeltaIterator) - xMean;
-                        const auto yDelta = std::get<1>(*mostRecentXAndYAndTimeDeltaIterator) - yMean;
-                        const auto timeDeltaDelta = std::get<2>(*mostRecentXAndYAndTimeDeltaIterator) - timeDeltaMean;
-                        xSquaredSum += std::pow(xDelta, 2);
-                        ySquaredSum += std::pow(yDelta, 2);
-                        xySum += xDelta * yDelta;
-                        xTimeDeltaSum += xDelta * timeDeltaDelta;
-                        yTimeDeltaSum += yDelta * timeDeltaDelta;
-                    }
-                    const auto determinant = xSquaredSum * ySquaredSum - std::pow(xySum, 2);
-                    if (std::abs(determinant) > 1) {
-                        const auto xCoefficient = (xTimeDeltaSum * ySquaredSum - yTimeDeltaSum * xySum) / determinant;
-                        const auto yCoefficient = (yTimeDeltaSum * xSquaredSum - xTimeDeltaSum * xySum) / determinant;
-                        const auto invertedSquaredCoefficientsSum = 1.0 / (std::pow(xCoefficient, 2) + std::pow(yCoefficient, 2));
-                        if (invertedSquaredCoefficientsSum > 1e-10 && invertedSquaredCoefficientsSum < 4e-6) {
-                            _handleFlowEvent(_flowEventFromEvent(
-                                event,
-                                -xCoefficient * invertedSquaredCoefficientsSum,
-                                -yCoefficient * invertedSquaredCoefficientsSum
-                            ));
-                        }
-                    }
+                auto forwardFlowEvent = [this](FlowEvent flowEvent) -> void {
+                    forwardEvent(_handleFlowEvent, flowEvent);
+                };
+                compute(event, forwardFlowEvent);
+            }
+
+            /// operator() handles a contiguous range of events.
+            /// The flow events are buffered and forwarded as a single range.
+            void operator()(Event* begin, Event* end) {
+                _flowEvents.clear();
+                auto bufferFlowEvent = [this](FlowEvent flowEvent) -> void {
+                    _flowEvents.push_back(flowEvent);
+                };
+                for (; begin != end; ++begin) {
+                    compute(*begin, bufferFlowEvent);
                 }
+                forwardEvents(_handleFlowEvent, _flowEvents.data(), _flowEvents.data() + _flowEvents.size());
             }
 
         protected:
+
+            /// compute updates the timestamps and sends the flow event, if any, to the given functor.
+            template <typename HandleComputedFlowEvent>
+            void compute(Event event, HandleComputedFlowEvent& handleComputedFlowEvent) {
+                _timestamps[event.x + event.y * width] = event.timestamp;
+                auto vx = 0.0;
+                auto vy = 0.0;
+                if (_fitPlane(_timestamps.data(), width, height, event.x, event.y, event.timestamp, vx, vy)) {
+                    handleComputedFlowEvent(_flowEventFromEvent(event, vx, vy));
+                }
+            }
+
             FlowEventFromEvent _flowEventFromEvent;
             HandleFlowEvent _handleFlowEvent;
             std::vector<uint64_t> _timestamps;
+            FitPlane<window, numberOfMostRecentEvents, lifespan> _fitPlane;
+            std::vector<FlowEvent> _flowEvents;
     };
 
     /// make_computeFlow creates an optical flow estimator from functors.
@@ -0,0 +1,599 @@
+#pragma once
+
+#include "dynamicTimeSurfaceGenerator.hpp"
+#include "hotsBlocs.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+  /// DynamicIiwkCluster is an IiwkCluster whose number of centers and neighborhood are given at runtime
+  /// The centers are stored contiguously (center-major) in an aligned heap buffer, along with their normalized copies which only change with learning.
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event, // require at least a field .context, with contiguous values accessible with operator[]
+    typename IiwkClusterEvent,
+    typename IiwkClusterMetric, // double f(const double* center begin, const double* center end, const double* context begin), or a metric accepting a center matrix (see AcceptsCenterMatrix)
+    typename IiwkClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity)
+    typename HandlerIiwkCluster // void f(IiwkClusterEvent)
+    >
+  class DynamicIiwkCluster{
+  public:
+    DynamicIiwkCluster(std::size_t nCenters,
+                       std::size_t neighborhood,
+                       double ksi1,
+                       double ksi2,
+                       double npow,
+                       IiwkClusterMetric iiwkClusterMetric,
+                       IiwkClusterEventFromEvent iiwkClusterEventFromEvent,
+                       HandlerIiwkCluster handlerIiwkCluster):
+      _nCenters(nCenters),
+      _neighborhood(neighborhood),
+      _ksi1(ksi1),
+      _ksi2(ksi2),
+      _npow(npow),
+      _sumOfDistances(0.),
+      _iiwkClusterMetric(std::forward<IiwkClusterMetric>(iiwkClusterMetric)),
+      _iiwkClusterEventFromEvent(std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent)),
+      _handlerIiwkCluster(std::forward<HandlerIiwkCluster>(handlerIiwkCluster)),
+      _centers(nCenters*neighborhood, 0.5),
+      _distances(nCenters, 0.),
+      _sumOfCenters(nCenters, 0.5*neighborhood),
+      _normalizedCenters(nCenters*neighborhood),
+      _context(neighborhood)
+    {
+      if(nCenters == 0 || neighborhood == 0){
+        throw std::logic_error("the number of centers and the neighborhood must be strictly positive");
+      }
+      for(std::size_t i = 0; i < _nCenters; i++){
+        refresh(i);
+      }
+    }
+
+    /// The centers are given center-major, as nCenters x neighborhood values
+    DynamicIiwkCluster(std::size_t nCenters,
+                       std::size_t neighborhood,
+                       double ksi1,
+                       double ksi2,
+                       double npow,
+                       const std::vector<double>& centers,
+                       IiwkClusterMetric iiwkClusterMetric,
+                       IiwkClusterEventFromEvent iiwkClusterEventFromEvent,
+                       HandlerIiwkCluster handlerIiwkCluster):
+      DynamicIiwkCluster(nCenters,
+                         neighborhood,
+                         ksi1,
+                         ksi2,
+                         npow,
+                         std::forward<IiwkClusterMetric>(iiwkClusterMetric),
+                         std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent),
+                         std::forward<HandlerIiwkCluster>(handlerIiwkCluster))
+    {
+      if(centers.size() != _centers.size()){
+        throw std::logic_error("the centers must contain nCenters x neighborhood values");
+      }
+      std::copy(centers.begin(), centers.end(), _centers.begin());
+      for(std::size_t i = 0; i < _nCenters; i++){
+        _sumOfCenters[i] = std::accumulate(_centers.begin() + i*_neighborhood, _centers.begin() + (i + 1)*_neighborhood, 0.);
+        refresh(i);
+      }
+    }
+
+    virtual ~DynamicIiwkCluster(){}
+
+    /// getCenters returns the centers, center-major
+    virtual const DynamicBuffer<double>& getCenters() const{
+      return _centers;
+    }
+
+    virtual void operator()(Event ev){
+      /// Cluster
+      auto minimum = std::numeric_limits<double>::infinity();
+      int64_t out_p = 0;
+      _sumOfDistances = 0.;
+
+      normalizedDistances(&ev.context[0]);
+      for(std::size_t i = 0; i < _nCenters; i++){
+        if(i == 0 || minimum > _distances[i]){
+          minimum = _distances[i];
+          out_p = i;
+        }
+        _sumOfDistances+=_distances[i];
+      }
+
+      /// Update
+      if(isLearning){
+        if(minimum != 0){
+          double coeff = _ksi1*(
+                                (_npow+1)*std::pow(minimum,_npow-1)
+                                +_npow*std::pow(minimum, _npow-2)*(_sumOfDistances-minimum)
+                                );
+          coeff = (coeff > 1) ? 1: coeff;
+          double curCoeff;
+
+          for(std::size_t i = 0; i < _nCenters; i++){
+            if(static_cast<int64_t>(i) != out_p){
+              curCoeff = _ksi2*std::pow(minimum,_npow)/_distances[i];
+            }else{
+              curCoeff = coeff;
+            }
+            if(normalize){
+              _sumOfCenters[i] = 0.;
+            }
+            auto center = _centers.data() + i*_neighborhood;
+            for(std::size_t j = 0; j < _neighborhood; j++){
+              auto& it = center[j];
+              it+=curCoeff*(ev.context[j]-it);
+              if(it <= 0){
+                it = 0;
+              }else{
+                if(it > 1){
+                  it = 1;
+                }
+              }
+              if(normalize){
+                _sumOfCenters[i]+=it;
+              }
+            }
+            refresh(i);
+          }
+        }
+      }
+
+      /// Send
+      _handlerIiwkCluster(_iiwkClusterEventFromEvent(std::move(ev), out_p));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        DynamicIiwkCluster::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// refresh updates the normalized copy of a center, which only changes with learning
+    void refresh(std::size_t i){
+      const auto center = _centers.data() + i*_neighborhood;
+      const auto normalizedCenter = _normalizedCenters.data() + i*_neighborhood;
+      for(std::size_t j = 0; j < _neighborhood; j++){
+        normalizedCenter[j] = normalize ? center[j]/_sumOfCenters[i] : center[j];
+      }
+    }
+
+    /// normalizedDistances divides the context by its sum before calling the metric
+    void normalizedDistances(const double* context){
+      if(normalize){
+        std::copy(context, context + _neighborhood, _context.begin());
+        const auto sumOfContext = std::accumulate(_context.begin(), _context.end(), 0.);
+        for(auto&& it: _context){
+          it/=sumOfContext;
+        }
+        context = _context.data();
+      }
+      distances(context, typename AcceptsCenterMatrix<IiwkClusterMetric, double>::type());
+    }
+
+    /// distances computes the distances to every center in one pass
+    void distances(const double* context, std::true_type){
+      _iiwkClusterMetric(_normalizedCenters.data(), _nCenters, _neighborhood, context, _distances.data());
+    }
+
+    /// distances calls the metric once per center
+    void distances(const double* context, std::false_type){
+      for(std::size_t i = 0; i < _nCenters; i++){
+        const auto center = _normalizedCenters.data() + i*_neighborhood;
+        _distances[i] = _iiwkClusterMetric(center, center + _neighborhood, context);
+      }
+    }
+
+    const std::size_t _nCenters;
+    const std::size_t _neighborhood;
+    double _ksi1;
+    double _ksi2;
+    double _npow;
+    double _sumOfDistances;
+    IiwkClusterMetric _iiwkClusterMetric;
+    IiwkClusterEventFromEvent _iiwkClusterEventFromEvent;
+    HandlerIiwkCluster _handlerIiwkCluster;
+
+    DynamicBuffer<double> _centers;
+    DynamicBuffer<double> _distances;
+    DynamicBuffer<double> _sumOfCenters;
+    DynamicBuffer<double> _normalizedCenters;
+    DynamicBuffer<double> _context;
+  };
+
+  //------------------------------------------------------------------------------------------
+  /// DynamicStdCluster
+
+  /// DynamicStdCluster is a StdCluster whose number of centers and neighborhood are given at runtime
+  /// The centers are stored contiguously (center-major) in an aligned heap buffer, along with their normalized copies which only change with learning.
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event, // require at least a field .context, with contiguous values accessible with operator[]
+    typename StdClusterEvent,
+    typename StdClusterMetric, // double f(const double* center begin, const double* center end, const double* context begin), or a metric accepting a center matrix (see AcceptsCenterMatrix)
+    typename StdClusterEventFromEvent, // StdClusterEvent f(Event,out_polarity)
+    typename HandlerStdCluster // void f(StdClusterEvent)
+    >
+  class DynamicStdCluster{
+  public:
+    DynamicStdCluster(std::size_t nCenters,
+                      std::size_t neighborhood,
+                      double baseLearningRate,
+                      double baseLearningActivity,
+                      StdClusterMetric stdClusterMetric,
+                      StdClusterEventFromEvent stdClusterEventFromEvent,
+                      HandlerStdCluster handlerStdCluster):
+      _nCenters(nCenters),
+      _neighborhood(neighborhood),
+      _baseLearningRate(baseLearningRate),
+      _baseLearningActivity(baseLearningActivity),
+      _stdClusterMetric(std::forward<StdClusterMetric>(stdClusterMetric)),
+      _stdClusterEventFromEvent(std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent)),
+      _handlerStdCluster(std::forward<HandlerStdCluster>(handlerStdCluster)),
+      _centers(nCenters*neighborhood, 0.5),
+      _distances(nCenters, 0.),
+      _sumOfCenters(nCenters, 0.5*neighborhood),
+      _activity(nCenters, 0),
+      _normalizedCenters(nCenters*neighborhood),
+      _context(neighborhood),
+      _first(0)
+    {
+      if(nCenters == 0 || neighborhood == 0){
+        throw std::logic_error("the number of centers and the neighborhood must be strictly positive");
+      }
+      for(std::size_t i = 0; i < _nCenters; i++){
+        refresh(i);
+      }
+    }
+
+    /// The centers are given center-major, as nCenters x neighborhood values
+    DynamicStdCluster(std::size_t nCenters,
+                      std::size_t neighborhood,
+                      double baseLearningRate,
+                      double baseLearningActivity,
+                      const std::vector<double>& centers,
+                      StdClusterMetric stdClusterMetric,
+                      StdClusterEventFromEvent stdClusterEventFromEvent,
+                      HandlerStdCluster handlerStdCluster):
+      DynamicStdCluster(nCenters,
+                        neighborhood,
+                        baseLearningRate,
+                        baseLearningActivity,
+                        std::forward<StdClusterMetric>(stdClusterMetric),
+                        std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent),
+                        std::forward<HandlerStdCluster>(handlerStdCluster))
+    {
+      if(centers.size() != _centers.size()){
+        throw std::logic_error("the centers must contain nCenters x neighborhood values");
+      }
+      std::copy(centers.begin(), centers.end(), _centers.begin());
+      for(std::size_t i = 0; i < _nCenters; i++){
+        _sumOfCenters[i] = std::accumulate(_centers.begin() + i*_neighborhood, _centers.begin() + (i + 1)*_neighborhood, 0.);
+        refresh(i);
+      }
+    }
+
+    virtual ~DynamicStdCluster() {}
+
+    /// getCenters returns the centers, center-major
+    virtual const DynamicBuffer<double>& getCenters() const{
+      return _centers;
+    }
+
+    virtual void operator()(Event ev){
+      /// Cluster
+      auto minimum = std::numeric_limits<double>::infinity();
+      int64_t out_p = 0;
+
+      if(isLearning == false || _first >= _nCenters){
+        normalizedDistances(&ev.context[0]);
+        for(std::size_t i = 0; i < _nCenters; i++){
+          if(i == 0 || minimum > _distances[i]){
+            minimum = _distances[i];
+            out_p = i;
+          }
+        }
+
+        _activity[out_p]++;
+        /// Update
+        if(isLearning){
+          auto center = _centers.data() + out_p*_neighborhood;
+          auto scal_prod = 0., scal_context = 0., scal_center = 0.;
+          for(std::size_t j = 0; j < _neighborhood; j++){
+            scal_prod+=(center[j]*ev.context[j]);
+            scal_center+=(center[j]*center[j]);
+            scal_context+=(ev.context[j]*ev.context[j]);
+          }
+          auto beta = scal_prod / sqrt(scal_center*scal_context);
+          auto alpha = _baseLearningRate * (1 - _activity[out_p]/_baseLearningActivity);
+          alpha = (alpha > 0.) ? alpha : 0.;
+
+          if(normalize){
+            _sumOfCenters[out_p] = 0.;
+          }
+          for(std::size_t j = 0; j < _neighborhood; j++){
+            auto& it = center[j];
+            it+=alpha*beta*(ev.context[j]-it);
+            if(it < 0){
+              it = 0;
+            }else{
+              if(it > 1){
+                it = 1;
+              }
+              if(normalize){
+                _sumOfCenters[out_p]+=it;
+              }
+            }
+          }
+          refresh(out_p);
+        }
+      }else{
+        out_p = _first++;
+        auto center = _centers.data() + out_p*_neighborhood;
+        _sumOfCenters[out_p] = 0.;
+        for(std::size_t j = 0; j < _neighborhood; j++){
+          center[j] = ev.context[j];
+          _sumOfCenters[out_p]+=center[j];
+        }
+        refresh(out_p);
+      }
+
+      /// Send
+      _handlerStdCluster(_stdClusterEventFromEvent(std::move(ev), out_p));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        DynamicStdCluster::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// refresh updates the normalized copy of a center, which only changes with learning
+    void refresh(std::size_t i){
+      const auto center = _centers.data() + i*_neighborhood;
+      const auto normalizedCenter = _normalizedCenters.data() + i*_neighborhood;
+      for(std::size_t j = 0; j < _neighborhood; j++){
+        normalizedCenter[j] = normalize ? center[j]/_sumOfCenters[i] : center[j];
+      }
+    }
+
+    /// normalizedDistances divides the context by its sum before calling the metric
+    void normalizedDistances(const double* context){
+      if(normalize){
+        std::copy(context, context + _neighborhood, _context.begin());
+        const auto sumOfContext = std::accumulate(_context.begin(), _context.end(), 0.);
+        for(auto&& it: _context){
+          it/=sumOfContext;
+        }
+        context = _context.data();
+      }
+      distances(context, typename AcceptsCenterMatrix<StdClusterMetric, double>::type());
+    }
+
+    /// distances computes the distances to every center in one pass
+    void distances(const double* context, std::true_type){
+      _stdClusterMetric(_normalizedCenters.data(), _nCenters, _neighborhood, context, _distances.data());
+    }
+
+    /// distances calls the metric once per center
+    void distances(const double* context, std::false_type){
+      for(std::size_t i = 0; i < _nCenters; i++){
+        const auto center = _normalizedCenters.data() + i*_neighborhood;
+        _distances[i] = _stdClusterMetric(center, center + _neighborhood, context);
+      }
+    }
+
+    const std::size_t _nCenters;
+    const std::size_t _neighborhood;
+    double _baseLearningRate;
+    double _baseLearningActivity;
+    StdClusterMetric _stdClusterMetric;
+    StdClusterEventFromEvent _stdClusterEventFromEvent;
+    HandlerStdCluster _handlerStdCluster;
+
+    DynamicBuffer<double> _centers;
+    DynamicBuffer<double> _distances;
+    DynamicBuffer<double> _sumOfCenters;
+    DynamicBuffer<int64_t> _activity;
+    DynamicBuffer<double> _normalizedCenters;
+    DynamicBuffer<double> _context;
+    std::size_t _first;
+  };
+
+  //------------------------------------------------------------------------------------------
+  /// make_dynamicIiwkCluster
+
+  /// Contructor without centers
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event,
+    typename IiwkClusterEvent,
+    typename IiwkClusterMetric,
+    typename IiwkClusterEventFromEvent,
+    typename HandlerIiwkCluster
+    >
+  DynamicIiwkCluster<normalize,
+                     isLearning,
+                     Event,
+                     IiwkClusterEvent,
+                     IiwkClusterMetric,
+                     IiwkClusterEventFromEvent,
+                     HandlerIiwkCluster>
+  make_dynamicIiwkCluster(std::size_t nCenters,
+                          std::size_t neighborhood,
+                          double ksi1,
+                          double ksi2,
+                          double npow,
+                          IiwkClusterMetric iiwkClusterMetric,
+                          IiwkClusterEventFromEvent iiwkClusterEventFromEvent,
+                          HandlerIiwkCluster handlerIiwkCluster)
+  {
+    return DynamicIiwkCluster<normalize,
+                              isLearning,
+                              Event,
+                              IiwkClusterEvent,
+                              IiwkClusterMetric,
+                              IiwkClusterEventFromEvent,
+                              HandlerIiwkCluster>
+      (nCenters,
+       neighborhood,
+       ksi1,
+       ksi2,
+       npow,
+       std::forward<IiwkClusterMetric>(iiwkClusterMetric),
+       std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent),
+       std::forward<HandlerIiwkCluster>(handlerIiwkCluster)
+       );
+  }
+
+  /// Contructor with centers
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event,
+    typename IiwkClusterEvent,
+    typename IiwkClusterMetric,
+    typename IiwkClusterEventFromEvent,
+    typename HandlerIiwkCluster
+    >
+  DynamicIiwkCluster<normalize,
+                     isLearning,
+                     Event,
+                     IiwkClusterEvent,
+                     IiwkClusterMetric,
+                     IiwkClusterEventFromEvent,
+                     HandlerIiwkCluster>
+  make_dynamicIiwkCluster(std::size_t nCenters,
+                          std::size_t neighborhood,
+                          double ksi1,
+                          double ksi2,
+                          double npow,
+                          const std::vector<double>& centers,
+                          IiwkClusterMetric iiwkClusterMetric,
+                          IiwkClusterEventFromEvent iiwkClusterEventFromEvent,
+                          HandlerIiwkCluster handlerIiwkCluster)
+  {
+    return DynamicIiwkCluster<normalize,
+                              isLearning,
+                              Event,
+                              IiwkClusterEvent,
+                              IiwkClusterMetric,
+                              IiwkClusterEventFromEvent,
+                              HandlerIiwkCluster>
+      (nCenters,
+       neighborhood,
+       ksi1,
+       ksi2,
+       npow,
+       centers,
+       std::forward<IiwkClusterMetric>(iiwkClusterMetric),
+       std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent),
+       std::forward<HandlerIiwkCluster>(handlerIiwkCluster)
+       );
+  }
+
+  //------------------------------------------------------------------------------------------
+  /// make_dynamicStdCluster
+
+  /// Contructor without centers
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event,
+    typename StdClusterEvent,
+    typename StdClusterMetric,
+    typename StdClusterEventFromEvent,
+    typename HandlerStdCluster
+    >
+  DynamicStdCluster<normalize,
+                    isLearning,
+                    Event,
+                    StdClusterEvent,
+                    StdClusterMetric,
+                    StdClusterEventFromEvent,
+                    HandlerStdCluster>
+  make_dynamicStdCluster(std::size_t nCenters,
+                         std::size_t neighborhood,
+                         double baseLearningRate,
+                         double baseLearningActivity,
+                         StdClusterMetric stdClusterMetric,
+                         StdClusterEventFromEvent stdClusterEventFromEvent,
+                         HandlerStdCluster handlerStdCluster)
+  {
+    return DynamicStdCluster<normalize,
+                             isLearning,
+                             Event,
+                             StdClusterEvent,
+                             StdClusterMetric,
+                             StdClusterEventFromEvent,
+                             HandlerStdCluster>
+      (nCenters,
+       neighborhood,
+       baseLearningRate,
+       baseLearningActivity,
+       std::forward<StdClusterMetric>(stdClusterMetric),
+       std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent),
+       std::forward<HandlerStdCluster>(handlerStdCluster)
+       );
+  }
+
+  /// Contructor with centers
+  template<
+    bool normalize,
+    bool isLearning,
+    typename Event,
+    typename StdClusterEvent,
+    typename StdClusterMetric,
+    typename StdClusterEventFromEvent,
+    typename HandlerStdCluster
+    >
+  DynamicStdCluster<normalize,
+                    isLearning,
+                    Event,
+                    StdClusterEvent,
+                    StdClusterMetric,
+                    StdClusterEventFromEvent,
+                    HandlerStdCluster>
+  make_dynamicStdCluster(std::size_t nCenters,
+                         std::size_t neighborhood,
+                         double baseLearningRate,
+                         double baseLearningActivity,
+                         const std::vector<double>& centers,
+                         StdClusterMetric stdClusterMetric,
+                         StdClusterEventFromEvent stdClusterEventFromEvent,
+                         HandlerStdCluster handlerStdCluster)
+  {
+    return DynamicStdCluster<normalize,
+                             isLearning,
+                             Event,
+                             StdClusterEvent,
+                             StdClusterMetric,
+                             StdClusterEventFromEvent,
+                             HandlerStdCluster>
+      (nCenters,
+       neighborhood,
+       baseLearningRate,
+       baseLearningActivity,
+       centers,
+       std::forward<StdClusterMetric>(stdClusterMetric),
+       std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent),
+       std::forward<HandlerStdCluster>(handlerStdCluster)
+       );
+  }
+};
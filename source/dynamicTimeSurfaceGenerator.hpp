@@ -0,0 +1,396 @@
+#pragma once
+
+#include "timeSurfaceGenerator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+  /// DynamicBuffer is a heap buffer aligned on cache lines
+  template<typename T>
+  using DynamicBuffer = std::vector<T, AlignedAllocator<T, 64>>;
+
+  /// Generic DynamicTimeSurfaceGenerator, pure virtual
+  /// The sizes are given at runtime, so that a single binary can serve several sensors.
+  /// The context handed to TimeSurfaceEventFromEvent is a reference to an internal buffer,
+  /// which is overwritten by the next event.
+  template<
+    typename Event,
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const DynamicBuffer<double>&)
+    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    >
+  class DynamicTimeSurfaceGenerator{
+  public:
+    DynamicTimeSurfaceGenerator(int64_t memorySize,
+                                int64_t contextSize,
+                                int64_t initMemory,
+                                Kernel kernel,
+                                TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      _kernel(std::forward<Kernel>(kernel)),
+      _timeSurfaceEventFromEvent(std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent)),
+      _handlerTimeSurfaceGenerator(std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)),
+      _memory(memorySize, initMemory),
+      _context(contextSize, 0.)
+    {}
+
+    virtual ~DynamicTimeSurfaceGenerator(){}
+
+    virtual void operator()(Event ev)=0;
+
+    /// contextSize returns the number of values in a context
+    std::size_t contextSize() const {
+      return _context.size();
+    }
+
+  protected:
+    /// kernel evaluates a timestamps kernel, without building the neighbor event
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::true_type, Coordinates...){
+      return _kernel(static_cast<int64_t>(ev.t), neighborTimestamp);
+    }
+
+    /// kernel evaluates an events kernel
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::false_type, Coordinates... coordinates){
+      return _kernel(ev, Event{neighborTimestamp, coordinates...});
+    }
+
+    Kernel _kernel;
+    TimeSurfaceEventFromEvent _timeSurfaceEventFromEvent;
+    HandlerTimeSurfaceGenerator _handlerTimeSurfaceGenerator;
+
+    DynamicBuffer<int64_t> _memory;
+    DynamicBuffer<double> _context;
+  };
+
+  /// 1D DynamicTimeSurfaceGenerator, whose contexts are laid out as the TimeSurfaceGenerator1D ones
+  template<
+    typename Event, // require at least a field .t .x .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const DynamicBuffer<double>&)
+    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    >
+  class DynamicTimeSurfaceGenerator1D: public DynamicTimeSurfaceGenerator<Event,
+                                                                          TimeSurfaceEvent,
+                                                                          Kernel,
+                                                                          TimeSurfaceEventFromEvent,
+                                                                          HandlerTimeSurfaceGenerator
+                                                                          >{
+  public:
+    DynamicTimeSurfaceGenerator1D(int64_t X,
+                                  int64_t nP,
+                                  int64_t radius,
+                                  int64_t initMemory,
+                                  Kernel kernel,
+                                  TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      DynamicTimeSurfaceGenerator<Event,
+                                  TimeSurfaceEvent,
+                                  Kernel,
+                                  TimeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator
+                                  >(X*nP,
+                                    (2*radius+1)*nP,
+                                    initMemory,
+                                    std::forward<Kernel>(kernel),
+                                    std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+                                    std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)),
+      _X(X),
+      _nP(nP),
+      _radius(radius)
+    {
+      if(X <= 0 || nP <= 0 || radius < 0){
+        throw std::logic_error("the sensor width and the number of polarities must be strictly positive, and the radius positive");
+      }
+    }
+
+    virtual void operator()(Event ev) {
+      const auto eventX = static_cast<int64_t>(ev.x);
+      const auto side = 2*_radius + 1;
+      this->_memory[ev.p*_X+ev.x] = static_cast<int64_t>(ev.t);
+
+      // the window is clamped once, and the context is cleared only when it crosses a border
+      const auto xMin = std::max(eventX - _radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + _radius, _X - 1);
+      if(xMax - xMin < 2*_radius){
+        std::fill(this->_context.begin(), this->_context.end(), 0.);
+      }
+      for(int64_t p = 0; p < _nP; p++){
+        row(ev,
+            this->_memory.data() + p*_X + xMin,
+            this->_context.data() + p*side + xMin - eventX + _radius,
+            xMax - xMin + 1,
+            xMin,
+            p,
+            typename AcceptsTimestampRows<Kernel>::type());
+      }
+
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        DynamicTimeSurfaceGenerator1D::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// row evaluates a rows kernel on count contiguous neighbors
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t, int64_t, std::true_type){
+      this->_kernel(static_cast<int64_t>(ev.t), input, output, static_cast<std::size_t>(count));
+    }
+
+    /// row evaluates the kernel on count contiguous neighbors, one at a time
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t p, std::false_type){
+      for(int64_t i = 0; i < count; i++){
+        output[i] = this->kernel(ev, input[i], typename AcceptsTimestamps<Kernel>::type(), xMin + i, p);
+      }
+    }
+
+    const int64_t _X;
+    const int64_t _nP;
+    const int64_t _radius;
+  };
+
+  /// 2D DynamicTimeSurfaceGenerator, whose memory and contexts are laid out as the TimeSurfaceGenerator2D ones
+  template<
+    typename Event, // require at least a field .t .x .y .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const DynamicBuffer<double>&)
+    typename HandlerTimeSurfaceGenerator, //  void f(TimeSurfaceEvent)
+    ContextOrder order = ContextOrder::polarityMajor
+    >
+  class DynamicTimeSurfaceGenerator2D: public DynamicTimeSurfaceGenerator<Event,
+                                                                          TimeSurfaceEvent,
+                                                                          Kernel,
+                                                                          TimeSurfaceEventFromEvent,
+                                                                          HandlerTimeSurfaceGenerator
+                                                                          >{
+  public:
+    DynamicTimeSurfaceGenerator2D(int64_t X,
+                                  int64_t Y,
+                                  int64_t nP,
+                                  int64_t radius,
+                                  int64_t initMemory,
+                                  Kernel kernel,
+                                  TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      DynamicTimeSurfaceGenerator<Event,
+                                  TimeSurfaceEvent,
+                                  Kernel,
+                                  TimeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator
+                                  >(X*Y*nP,
+                                    (2*radius+1)*(2*radius+1)*nP,
+                                    initMemory,
+                                    std::forward<Kernel>(kernel),
+                                    std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+                                    std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)),
+      _X(X),
+      _Y(Y),
+      _nP(nP),
+      _radius(radius),
+      _row((2*radius+1)*nP)
+    {
+      if(X <= 0 || Y <= 0 || nP <= 0 || radius < 0){
+        throw std::logic_error("the sensor size and the number of polarities must be strictly positive, and the radius positive");
+      }
+    }
+
+    virtual void operator()(Event ev){
+      const auto eventX = static_cast<int64_t>(ev.x);
+      const auto eventY = static_cast<int64_t>(ev.y);
+      const auto side = 2*_radius + 1;
+      this->_memory[(eventY*_X + eventX)*_nP + ev.p] = static_cast<int64_t>(ev.t);
+
+      // the window is clamped once, and the context is cleared only when it crosses a border
+      const auto xMin = std::max(eventX - _radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + _radius, _X - 1);
+      const auto yMin = std::max(eventY - _radius, static_cast<int64_t>(0));
+      const auto yMax = std::min(eventY + _radius, _Y - 1);
+      if(xMax - xMin < 2*_radius || yMax - yMin < 2*_radius){
+        std::fill(this->_context.begin(), this->_context.end(), 0.);
+      }
+
+      const auto rowSize = (xMax - xMin + 1)*_nP;
+      for(int64_t y = yMin; y <= yMax; y++){
+        const auto input = this->_memory.data() + (y*_X + xMin)*_nP;
+        if(order == ContextOrder::pixelMajor){
+          row(ev,
+              input,
+              this->_context.data() + ((y - eventY + _radius)*side + xMin - eventX + _radius)*_nP,
+              rowSize,
+              xMin,
+              y,
+              typename AcceptsTimestampRows<Kernel>::type());
+        }else{
+          transposedRow(ev,
+                        input,
+                        this->_context.data() + (xMin - eventX + _radius)*side + y - eventY + _radius,
+                        rowSize,
+                        xMin,
+                        y,
+                        typename AcceptsTimestampRows<Kernel>::type());
+        }
+      }
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        DynamicTimeSurfaceGenerator2D::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// row evaluates a rows kernel on count contiguous neighbors
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t, int64_t, std::true_type){
+      this->_kernel(static_cast<int64_t>(ev.t), input, output, static_cast<std::size_t>(count));
+    }
+
+    /// row evaluates the kernel on count contiguous neighbors, one at a time
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t y, std::false_type){
+      neighbors(ev, input, output, count, xMin, y, typename AcceptsTimestamps<Kernel>::type());
+    }
+
+    /// transposedRow evaluates a rows kernel on count contiguous neighbors, and scatters them in a polarity major context
+    void transposedRow(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t y, std::true_type){
+      const auto side = 2*_radius + 1;
+      row(ev, input, _row.data(), count, xMin, y, std::true_type());
+      for(int64_t p = 0; p < _nP; p++){
+        for(int64_t x = 0; x < count/_nP; x++){
+          output[(p*side + x)*side] = _row[x*_nP + p];
+        }
+      }
+    }
+
+    /// transposedRow evaluates the kernel directly in a polarity major context, one neighbor at a time
+    /// Going through the intermediate row would cost as much as the kernel itself.
+    void transposedRow(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t y, std::false_type){
+      const auto side = 2*_radius + 1;
+      const auto columns = count/_nP;
+      for(int64_t p = 0; p < _nP; p++){
+        auto polarityOutput = output + p*side*side;
+        auto polarityInput = input + p;
+        for(int64_t x = 0; x < columns; x++, polarityOutput += side, polarityInput += _nP){
+          *polarityOutput = this->kernel(ev, *polarityInput, typename AcceptsTimestamps<Kernel>::type(), xMin + x, y, p);
+        }
+      }
+    }
+
+    /// neighbors evaluates a timestamps kernel, whose flat loop does not depend on the number of polarities
+    void neighbors(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t, int64_t, std::true_type){
+      for(int64_t i = 0; i < count; i++){
+        output[i] = this->_kernel(static_cast<int64_t>(ev.t), input[i]);
+      }
+    }
+
+    /// neighbors evaluates an events kernel, which needs the coordinates of each neighbor
+    void neighbors(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t y, std::false_type){
+      for(int64_t x = 0; x < count/_nP; x++){
+        for(int64_t p = 0; p < _nP; p++){
+          output[x*_nP + p] = this->kernel(ev, input[x*_nP + p], std::false_type(), xMin + x, y, p);
+        }
+      }
+    }
+
+    const int64_t _X;
+    const int64_t _Y;
+    const int64_t _nP;
+    const int64_t _radius;
+    DynamicBuffer<double> _row;
+  };
+
+  //------------------------------------------------------------------------------------------
+  /// make_dynamicTimeSurfaceGenerator
+
+  /// 1D version
+  template<
+    typename Event, //Requires at least a field .t, .x, .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const DynamicBuffer<double>&)
+    typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
+    >
+  DynamicTimeSurfaceGenerator1D<Event,
+                                TimeSurfaceEvent,
+                                Kernel,
+                                TimeSurfaceEventFromEvent,
+                                HandlerTimeSurfaceGenerator>
+  make_dynamicTimeSurfaceGenerator(int64_t X,
+                                   int64_t nP,
+                                   int64_t radius,
+                                   int64_t initMemory,
+                                   Kernel kernel,
+                                   TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                   HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+  {
+    return DynamicTimeSurfaceGenerator1D<Event,
+                                         TimeSurfaceEvent,
+                                         Kernel,
+                                         TimeSurfaceEventFromEvent,
+                                         HandlerTimeSurfaceGenerator>
+      (X,
+       nP,
+       radius,
+       initMemory,
+       std::forward<Kernel>(kernel),
+       std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       );
+  }
+
+  /// 2D version
+  template<
+    typename Event, //Requires at least a field .t, .x, .y, .p
+    typename TimeSurfaceEvent,
+    ContextOrder order = ContextOrder::polarityMajor,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const DynamicBuffer<double>&)
+    typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
+    >
+  DynamicTimeSurfaceGenerator2D<Event,
+                                TimeSurfaceEvent,
+                                Kernel,
+                                TimeSurfaceEventFromEvent,
+                                HandlerTimeSurfaceGenerator,
+                                order>
+  make_dynamicTimeSurfaceGenerator(int64_t X,
+                                   int64_t Y,
+                                   int64_t nP,
+                                   int64_t radius,
+                                   int64_t initMemory,
+                                   Kernel kernel,
+                                   TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                   HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+  {
+    return DynamicTimeSurfaceGenerator2D<Event,
+                                         TimeSurfaceEvent,
+                                         Kernel,
+                                         TimeSurfaceEventFromEvent,
+                                         HandlerTimeSurfaceGenerator,
+                                         order>
+      (X,
+       Y,
+       nP,
+       radius,
+       initMemory,
+       std::forward<Kernel>(kernel),
+       std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       );
+  }
+};
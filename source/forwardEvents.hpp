@@ -0,0 +1,79 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// AcceptsEvents determines whether a functor has a batch entry point.
+    /// A batch entry point must have the signature:
+    ///     handleEvents(Event* begin, Event* end) -> void
+    template <typename HandleEvent, typename Event>
+    class AcceptsEvents {
+        template <typename Candidate>
+        static auto test(int) -> decltype(
+            std::declval<Candidate&>()(std::declval<Event*>(), std::declval<Event*>()),
+            std::true_type()
+        );
+
+        template <typename Candidate>
+        static std::false_type test(...);
+
+        public:
+            static constexpr bool value = decltype(test<HandleEvent>(0))::value;
+    };
+
+    /// AcceptsEvent determines whether a functor has a single-event entry point.
+    template <typename HandleEvent, typename Event>
+    class AcceptsEvent {
+        template <typename Candidate>
+        static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<Event&>()), std::true_type());
+
+        template <typename Candidate>
+        static std::false_type test(...);
+
+        public:
+            static constexpr bool value = decltype(test<HandleEvent>(0))::value;
+    };
+
+    /// forwardEvent sends a single event to a functor.
+    /// Functors without a single-event entry point receive a range containing only the event.
+    template <typename Event, typename HandleEvent>
+    typename std::enable_if<AcceptsEvent<HandleEvent, Event>::value, void>::type
+    forwardEvent(HandleEvent& handleEvent, Event& event) {
+        handleEvent(event);
+    }
+
+    /// forwardEvent sends a single event to a functor.
+    /// Functors without a single-event entry point receive a range containing only the event.
+    template <typename Event, typename HandleEvent>
+    typename std::enable_if<!AcceptsEvent<HandleEvent, Event>::value, void>::type
+    forwardEvent(HandleEvent& handleEvent, Event& event) {
+        handleEvent(&event, &event + 1);
+    }
+
+    /// forwardEvents sends a contiguous range of events to a functor.
+    /// The range is forwarded in a single call if the functor has a batch entry point,
+    /// and one event at a time otherwise.
+    /// The functor is allowed to modify the events in place.
+    template <typename Event, typename HandleEvent>
+    typename std::enable_if<AcceptsEvents<HandleEvent, Event>::value, void>::type
+    forwardEvents(HandleEvent& handleEvent, Event* begin, Event* end) {
+        if (begin != end) {
+            handleEvent(begin, end);
+        }
+    }
+
+    /// forwardEvents sends a contiguous range of events to a functor.
+    /// The range is forwarded in a single call if the functor has a batch entry point,
+    /// and one event at a time otherwise.
+    /// The functor is allowed to modify the events in place.
+    template <typename Event, typename HandleEvent>
+    typename std::enable_if<!AcceptsEvents<HandleEvent, Event>::value, void>::type
+    forwardEvents(HandleEvent& handleEvent, Event* begin, Event* end) {
+        for (; begin != end; ++begin) {
+            handleEvent(*begin);
+        }
+    }
+}
@@ -1,27 +1,762 @@
 #pragma once
 
+#include "precision.hpp"
+
 #include <iostream>
+#include <cstring>
 #include <algorithm>
 #include <cstdint>
 #include <cmath>
 #include <utility>
 #include <array>
+#include <vector>
 #include <numeric>
+#include <type_traits>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+#include <exception>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
 
+  /// AcceptsCenterMatrix determines whether a metric computes the distances to every center in one pass:
+  ///     void f(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* context, double* distances)
+  /// The centers are contiguous and center-major. Other metrics are called once per center with iterators.
+  template<typename Metric, typename Compute>
+  class AcceptsCenterMatrix{
+    template<typename Candidate>
+    static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<const Compute*>(), std::declval<std::size_t>(), std::declval<std::size_t>(), std::declval<const Compute*>(), std::declval<double*>()), std::true_type());
+
+    template<typename Candidate>
+    static std::false_type test(...);
+
+  public:
+    typedef decltype(test<Metric>(0)) type;
+  };
+
+  /// AcceptsContextMatrix determines whether a metric computes the distances between every context of a batch and every center:
+  ///     void f(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances)
+  /// The contexts are contiguous and context-major, and the distances are written context-major.
+  template<typename Metric, typename Compute>
+  class AcceptsContextMatrix{
+    template<typename Candidate>
+    static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<const Compute*>(), std::declval<std::size_t>(), std::declval<std::size_t>(), std::declval<const Compute*>(), std::declval<std::size_t>(), std::declval<double*>()), std::true_type());
+
+    template<typename Candidate>
+    static std::false_type test(...);
+
+  public:
+    typedef decltype(test<Metric>(0)) type;
+  };
+
+  /// AcceptsCenterSquares determines whether a metric takes the squared norms of the centers, instead of computing them on every pass:
+  ///     void f(const Compute* centers, const double* centerSquares, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances)
+  /// The clusters compute the squared norms with the SquareTerm of CenterMatrix whenever a center changes.
+  template<typename Metric, typename Compute>
+  class AcceptsCenterSquares{
+    template<typename Candidate>
+    static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<const Compute*>(), std::declval<const double*>(), std::declval<std::size_t>(), std::declval<std::size_t>(), std::declval<const Compute*>(), std::declval<std::size_t>(), std::declval<double*>()), std::true_type());
+
+    template<typename Candidate>
+    static std::false_type test(...);
+
+  public:
+    typedef decltype(test<Metric>(0)) type;
+  };
+
+  /// CenterLanes wraps the arithmetic of the blocked pass, one value at a time by default
+  template<typename Compute>
+  class CenterLanes{
+  public:
+    typedef Compute Vector;
+
+    static constexpr std::size_t width(){
+      return 1;
+    }
+
+    static Vector zero(){
+      return 0;
+    }
+
+    static Vector load(const Compute* values){
+      return *values;
+    }
+
+    static Vector add(Vector first, Vector second){
+      return first + second;
+    }
+
+    static Compute sum(Vector vector){
+      return vector;
+    }
+  };
+
+#if defined(__AVX2__)
+  /// CenterLanes specialization for four doubles
+  template<>
+  class CenterLanes<double>{
+  public:
+    typedef __m256d Vector;
+
+    static constexpr std::size_t width(){
+      return 4;
+    }
+
+    static Vector zero(){
+      return _mm256_setzero_pd();
+    }
+
+    static Vector load(const double* values){
+      return _mm256_loadu_pd(values);
+    }
+
+    static Vector add(Vector first, Vector second){
+      return _mm256_add_pd(first, second);
+    }
+
+    static double sum(Vector vector){
+      const auto pair = _mm_add_pd(_mm256_castpd256_pd128(vector), _mm256_extractf128_pd(vector, 1));
+      return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    }
+  };
+
+  /// CenterLanes specialization for eight floats
+  template<>
+  class CenterLanes<float>{
+  public:
+    typedef __m256 Vector;
+
+    static constexpr std::size_t width(){
+      return 8;
+    }
+
+    static Vector zero(){
+      return _mm256_setzero_ps();
+    }
+
+    static Vector load(const float* values){
+      return _mm256_loadu_ps(values);
+    }
+
+    static Vector add(Vector first, Vector second){
+      return _mm256_add_ps(first, second);
+    }
+
+    static float sum(Vector vector){
+      auto quad = _mm_add_ps(_mm256_castps256_ps128(vector), _mm256_extractf128_ps(vector, 1));
+      quad = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+      return _mm_cvtss_f32(_mm_add_ss(quad, _mm_movehdup_ps(quad)));
+    }
+  };
+#endif
+
+  /// CenterMatrix sums a term over the values of every pair of context and center, as a matrix product would
+  /// Tiles of four centers by two contexts share their loads, and each pair accumulates in its own register.
+  /// The centers tile is the outer loop, so that it stays in cache while the contexts of the batch stream past it.
+  class CenterMatrix{
+  public:
+    template<typename Compute, typename Term>
+    static void sums(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* output, Term term){
+      const auto blockedCenters = nCenters - nCenters%4;
+      const auto blockedContexts = nContexts - nContexts%2;
+      for(std::size_t i = 0; i < blockedCenters; i += 4){
+        for(std::size_t c = 0; c < blockedContexts; c += 2){
+          block<4, 2>(centers + i*neighborhood, neighborhood, contexts + c*neighborhood, output + c*nCenters + i, nCenters, term);
+        }
+        for(std::size_t c = blockedContexts; c < nContexts; c++){
+          block<4, 1>(centers + i*neighborhood, neighborhood, contexts + c*neighborhood, output + c*nCenters + i, nCenters, term);
+        }
+      }
+      for(std::size_t i = blockedCenters; i < nCenters; i++){
+        for(std::size_t c = 0; c < nContexts; c++){
+          block<1, 1>(centers + i*neighborhood, neighborhood, contexts + c*neighborhood, output + c*nCenters + i, nCenters, term);
+        }
+      }
+    }
+
+  protected:
+    template<std::size_t centersSize, std::size_t contextsSize, typename Compute, typename Term>
+    static void block(const Compute* centers, std::size_t neighborhood, const Compute* contexts, double* output, std::size_t stride, Term term){
+      typedef CenterLanes<Compute> Lanes;
+      typename Lanes::Vector accumulators[contextsSize][centersSize];
+      for(std::size_t c = 0; c < contextsSize; c++){
+        for(std::size_t k = 0; k < centersSize; k++){
+          accumulators[c][k] = Lanes::zero();
+        }
+      }
+      const auto vectorized = neighborhood - neighborhood%Lanes::width();
+      for(std::size_t j = 0; j < vectorized; j += Lanes::width()){
+        typename Lanes::Vector values[contextsSize];
+        for(std::size_t c = 0; c < contextsSize; c++){
+          values[c] = Lanes::load(contexts + c*neighborhood + j);
+        }
+        for(std::size_t k = 0; k < centersSize; k++){
+          const auto center = Lanes::load(centers + k*neighborhood + j);
+          for(std::size_t c = 0; c < contextsSize; c++){
+            accumulators[c][k] = Lanes::add(accumulators[c][k], term(center, values[c]));
+          }
+        }
+      }
+      for(std::size_t c = 0; c < contextsSize; c++){
+        for(std::size_t k = 0; k < centersSize; k++){
+          auto sum = Lanes::sum(accumulators[c][k]);
+          for(auto remaining = vectorized; remaining < neighborhood; remaining++){
+            sum += term(centers[k*neighborhood + remaining], contexts[c*neighborhood + remaining]);
+          }
+          output[c*stride + k] = sum;
+        }
+      }
+    }
+  };
+
+  /// SquaredDifferenceTerm is the term of the euclidean distance
+  class SquaredDifferenceTerm{
+  public:
+    template<typename Compute>
+    Compute operator()(Compute center, Compute context) const {
+      return (center - context)*(center - context);
+    }
+#if defined(__AVX2__)
+    __m256d operator()(__m256d center, __m256d context) const {
+      const auto difference = _mm256_sub_pd(center, context);
+      return _mm256_mul_pd(difference, difference);
+    }
+
+    __m256 operator()(__m256 center, __m256 context) const {
+      const auto difference = _mm256_sub_ps(center, context);
+      return _mm256_mul_ps(difference, difference);
+    }
+#endif
+  };
+
+  /// ProductTerm is the term of a scalar product
+  class ProductTerm{
+  public:
+    template<typename Compute>
+    Compute operator()(Compute center, Compute context) const {
+      return center*context;
+    }
+#if defined(__AVX2__)
+    __m256d operator()(__m256d center, __m256d context) const {
+      return _mm256_mul_pd(center, context);
+    }
+
+    __m256 operator()(__m256 center, __m256 context) const {
+      return _mm256_mul_ps(center, context);
+    }
+#endif
+  };
+
+  /// SquareTerm is the term of the squared norm of the centers
+  class SquareTerm{
+  public:
+    template<typename Compute>
+    Compute operator()(Compute center, Compute) const {
+      return center*center;
+    }
+#if defined(__AVX2__)
+    __m256d operator()(__m256d center, __m256d) const {
+      return _mm256_mul_pd(center, center);
+    }
+
+    __m256 operator()(__m256 center, __m256) const {
+      return _mm256_mul_ps(center, center);
+    }
+#endif
+  };
+
+  /// RootProductTerm is the term of the Bhattacharyya coefficient
+  class RootProductTerm{
+  public:
+    template<typename Compute>
+    Compute operator()(Compute center, Compute context) const {
+      return std::sqrt(center*context);
+    }
+#if defined(__AVX2__)
+    __m256d operator()(__m256d center, __m256d context) const {
+      return _mm256_sqrt_pd(_mm256_mul_pd(center, context));
+    }
+
+    __m256 operator()(__m256 center, __m256 context) const {
+      return _mm256_sqrt_ps(_mm256_mul_ps(center, context));
+    }
+#endif
+  };
+
+  /// EuclideanMetric is the euclidean distance between a center and a context
+  class EuclideanMetric{
+  public:
+    template<typename Iterator>
+    double operator()(Iterator centerBegin, Iterator centerEnd, Iterator contextBegin) const {
+      auto sum = 0.;
+      for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+        sum += SquaredDifferenceTerm()(*centerBegin, *contextBegin);
+      }
+      return std::sqrt(sum);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* context, double* distances) const {
+      operator()(centers, nCenters, neighborhood, context, 1, distances);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances) const {
+      CenterMatrix::sums(centers, nCenters, neighborhood, contexts, nContexts, distances, SquaredDifferenceTerm());
+      for(std::size_t i = 0; i < nCenters*nContexts; i++){
+        distances[i] = std::sqrt(distances[i]);
+      }
+    }
+  };
+
+  /// CosineMetric is one minus the cosine similarity between a center and a context
+  /// Null vectors are at distance one of every other vector.
+  class CosineMetric{
+  public:
+    template<typename Iterator>
+    double operator()(Iterator centerBegin, Iterator centerEnd, Iterator contextBegin) const {
+      auto product = 0., centerSquare = 0., contextSquare = 0.;
+      for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+        product += ProductTerm()(*centerBegin, *contextBegin);
+        centerSquare += SquareTerm()(*centerBegin, *contextBegin);
+        contextSquare += SquareTerm()(*contextBegin, *contextBegin);
+      }
+      return distance(product, centerSquare, contextSquare);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* context, double* distances) const {
+      operator()(centers, nCenters, neighborhood, context, 1, distances);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances) const {
+      CenterMatrix::sums(centers, nCenters, neighborhood, contexts, nContexts, distances, ProductTerm());
+      // the norms of the centers are computed by chunks, and the norms of the contexts once per chunk
+      for(std::size_t first = 0; first < nCenters; first += 64){
+        const auto size = std::min<std::size_t>(64, nCenters - first);
+        double centerSquares[64];
+        for(std::size_t i = 0; i < size; i++){
+          const auto center = centers + (first + i)*neighborhood;
+          CenterMatrix::sums(center, 1, neighborhood, center, 1, centerSquares + i, SquareTerm());
+        }
+        divide(centerSquares, first, size, nCenters, neighborhood, contexts, nContexts, distances);
+      }
+    }
+
+    /// operator() takes the squared norms of the centers, which the clusters only update with learning (see AcceptsCenterSquares)
+    template<typename Compute>
+    void operator()(const Compute* centers, const double* centerSquares, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances) const {
+      CenterMatrix::sums(centers, nCenters, neighborhood, contexts, nContexts, distances, ProductTerm());
+      divide(centerSquares, 0, nCenters, nCenters, neighborhood, contexts, nContexts, distances);
+    }
+
+  protected:
+    /// divide turns the products of the centers [first, first + size) into distances, given their squared norms
+    template<typename Compute>
+    static void divide(const double* centerSquares, std::size_t first, std::size_t size, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances){
+      for(std::size_t c = 0; c < nContexts; c++){
+        double contextSquare;
+        CenterMatrix::sums(contexts + c*neighborhood, 1, neighborhood, contexts + c*neighborhood, 1, &contextSquare, SquareTerm());
+        for(std::size_t i = 0; i < size; i++){
+          auto& value = distances[c*nCenters + first + i];
+          value = distance(value, centerSquares[i], contextSquare);
+        }
+      }
+    }
+
+    static double distance(double product, double centerSquare, double contextSquare){
+      const auto norms = std::sqrt(centerSquare*contextSquare);
+      return (norms > 0.) ? 1. - product/norms : 1.;
+    }
+  };
+
+  /// BhattacharyyaMetric is the Bhattacharyya distance between normalized centers and contexts
+  /// Infinite distances are replaced with infinity, and distances below zero with 0, as in the historical HOTS metrics.
+  class BhattacharyyaMetric{
+  public:
+    BhattacharyyaMetric(double infinity = 1000., double zero = 1e-6):
+      _infinity(infinity),
+      _zero(zero)
+    {}
+
+    template<typename Iterator>
+    double operator()(Iterator centerBegin, Iterator centerEnd, Iterator contextBegin) const {
+      auto coefficient = 0.;
+      for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+        coefficient += RootProductTerm()(*centerBegin, *contextBegin);
+      }
+      return distance(coefficient);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* context, double* distances) const {
+      operator()(centers, nCenters, neighborhood, context, 1, distances);
+    }
+
+    template<typename Compute>
+    void operator()(const Compute* centers, std::size_t nCenters, std::size_t neighborhood, const Compute* contexts, std::size_t nContexts, double* distances) const {
+      CenterMatrix::sums(centers, nCenters, neighborhood, contexts, nContexts, distances, RootProductTerm());
+      for(std::size_t i = 0; i < nCenters*nContexts; i++){
+        distances[i] = distance(distances[i]);
+      }
+    }
+
+  protected:
+    double distance(double coefficient) const {
+      const auto value = -std::log(coefficient);
+      return (std::isinf(value)) ? _infinity : (value < _zero) ? 0 : value;
+    }
+
+    double _infinity;
+    double _zero;
+  };
+
+  /// ClusterCheckpoint lays out the binary checkpoints of the clusters, as consecutive 8 bytes aligned sections:
+  ///     a 64 bytes Header, which identifies the cluster kind, its dimensions and its precision
+  ///     the centers, center-major, as Precision::Value
+  ///     the sums of the centers, as doubles
+  ///     the activities, as int64_t, for the standard clusters
+  /// The values are stored with the native byte order, so that a memory-mapped checkpoint is loaded with one copy per section.
+  class ClusterCheckpoint{
+  public:
+    enum class Kind: uint32_t{
+      iiwk = 0,
+      standard = 1,
+    };
+
+    struct Header{
+      char magic[8];
+      uint32_t version;
+      uint32_t kind;
+      uint64_t nCenters;
+      uint64_t neighborhood;
+      uint32_t valueSize;
+      uint32_t valueIsFloatingPoint;
+      uint64_t byteOrder;
+      int64_t first;
+      uint64_t reserved;
+    };
+    static_assert(sizeof(Header) == 64, "the checkpoint header must be 64 bytes long");
+
+    static constexpr uint32_t version(){
+      return 1;
+    }
+
+    /// header returns the header of a cluster checkpoint
+    template<typename Value>
+    static Header header(Kind kind, uint64_t nCenters, uint64_t neighborhood, int64_t first){
+      Header header;
+      std::memcpy(header.magic, "TSRHOTS", 8);
+      header.version = version();
+      header.kind = static_cast<uint32_t>(kind);
+      header.nCenters = nCenters;
+      header.neighborhood = neighborhood;
+      header.valueSize = sizeof(Value);
+      header.valueIsFloatingPoint = std::is_floating_point<Value>::value ? 1 : 0;
+      header.byteOrder = 0x0102030405060708;
+      header.first = first;
+      header.reserved = 0;
+      return header;
+    }
+
+    /// write appends a section to a checkpoint, padded to 8 bytes
+    static void write(std::ostream& stream, const void* data, std::size_t size){
+      const char padding[8] = {};
+      stream.write(reinterpret_cast<const char*>(data), size);
+      stream.write(padding, padded(size) - size);
+      if(!stream){
+        throw std::runtime_error("the checkpoint could not be written");
+      }
+    }
+
+    /// read loads a whole checkpoint of the given size from a stream
+    static std::vector<char> read(std::istream& stream, std::size_t size){
+      std::vector<char> data(size);
+      stream.read(data.data(), size);
+      if(static_cast<std::size_t>(stream.gcount()) != size){
+        throw std::runtime_error("the checkpoint is truncated");
+      }
+      return data;
+    }
+
+    /// size returns the number of bytes of a checkpoint
+    template<typename Value>
+    static std::size_t size(Kind kind, uint64_t nCenters, uint64_t neighborhood){
+      return sizeof(Header)
+        + padded(nCenters*neighborhood*sizeof(Value))
+        + padded(nCenters*sizeof(double))
+        + (kind == Kind::standard ? padded(nCenters*sizeof(int64_t)) : 0);
+    }
+
+    /// Reader copies the sections of a checkpoint held in memory, for instance a memory-mapped file
+    class Reader{
+    public:
+      Reader(const char* data, std::size_t size):
+        _data(data),
+        _size(size),
+        _offset(0)
+      {}
+
+      /// header reads the header, and throws if it does not match the expected one or if the checkpoint is too short
+      /// The first index is not compared, since it is part of the learning state.
+      Header header(const Header& expected, std::size_t expectedSize){
+        if(_size < expectedSize){
+          throw std::runtime_error("the checkpoint is truncated");
+        }
+        Header header;
+        read(&header, sizeof(header));
+        if(std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0){
+          throw std::runtime_error("the data is not a cluster checkpoint");
+        }
+        if(header.byteOrder != expected.byteOrder){
+          throw std::runtime_error("the checkpoint byte order differs from the native one");
+        }
+        if(header.version != expected.version){
+          throw std::runtime_error("unsupported checkpoint version");
+        }
+        if(header.kind != expected.kind
+           || header.nCenters != expected.nCenters
+           || header.neighborhood != expected.neighborhood
+           || header.valueSize != expected.valueSize
+           || header.valueIsFloatingPoint != expected.valueIsFloatingPoint){
+          throw std::runtime_error("the checkpoint was saved by a different cluster type");
+        }
+        return header;
+      }
+
+      /// read copies the next section
+      void read(void* output, std::size_t size){
+        if(_offset + size > _size){
+          throw std::runtime_error("the checkpoint is truncated");
+        }
+        std::memcpy(output, _data + _offset, size);
+        _offset += padded(size);
+      }
+
+    protected:
+      const char* _data;
+      std::size_t _size;
+      std::size_t _offset;
+    };
+
+  protected:
+    static std::size_t padded(std::size_t size){
+      return (size + 7)/8*8;
+    }
+  };
+
+  /// MiniBatchBarrier blocks the threads of a mini-batch learning until all of them have reached it
+  /// wait returns true if any thread reached the barrier with failed set, hence all the threads agree on whether to stop.
+  class MiniBatchBarrier{
+  public:
+    MiniBatchBarrier(std::size_t numberOfThreads):
+      _numberOfThreads(numberOfThreads),
+      _waiting(0),
+      _generation(0),
+      _failed(false),
+      _failures{{false, false}}
+    {}
+
+    bool wait(bool failed = false){
+      const auto generation = _generation.load(std::memory_order_acquire);
+      if(failed){
+        _failed.store(true, std::memory_order_relaxed);
+      }
+      if(_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == _numberOfThreads){
+        // a generation cannot complete before every thread has left the previous one, hence two slots are enough
+        _failures[generation & 1] = _failed.exchange(false, std::memory_order_relaxed);
+        _waiting.store(0, std::memory_order_relaxed);
+        _generation.fetch_add(1, std::memory_order_release);
+      }else{
+        while(_generation.load(std::memory_order_acquire) == generation){
+          std::this_thread::yield();
+        }
+      }
+      return _failures[generation & 1];
+    }
+
+  protected:
+    const std::size_t _numberOfThreads;
+    std::atomic<std::size_t> _waiting;
+    std::atomic<std::size_t> _generation;
+    std::atomic<bool> _failed;
+    std::array<bool, 2> _failures;
+  };
+
+  /// MiniBatchUpdates accumulates the updates that the events of a mini-batch slice make to every center:
+  ///     counts is the number of updates, rates the sum of their learning rates
+  ///     retentions is the product of (1 - learning rate), the fraction of the center left by the updates
+  ///     weightedContexts is the sum of the contexts weighted by their learning rates
+  /// Applied in sequence to a center c, updates with rates r_k towards contexts x_k are approximated by
+  /// c + (1 - retention)*(weighted mean of x_k - c), which is exact when the contexts are identical and stays stable when the rates sum above 1.
+  class MiniBatchUpdates{
+  public:
+    MiniBatchUpdates(std::size_t nCenters, std::size_t neighborhood):
+      counts(nCenters),
+      rates(nCenters),
+      retentions(nCenters),
+      weightedContexts(nCenters*neighborhood),
+      _neighborhood(neighborhood)
+    {}
+
+    /// clear resets the updates before a mini-batch
+    void clear(){
+      std::fill(counts.begin(), counts.end(), 0);
+      std::fill(rates.begin(), rates.end(), 0.);
+      std::fill(retentions.begin(), retentions.end(), 1.);
+      std::fill(weightedContexts.begin(), weightedContexts.end(), 0.);
+    }
+
+    /// add accumulates an update of the center i towards a context
+    template<typename Values>
+    void add(std::size_t i, double rate, const Values& values){
+      counts[i]++;
+      rates[i]+=rate;
+      retentions[i]*=(1 - rate);
+      auto weightedContext = weightedContexts.data() + i*_neighborhood;
+      for(std::size_t j = 0; j < _neighborhood; j++){
+        weightedContext[j]+=rate*values[j];
+      }
+    }
+
+    std::vector<int64_t> counts;
+    std::vector<double> rates;
+    std::vector<double> retentions;
+    std::vector<double> weightedContexts;
+
+  protected:
+    std::size_t _neighborhood;
+  };
+
+  /// attemptMiniBatchStep runs a step of a mini-batch learning unless the thread has already failed, stores its exception, and returns whether the thread has failed
+  template<typename Step>
+  bool attemptMiniBatchStep(std::exception_ptr& exception, Step step){
+    if(!exception){
+      try{
+        step();
+      }catch(...){
+        exception = std::current_exception();
+      }
+    }
+    return static_cast<bool>(exception);
+  }
+
+  /// learnByMiniBatches splits a range of events in mini-batches, processed by numberOfThreads threads (the caller included):
+  ///     accumulate(thread, slice begin, slice end, assignments) runs on every thread with a slice of the mini-batch, and writes the polarity of each event
+  ///     merge(thread) runs on every thread once the whole mini-batch is accumulated
+  ///     send(mini-batch begin, mini-batch end, assignments) runs on the caller once the mini-batch is merged
+  /// The assignments are double-buffered, so that the caller sends a mini-batch while the other threads accumulate the next one.
+  /// If a function throws, every thread stops at the next barrier, and the first exception (in thread order) is rethrown on the caller once the threads are joined.
+  template<typename Event, typename Accumulate, typename Merge, typename Send>
+  void learnByMiniBatches(Event* begin, Event* end, std::size_t numberOfThreads, std::size_t miniBatchSize, Accumulate accumulate, Merge merge, Send send){
+    if(numberOfThreads == 0 || miniBatchSize == 0){
+      throw std::logic_error("numberOfThreads and miniBatchSize must be strictly positive");
+    }
+    std::vector<int64_t> assignments(2*miniBatchSize);
+    std::vector<std::exception_ptr> exceptions(numberOfThreads);
+    MiniBatchBarrier barrier(numberOfThreads);
+    const auto run = [&](std::size_t thread){
+      std::size_t parity = 0;
+      for(auto batchBegin = begin; batchBegin != end; parity ^= 1){
+        const auto size = std::min(miniBatchSize, static_cast<std::size_t>(end - batchBegin));
+        const auto sliceBegin = size*thread/numberOfThreads;
+        const auto sliceEnd = size*(thread + 1)/numberOfThreads;
+        const auto batchAssignments = assignments.data() + parity*miniBatchSize;
+        const auto failed = attemptMiniBatchStep(exceptions[thread], [&](){
+            accumulate(thread, batchBegin + sliceBegin, batchBegin + sliceEnd, batchAssignments + sliceBegin);
+          });
+        if(barrier.wait(failed)){
+          return;
+        }
+        if(barrier.wait(attemptMiniBatchStep(exceptions[thread], [&](){ merge(thread); }))){
+          return;
+        }
+        if(thread == 0){
+          attemptMiniBatchStep(exceptions[thread], [&](){ send(batchBegin, batchBegin + size, batchAssignments); });
+        }
+        batchBegin += size;
+      }
+    };
+    std::vector<std::thread> threads;
+    for(std::size_t thread = 1; thread < numberOfThreads; thread++){
+      threads.emplace_back(run, thread);
+    }
+    run(0);
+    for(auto&& thread: threads){
+      thread.join();
+    }
+    for(auto&& exception: exceptions){
+      if(exception){
+        std::rethrow_exception(exception);
+      }
+    }
+  }
+
+  /// Lineage stores the polarities given to an event by the successive layers of a HOTS network.
+  /// The polarities are stored inline up to capacity, hence events carrying a lineage are copied without heap allocations.
+  template<std::size_t capacity>
+  class Lineage{
+  public:
+    Lineage():
+      _polarities(),
+      _size(0)
+    {}
+
+    /// push_back appends a polarity, and throws if the lineage is full
+    void push_back(int64_t polarity){
+      if(_size == capacity){
+        throw std::length_error("the lineage is full");
+      }
+      _polarities[_size] = polarity;
+      ++_size;
+    }
+
+    std::size_t size() const {
+      return _size;
+    }
+
+    bool empty() const {
+      return _size == 0;
+    }
+
+    int64_t operator[](std::size_t index) const {
+      return _polarities[index];
+    }
+
+    int64_t back() const {
+      return _polarities[_size - 1];
+    }
+
+    const int64_t* begin() const {
+      return _polarities.data();
+    }
+
+    const int64_t* end() const {
+      return _polarities.data() + _size;
+    }
+
+  protected:
+    std::array<int64_t, capacity> _polarities;
+    std::size_t _size;
+  };
+
   /// IiwkCluster
   template<
     uint64_t nCenters,
     std::size_t neighborhood,
     bool normalize,
     bool isLearning,
-    typename Event, // require at least a field .context
+    typename Event, // require at least a field .context, whose values are Precision::Value
     typename IiwkClusterEvent,
-    typename IiwkClusterMetric, // double f(std::array<double,neighborhood> iterator center begin,std::array<double,neighborhood> iterator center end,std::array<double,neighborhood> iterator context begin)
-    typename IiwkClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity)
-    typename HandlerIiwkCluster // void f(IiwkClusterEvent)
+    typename IiwkClusterMetric, // double f(std::array<Precision::Compute,neighborhood> iterator center begin,std::array<Precision::Compute,neighborhood> iterator center end,std::array<Precision::Compute,neighborhood> iterator context begin)
+    typename IiwkClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity), the event may be moved
+    typename HandlerIiwkCluster, // void f(IiwkClusterEvent)
+    typename Precision = DoublePrecision
     >
   class IiwkCluster{
   public:
@@ -37,18 +772,22 @@ namespace tarsier {
       _sumOfDistances(0.),
       _iiwkClusterMetric(std::forward<IiwkClusterMetric>(iiwkClusterMetric)),
       _iiwkClusterEventFromEvent(std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent)),
-      _handlerIiwkCluster(std::forward<HandlerIiwkCluster>(handlerIiwkCluster))
+      _handlerIiwkCluster(std::forward<HandlerIiwkCluster>(handlerIiwkCluster)),
+      _normalizedCenters(nCenters),
+      _batch(batchSize),
+      _batchDistances(batchSize*nCenters)
     {
       for(auto&& it: _distances){
         it = 0.;
       }
       for(auto&& it: _centers){
-        for(auto&& it2: it){
-          it2 = 0.5;
-        }
+        it.fill(Precision::encode(0.5));
       }
       for(auto&& it: _sumOfCenters){
-        it = 0.5*neighborhood;
+        it = Precision::decode(Precision::encode(0.5))*neighborhood;
+      }
+      for(uint64_t i = 0; i < nCenters; i++){
+        refresh(i);
       }
     }
 
@@ -67,7 +806,8 @@ namespace tarsier {
                   IiwkClusterEvent,
                   IiwkClusterMetric,
                   IiwkClusterEventFromEvent,
-                  HandlerIiwkCluster>
+                  HandlerIiwkCluster,
+                  Precision>
     (ksi1,
      ksi2,
      npow,
@@ -75,19 +815,47 @@ namespace tarsier {
      std::forward<IiwkClusterEventFromEvent>(iiwkClusterEventFromEvent),
      std::forward<HandlerIiwkCluster>(handlerIiwkCluster))
     {
-      auto cpt = 0;
-      for(auto&& it: _centers){
-        for(auto&& it2: _centers){
-          it2 = centers[cpt++];
+      for(uint64_t i = 0; i < nCenters; i++){
+        _sumOfCenters[i] = 0.;
+        for(std::size_t j = 0; j < neighborhood; j++){
+          _centers[i][j] = Precision::encode(centers[i][j]);
+          _sumOfCenters[i] += Precision::decode(_centers[i][j]);
         }
+        refresh(i);
       }
     }
 
     virtual ~IiwkCluster(){}
-    virtual std::array<std::array<double, neighborhood>, nCenters> getCenters() const{
+    virtual std::array<std::array<typename Precision::Value, neighborhood>, nCenters> getCenters() const{
       return _centers;
     }
 
+    /// save writes the centers and the learning state to a binary checkpoint (see ClusterCheckpoint)
+    void save(std::ostream& stream) const {
+      const auto header = ClusterCheckpoint::header<typename Precision::Value>(ClusterCheckpoint::Kind::iiwk, nCenters, neighborhood, 0);
+      ClusterCheckpoint::write(stream, &header, sizeof(header));
+      ClusterCheckpoint::write(stream, _centers.data(), sizeof(_centers));
+      ClusterCheckpoint::write(stream, _sumOfCenters.data(), sizeof(_sumOfCenters));
+    }
+
+    /// load restores a checkpoint written by save, and throws if it was saved by a different cluster type
+    void load(std::istream& stream){
+      const auto data = ClusterCheckpoint::read(stream, ClusterCheckpoint::size<typename Precision::Value>(ClusterCheckpoint::Kind::iiwk, nCenters, neighborhood));
+      load(data.data(), data.size());
+    }
+
+    /// load restores a checkpoint held in memory, for instance a memory-mapped file
+    void load(const char* data, std::size_t size){
+      ClusterCheckpoint::Reader reader(data, size);
+      reader.header(ClusterCheckpoint::header<typename Precision::Value>(ClusterCheckpoint::Kind::iiwk, nCenters, neighborhood, 0),
+                    ClusterCheckpoint::size<typename Precision::Value>(ClusterCheckpoint::Kind::iiwk, nCenters, neighborhood));
+      reader.read(_centers.data(), sizeof(_centers));
+      reader.read(_sumOfCenters.data(), sizeof(_sumOfCenters));
+      for(uint64_t i = 0; i < nCenters; i++){
+        refresh(i);
+      }
+    }
+
     /*virtual void setCenters(std::vector<std::array<double,neighborhood> > newCenters){
       if(newCenters.size() != _centers.size()){
       std::cout << "Error: waiting for centers of size " << _centers.size() << " instead of " << newCenters.size() << std::endl;
@@ -111,26 +879,8 @@ namespace tarsier {
       int64_t out_p;
       _sumOfDistances = 0.;
 
-      auto context = ev.context;
-      if(normalize){
-        auto sumOfContext = std::accumulate(context.begin(), context.end(), 0.);
-        for(auto&& it: context){
-          it/=sumOfContext;
-        }
-      }
-
+      normalizedDistances(ev.context, _distances.data());
       for(uint64_t i = 0; i < nCenters; i++){
-        auto curCenter = _centers[i];
-        if(normalize){
-          for(auto&& it: curCenter){
-            it/=_sumOfCenters[i];
-          }
-        }
-        _distances[i] = _iiwkClusterMetric(curCenter.begin(),
-                                           curCenter.end(),
-                                           context.begin()
-                                           );
-
         if(i == 0 || minimum > _distances[i]){
           minimum = _distances[i];
           out_p = i;
@@ -141,16 +891,12 @@ namespace tarsier {
       /// Update
       if(isLearning){
         if(minimum != 0){
-          double coeff = _ksi1*(
-                                (_npow+1)*std::pow(minimum,_npow-1)
-                                +_npow*std::pow(minimum, _npow-2)*(_sumOfDistances-minimum)
-                                );
-          coeff = (coeff > 1) ? 1: coeff;
+          const auto coeff = winnerRate(minimum, _sumOfDistances);
           double curCoeff;
 
           for(uint64_t i = 0; i < nCenters; i++){
             if(i != out_p){
-              curCoeff = _ksi2*std::pow(minimum,_npow)/_distances[i];
+              curCoeff = loserRate(minimum, _distances[i]);
             }else{
               curCoeff = coeff;
             }
@@ -158,8 +904,9 @@ namespace tarsier {
               _sumOfCenters[i] = 0.;
             }
             auto cpt = 0;
-            for(auto&& it: _centers[i]){
-              it+=curCoeff*(ev.context[cpt]-it);
+            for(auto&& stored: _centers[i]){
+              double it = Precision::decode(stored);
+              it+=curCoeff*(Precision::decode(ev.context[cpt])-it);
               if(it <= 0){
                 it = 0;
               }else{
@@ -167,20 +914,230 @@ namespace tarsier {
                   it = 1;
                 }
               }
+              stored = Precision::encode(it);
               if(normalize){
-                _sumOfCenters[i]+=it;
+                _sumOfCenters[i]+=Precision::decode(stored);
               }
               cpt++;
             }
+            refresh(i);
           }
         }
       }
 
       /// Send
-      _handlerIiwkCluster(_iiwkClusterEventFromEvent(ev, out_p));
+      _handlerIiwkCluster(_iiwkClusterEventFromEvent(std::move(ev), out_p));
+    }
+
+    /// operator() handles a contiguous range of events
+    /// Without learning, the events are classified by batches, with one pass over the centers per batch.
+    void operator()(Event* begin, Event* end){
+      batch(begin, end, std::integral_constant<bool, !isLearning && AcceptsContextMatrix<IiwkClusterMetric, typename Precision::Compute>::type::value>());
+    }
+
+    /// learn updates the centers with a range of events by mini-batches on numberOfThreads threads (the caller included), and sends the events in order.
+    /// Within a mini-batch, every event is assigned with the same centers, and the updates of the events are merged before being applied (see MiniBatchUpdates).
+    /// The metric is called concurrently and must be thread-safe. The handler is called from the caller thread.
+    void learn(Event* begin, Event* end, std::size_t numberOfThreads, std::size_t miniBatchSize = 1024){
+      static_assert(isLearning, "learn requires a learning cluster");
+      std::vector<MiniBatchUpdates> updates(numberOfThreads, MiniBatchUpdates(nCenters, neighborhood));
+      learnByMiniBatches(begin, end, numberOfThreads, miniBatchSize,
+                         [&](std::size_t thread, Event* sliceBegin, Event* sliceEnd, int64_t* assignments){
+                           updates[thread].clear();
+                           std::array<double, nCenters> eventDistances;
+                           for(; sliceBegin != sliceEnd; ++sliceBegin, ++assignments){
+                             normalizedDistances(sliceBegin->context, eventDistances.data());
+                             double minimum;
+                             int64_t out_p;
+                             auto sumOfDistances = 0.;
+                             for(uint64_t i = 0; i < nCenters; i++){
+                               if(i == 0 || minimum > eventDistances[i]){
+                                 minimum = eventDistances[i];
+                                 out_p = i;
+                               }
+                               sumOfDistances+=eventDistances[i];
+                             }
+                             *assignments = out_p;
+                             if(minimum != 0){
+                               const auto values = decode(sliceBegin->context);
+                               const auto coeff = winnerRate(minimum, sumOfDistances);
+                               for(uint64_t i = 0; i < nCenters; i++){
+                                 updates[thread].add(i, (i != static_cast<uint64_t>(out_p)) ? loserRate(minimum, eventDistances[i]) : coeff, values);
+                               }
+                             }
+                           }
+                         },
+                         [&](std::size_t thread){
+                           for(uint64_t i = nCenters*thread/numberOfThreads; i < nCenters*(thread + 1)/numberOfThreads; i++){
+                             auto rates = 0.;
+                             auto retention = 1.;
+                             for(auto&& threadUpdates: updates){
+                               rates+=threadUpdates.rates[i];
+                               retention*=threadUpdates.retentions[i];
+                             }
+                             if(rates > 0){
+                               apply(i, updates, rates, 1 - retention);
+                             }
+                           }
+                         },
+                         [&](Event* batchBegin, Event* batchEnd, const int64_t* assignments){
+                           for(; batchBegin != batchEnd; ++batchBegin, ++assignments){
+                             _handlerIiwkCluster(_iiwkClusterEventFromEvent(*batchBegin, *assignments));
+                           }
+                         });
     }
 
   protected:
+    /// winnerRate returns the learning rate of the nearest center
+    double winnerRate(double minimum, double sumOfDistances) const {
+      const auto rate = _ksi1*(
+                               (_npow+1)*std::pow(minimum,_npow-1)
+                               +_npow*std::pow(minimum, _npow-2)*(sumOfDistances-minimum)
+                               );
+      return (rate > 1) ? 1 : rate;
+    }
+
+    /// loserRate returns the learning rate of another center
+    double loserRate(double minimum, double distance) const {
+      return _ksi2*std::pow(minimum,_npow)/distance;
+    }
+
+    /// apply moves a center by fraction towards the weighted mean of the contexts of its updates
+    void apply(uint64_t i, const std::vector<MiniBatchUpdates>& updates, double rates, double fraction){
+      if(normalize){
+        _sumOfCenters[i] = 0.;
+      }
+      for(std::size_t j = 0; j < neighborhood; j++){
+        auto weightedContext = 0.;
+        for(auto&& threadUpdates: updates){
+          weightedContext+=threadUpdates.weightedContexts[i*neighborhood + j];
+        }
+        double it = Precision::decode(_centers[i][j]);
+        it+=fraction*(weightedContext/rates - it);
+        if(it <= 0){
+          it = 0;
+        }else{
+          if(it > 1){
+            it = 1;
+          }
+        }
+        _centers[i][j] = Precision::encode(it);
+        if(normalize){
+          _sumOfCenters[i]+=Precision::decode(_centers[i][j]);
+        }
+      }
+      refresh(i);
+    }
+
+    /// decode converts a context or a center to the compute type of the precision policy
+    template<typename Values>
+    static std::array<typename Precision::Compute, neighborhood> decode(const Values& values){
+      std::array<typename Precision::Compute, neighborhood> decoded;
+      for(std::size_t i = 0; i < neighborhood; i++){
+        decoded[i] = Precision::decode(values[i]);
+      }
+      return decoded;
+    }
+
+    /// batch handles the events one at a time
+    void batch(Event* begin, Event* end, std::false_type){
+      for(; begin != end; ++begin){
+        IiwkCluster::operator()(*begin);
+      }
+    }
+
+    /// batch computes the distances between a batch of contexts and every center, then sends the events in order
+    void batch(Event* begin, Event* end, std::true_type){
+      while(begin != end){
+        const auto size = (end - begin < static_cast<std::ptrdiff_t>(batchSize)) ? static_cast<std::size_t>(end - begin) : batchSize;
+        for(std::size_t c = 0; c < size; c++){
+          _batch[c] = normalized(begin[c].context);
+        }
+        batchDistances(size, typename AcceptsCenterSquares<IiwkClusterMetric, typename Precision::Compute>::type());
+        for(std::size_t c = 0; c < size; c++){
+          const auto distances = _batchDistances.data() + c*nCenters;
+          double minimum;
+          int64_t out_p;
+          for(uint64_t i = 0; i < nCenters; i++){
+            if(i == 0 || minimum > distances[i]){
+              minimum = distances[i];
+              out_p = i;
+            }
+          }
+          _handlerIiwkCluster(_iiwkClusterEventFromEvent(begin[c], out_p));
+        }
+        begin += size;
+      }
+    }
+
+    /// refresh updates the normalized copy of a center, which only changes with learning
+    void refresh(uint64_t i){
+      for(std::size_t j = 0; j < neighborhood; j++){
+        _normalizedCenters[i][j] = Precision::decode(_centers[i][j]);
+        if(normalize){
+          _normalizedCenters[i][j]/=_sumOfCenters[i];
+        }
+      }
+      if(AcceptsCenterSquares<IiwkClusterMetric, typename Precision::Compute>::type::value){
+        CenterMatrix::sums(_normalizedCenters[i].data(), 1, neighborhood, _normalizedCenters[i].data(), 1, &_centerSquares[i], SquareTerm());
+      }
+    }
+
+    /// normalized decodes a context, and divides it by its sum when normalize is set
+    template<typename Values>
+    static std::array<typename Precision::Compute, neighborhood> normalized(const Values& values){
+      auto context = decode(values);
+      if(normalize){
+        auto sumOfContext = std::accumulate(context.begin(), context.end(), 0.);
+        for(auto&& it: context){
+          it/=sumOfContext;
+        }
+      }
+      return context;
+    }
+
+    /// normalizedDistances computes the distances between a context, divided by its sum when normalize is set, and every center
+    template<typename Values>
+    void normalizedDistances(const Values& values, double* output){
+      auto context = normalized(values);
+      normalizedDistances(context, output, typename AcceptsCenterSquares<IiwkClusterMetric, typename Precision::Compute>::type());
+    }
+
+    /// normalizedDistances hands the cached squared norms of the centers to the metric
+    void normalizedDistances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::true_type){
+      _iiwkClusterMetric(_normalizedCenters.front().data(), _centerSquares.data(), nCenters, neighborhood, context.data(), 1, output);
+    }
+
+    /// normalizedDistances calls the metric with the centers only
+    void normalizedDistances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::false_type){
+      distances(context, output, typename AcceptsCenterMatrix<IiwkClusterMetric, typename Precision::Compute>::type());
+    }
+
+    /// batchDistances hands the cached squared norms of the centers to the metric
+    void batchDistances(std::size_t size, std::true_type){
+      _iiwkClusterMetric(_normalizedCenters.front().data(), _centerSquares.data(), nCenters, neighborhood, _batch.front().data(), size, _batchDistances.data());
+    }
+
+    /// batchDistances calls the metric with the centers only
+    void batchDistances(std::size_t size, std::false_type){
+      _iiwkClusterMetric(_normalizedCenters.front().data(), nCenters, neighborhood, _batch.front().data(), size, _batchDistances.data());
+    }
+
+    /// distances computes the distances to every center in one pass
+    void distances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::true_type){
+      _iiwkClusterMetric(_normalizedCenters.front().data(), nCenters, neighborhood, context.data(), output);
+    }
+
+    /// distances calls the metric once per center
+    void distances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::false_type){
+      for(uint64_t i = 0; i < nCenters; i++){
+        output[i] = _iiwkClusterMetric(_normalizedCenters[i].begin(),
+                                       _normalizedCenters[i].end(),
+                                       context.begin()
+                                       );
+      }
+    }
+
     double _ksi1;
     double _ksi2;
     double _npow;
@@ -189,8 +1146,19 @@ namespace tarsier {
     IiwkClusterEventFromEvent _iiwkClusterEventFromEvent;
     HandlerIiwkCluster _handlerIiwkCluster;
 
-    std::array<std::array<double, neighborhood>, nCenters> _centers;
+    // the centers are a center-major contiguous matrix, normalized once per learning update
+    // the normalized centers and the batches live on the heap, to keep deep networks built by value within the stack
+    static_assert(sizeof(std::array<typename Precision::Compute, neighborhood>) == neighborhood*sizeof(typename Precision::Compute), "the centers must be contiguous");
+    static_assert(sizeof(std::array<std::array<typename Precision::Value, neighborhood>, nCenters>) == nCenters*neighborhood*sizeof(typename Precision::Value), "the stored centers must be contiguous");
+    std::array<std::array<typename Precision::Value, neighborhood>, nCenters> _centers;
+    std::vector<std::array<typename Precision::Compute, neighborhood>> _normalizedCenters;
+    std::array<double, nCenters> _centerSquares;
     std::array<double, nCenters> _distances;
+
+    // the batches of contexts are sized to stay in cache along with a tile of centers
+    static constexpr std::size_t batchSize = 16;
+    std::vector<std::array<typename Precision::Compute, neighborhood>> _batch;
+    std::vector<double> _batchDistances;
     std::array<double, nCenters> _sumOfCenters;
   };
 
@@ -202,11 +1170,12 @@ namespace tarsier {
     std::size_t neighborhood,
     bool normalize,
     bool isLearning,
-    typename Event, // require at least a field .context
+    typename Event, // require at least a field .context, whose values are Precision::Value
     typename StdClusterEvent,
-    typename StdClusterMetric, // double f(std::array<double,neighborhood> iterator center begin,std::array<double,neighborhood> iterator center end,std::array<double,neighborhood> iterator context begin)
-    typename StdClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity)
-    typename HandlerStdCluster // void f(IiwkClusterEvent)
+    typename StdClusterMetric, // double f(std::array<Precision::Compute,neighborhood> iterator center begin,std::array<Precision::Compute,neighborhood> iterator center end,std::array<Precision::Compute,neighborhood> iterator context begin)
+    typename StdClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity), the event may be moved
+    typename HandlerStdCluster, // void f(IiwkClusterEvent)
+    typename Precision = DoublePrecision
     >
   class StdCluster{
   public:
@@ -220,21 +1189,25 @@ namespace tarsier {
       _stdClusterMetric(std::forward<StdClusterMetric>(stdClusterMetric)),
       _stdClusterEventFromEvent(std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent)),
       _handlerStdCluster(std::forward<HandlerStdCluster>(handlerStdCluster)),
+      _normalizedCenters(nCenters),
+      _batch(batchSize),
+      _batchDistances(batchSize*nCenters),
       _first(0)
     {
       for(auto&& it: _distances){
         it = 0.;
       }
       for(auto&& it: _centers){
-        for(auto&& it2: it){
-          it2 = 0.5;
-        }
+        it.fill(Precision::encode(0.5));
       }
       for(auto&& it: _activity){
         it = 0;
       }
       for(auto&& it: _sumOfCenters){
-        it = 0.5*neighborhood;
+        it = Precision::decode(Precision::encode(0.5))*neighborhood;
+      }
+      for(uint64_t i = 0; i < nCenters; i++){
+        refresh(i);
       }
     }
 
@@ -252,26 +1225,61 @@ namespace tarsier {
                  StdClusterEvent,
                  StdClusterMetric,
                  StdClusterEventFromEvent,
-                 HandlerStdCluster>
+                 HandlerStdCluster,
+                 Precision>
     (baseLearningRate,
      baseLearningActivity,
      std::forward<StdClusterMetric>(stdClusterMetric),
      std::forward<StdClusterEventFromEvent>(stdClusterEventFromEvent),
      std::forward<HandlerStdCluster>(handlerStdCluster))
     {
-      auto cpt = 0;
-      for(auto&& it: _centers){
-        for(auto&& it2: _centers){
-          it2 = centers[cpt++];
+      for(uint64_t i = 0; i < nCenters; i++){
+        _sumOfCenters[i] = 0.;
+        for(std::size_t j = 0; j < neighborhood; j++){
+          _centers[i][j] = Precision::encode(centers[i][j]);
+          _sumOfCenters[i] += Precision::decode(_centers[i][j]);
         }
+        refresh(i);
       }
     }
 
     virtual ~StdCluster() {}
-    virtual std::array<std::array<double, neighborhood>, nCenters> getCenters() const{
+    virtual std::array<std::array<typename Precision::Value, neighborhood>, nCenters> getCenters() const{
       return _centers;
     }
 
+    /// save writes the centers and the learning state to a binary checkpoint (see ClusterCheckpoint)
+    void save(std::ostream& stream) const {
+      const auto header = ClusterCheckpoint::header<typename Precision::Value>(ClusterCheckpoint::Kind::standard, nCenters, neighborhood, _first);
+      ClusterCheckpoint::write(stream, &header, sizeof(header));
+      ClusterCheckpoint::write(stream, _centers.data(), sizeof(_centers));
+      ClusterCheckpoint::write(stream, _sumOfCenters.data(), sizeof(_sumOfCenters));
+      ClusterCheckpoint::write(stream, _activity.data(), sizeof(_activity));
+    }
+
+    /// load restores a checkpoint written by save, and throws if it was saved by a different cluster type
+    void load(std::istream& stream){
+      const auto data = ClusterCheckpoint::read(stream, ClusterCheckpoint::size<typename Precision::Value>(ClusterCheckpoint::Kind::standard, nCenters, neighborhood));
+      load(data.data(), data.size());
+    }
+
+    /// load restores a checkpoint held in memory, for instance a memory-mapped file
+    void load(const char* data, std::size_t size){
+      ClusterCheckpoint::Reader reader(data, size);
+      const auto header = reader.header(ClusterCheckpoint::header<typename Precision::Value>(ClusterCheckpoint::Kind::standard, nCenters, neighborhood, 0),
+                                        ClusterCheckpoint::size<typename Precision::Value>(ClusterCheckpoint::Kind::standard, nCenters, neighborhood));
+      if(header.first < 0 || header.first > static_cast<int64_t>(nCenters)){
+        throw std::runtime_error("the checkpoint first index is out of range");
+      }
+      reader.read(_centers.data(), sizeof(_centers));
+      reader.read(_sumOfCenters.data(), sizeof(_sumOfCenters));
+      reader.read(_activity.data(), sizeof(_activity));
+      _first = header.first;
+      for(uint64_t i = 0; i < nCenters; i++){
+        refresh(i);
+      }
+    }
+
     /*virtual void setCenters(std::vector<std::array<double,neighborhood> > newCenters){
       if(newCenters.size() != _centers.size()){
       std::cout << "Error: waiting for centers of size " << _centers.size() << " instead of " << newCenters.size() << std::endl;
@@ -295,25 +1303,8 @@ namespace tarsier {
       int64_t out_p;
 
       if(isLearning == false || _first >= nCenters){
-        auto context = ev.context;
-        if(normalize){
-          auto sumOfContext = std::accumulate(context.begin(), context.end(), 0.);
-          for(auto&& it: context){
-            it/=sumOfContext;
-          }
-        }
+        normalizedDistances(ev.context, _distances.data());
         for(uint64_t i = 0; i < nCenters; i++){
-          auto curCenter = _centers[i];
-          if(normalize){
-            for(auto&& it: curCenter){
-              it/=_sumOfCenters[i];
-            }
-          }
-          _distances[i] = _stdClusterMetric(curCenter.begin(),
-                                            curCenter.end(),
-                                            context.begin()
-                                            );
-
           if(i == 0 || minimum > _distances[i]){
             minimum = _distances[i];
             out_p = i;
@@ -325,10 +1316,12 @@ namespace tarsier {
         if(isLearning){
           auto cpt = 0;
           auto scal_prod = 0., scal_context = 0., scal_center = 0.;
-          for(auto&& it: _centers[out_p]){
-            scal_prod+=(it*ev.context[cpt]);
+          for(auto&& stored: _centers[out_p]){
+            double it = Precision::decode(stored);
+            double contextValue = Precision::decode(ev.context[cpt]);
+            scal_prod+=(it*contextValue);
             scal_center+=(it*it);
-            scal_context+=(ev.context[cpt]*ev.context[cpt]);
+            scal_context+=(contextValue*contextValue);
             cpt++;
           }
           auto beta = scal_prod / sqrt(scal_center*scal_context);
@@ -339,19 +1332,22 @@ namespace tarsier {
             _sumOfCenters[out_p] = 0.;
           }
           cpt = 0;
-          for(auto&& it: _centers[out_p]){
-            it+=alpha*beta*(ev.context[cpt++]-it);
+          for(auto&& stored: _centers[out_p]){
+            double it = Precision::decode(stored);
+            it+=alpha*beta*(Precision::decode(ev.context[cpt++])-it);
             if(it < 0){
               it = 0;
             }else{
               if(it > 1){
                 it = 1;
               }
-              if(normalize){
-                _sumOfCenters[out_p]+=it;
-              }
+            }
+            stored = Precision::encode(it);
+            if(normalize){
+              _sumOfCenters[out_p]+=Precision::decode(stored);
             }
           }
+          refresh(out_p);
         }
       }else{
         out_p = _first++;
@@ -359,26 +1355,244 @@ namespace tarsier {
         _sumOfCenters[out_p] = 0.;
         for(auto&& it: _centers[out_p]){
           it = ev.context[cpt++];
-          _sumOfCenters[out_p]+=it;
+          _sumOfCenters[out_p]+=Precision::decode(it);
         }
+        refresh(out_p);
       }
 
       /// Send
-      _handlerStdCluster(_stdClusterEventFromEvent(ev, out_p));
+      _handlerStdCluster(_stdClusterEventFromEvent(std::move(ev), out_p));
+    }
+
+    /// operator() handles a contiguous range of events
+    /// Without learning, the events are classified by batches, with one pass over the centers per batch.
+    void operator()(Event* begin, Event* end){
+      batch(begin, end, std::integral_constant<bool, !isLearning && AcceptsContextMatrix<StdClusterMetric, typename Precision::Compute>::type::value>());
+    }
+
+    /// learn updates the centers with a range of events by mini-batches on numberOfThreads threads (the caller included), and sends the events in order.
+    /// Within a mini-batch, every event is assigned with the same centers, and the updates of the events are merged before being applied (see MiniBatchUpdates).
+    /// The activity term of the learning rate is averaged over the events of a center within a mini-batch.
+    /// The first events, which initialize the centers, are handled one at a time.
+    /// The metric is called concurrently and must be thread-safe. The handler is called from the caller thread.
+    void learn(Event* begin, Event* end, std::size_t numberOfThreads, std::size_t miniBatchSize = 1024){
+      static_assert(isLearning, "learn requires a learning cluster");
+      for(; begin != end && _first < static_cast<int64_t>(nCenters); ++begin){
+        StdCluster::operator()(*begin);
+      }
+      std::vector<MiniBatchUpdates> updates(numberOfThreads, MiniBatchUpdates(nCenters, neighborhood));
+      learnByMiniBatches(begin, end, numberOfThreads, miniBatchSize,
+                         [&](std::size_t thread, Event* sliceBegin, Event* sliceEnd, int64_t* assignments){
+                           updates[thread].clear();
+                           std::array<double, nCenters> eventDistances;
+                           for(; sliceBegin != sliceEnd; ++sliceBegin, ++assignments){
+                             normalizedDistances(sliceBegin->context, eventDistances.data());
+                             double minimum;
+                             int64_t out_p;
+                             for(uint64_t i = 0; i < nCenters; i++){
+                               if(i == 0 || minimum > eventDistances[i]){
+                                 minimum = eventDistances[i];
+                                 out_p = i;
+                               }
+                             }
+                             *assignments = out_p;
+                             const auto values = decode(sliceBegin->context);
+                             auto scal_prod = 0., scal_context = 0., scal_center = 0.;
+                             for(std::size_t j = 0; j < neighborhood; j++){
+                               double it = Precision::decode(_centers[out_p][j]);
+                               scal_prod+=(it*values[j]);
+                               scal_center+=(it*it);
+                               scal_context+=(values[j]*values[j]);
+                             }
+                             // the activity term of the rate is applied per center once the mini-batch is complete
+                             updates[thread].add(out_p, scal_prod / sqrt(scal_center*scal_context), values);
+                           }
+                         },
+                         [&](std::size_t thread){
+                           for(uint64_t i = nCenters*thread/numberOfThreads; i < nCenters*(thread + 1)/numberOfThreads; i++){
+                             int64_t count = 0;
+                             auto rates = 0.;
+                             for(auto&& threadUpdates: updates){
+                               count+=threadUpdates.counts[i];
+                               rates+=threadUpdates.rates[i];
+                             }
+                             if(count > 0 && rates > 0){
+                               // the activity term decreases linearly, hence its average is its value in the middle of the mini-batch
+                               auto alpha = _baseLearningRate * (1 - (_activity[i] + (count + 1)/2.)/_baseLearningActivity);
+                               alpha = (alpha > 0.) ? alpha : 0.;
+                               const auto rate = std::min(alpha*rates/count, 1.);
+                               apply(i, updates, rates, 1 - std::pow(1 - rate, static_cast<double>(count)));
+                             }
+                             _activity[i]+=count;
+                           }
+                         },
+                         [&](Event* batchBegin, Event* batchEnd, const int64_t* assignments){
+                           for(; batchBegin != batchEnd; ++batchBegin, ++assignments){
+                             _handlerStdCluster(_stdClusterEventFromEvent(*batchBegin, *assignments));
+                           }
+                         });
     }
 
   protected:
+    /// apply moves a center by fraction towards the weighted mean of the contexts of its updates
+    void apply(uint64_t i, const std::vector<MiniBatchUpdates>& updates, double rates, double fraction){
+      if(normalize){
+        _sumOfCenters[i] = 0.;
+      }
+      for(std::size_t j = 0; j < neighborhood; j++){
+        auto weightedContext = 0.;
+        for(auto&& threadUpdates: updates){
+          weightedContext+=threadUpdates.weightedContexts[i*neighborhood + j];
+        }
+        double it = Precision::decode(_centers[i][j]);
+        it+=fraction*(weightedContext/rates - it);
+        if(it < 0){
+          it = 0;
+        }else{
+          if(it > 1){
+            it = 1;
+          }
+        }
+        _centers[i][j] = Precision::encode(it);
+        if(normalize){
+          _sumOfCenters[i]+=Precision::decode(_centers[i][j]);
+        }
+      }
+      refresh(i);
+    }
+
+    /// decode converts a context or a center to the compute type of the precision policy
+    template<typename Values>
+    static std::array<typename Precision::Compute, neighborhood> decode(const Values& values){
+      std::array<typename Precision::Compute, neighborhood> decoded;
+      for(std::size_t i = 0; i < neighborhood; i++){
+        decoded[i] = Precision::decode(values[i]);
+      }
+      return decoded;
+    }
+
+    /// batch handles the events one at a time
+    void batch(Event* begin, Event* end, std::false_type){
+      for(; begin != end; ++begin){
+        StdCluster::operator()(*begin);
+      }
+    }
+
+    /// batch computes the distances between a batch of contexts and every center, then sends the events in order
+    void batch(Event* begin, Event* end, std::true_type){
+      while(begin != end){
+        const auto size = (end - begin < static_cast<std::ptrdiff_t>(batchSize)) ? static_cast<std::size_t>(end - begin) : batchSize;
+        for(std::size_t c = 0; c < size; c++){
+          _batch[c] = normalized(begin[c].context);
+        }
+        batchDistances(size, typename AcceptsCenterSquares<StdClusterMetric, typename Precision::Compute>::type());
+        for(std::size_t c = 0; c < size; c++){
+          const auto distances = _batchDistances.data() + c*nCenters;
+          double minimum;
+          int64_t out_p;
+          for(uint64_t i = 0; i < nCenters; i++){
+            if(i == 0 || minimum > distances[i]){
+              minimum = distances[i];
+              out_p = i;
+            }
+          }
+          _activity[out_p]++;
+          _handlerStdCluster(_stdClusterEventFromEvent(begin[c], out_p));
+        }
+        begin += size;
+      }
+    }
+
+    /// refresh updates the normalized copy of a center, which only changes with learning
+    void refresh(uint64_t i){
+      for(std::size_t j = 0; j < neighborhood; j++){
+        _normalizedCenters[i][j] = Precision::decode(_centers[i][j]);
+        if(normalize){
+          _normalizedCenters[i][j]/=_sumOfCenters[i];
+        }
+      }
+      if(AcceptsCenterSquares<StdClusterMetric, typename Precision::Compute>::type::value){
+        CenterMatrix::sums(_normalizedCenters[i].data(), 1, neighborhood, _normalizedCenters[i].data(), 1, &_centerSquares[i], SquareTerm());
+      }
+    }
+
+    /// normalized decodes a context, and divides it by its sum when normalize is set
+    template<typename Values>
+    static std::array<typename Precision::Compute, neighborhood> normalized(const Values& values){
+      auto context = decode(values);
+      if(normalize){
+        auto sumOfContext = std::accumulate(context.begin(), context.end(), 0.);
+        for(auto&& it: context){
+          it/=sumOfContext;
+        }
+      }
+      return context;
+    }
+
+    /// normalizedDistances computes the distances between a context, divided by its sum when normalize is set, and every center
+    template<typename Values>
+    void normalizedDistances(const Values& values, double* output){
+      auto context = normalized(values);
+      normalizedDistances(context, output, typename AcceptsCenterSquares<StdClusterMetric, typename Precision::Compute>::type());
+    }
+
+    /// normalizedDistances hands the cached squared norms of the centers to the metric
+    void normalizedDistances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::true_type){
+      _stdClusterMetric(_normalizedCenters.front().data(), _centerSquares.data(), nCenters, neighborhood, context.data(), 1, output);
+    }
+
+    /// normalizedDistances calls the metric with the centers only
+    void normalizedDistances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::false_type){
+      distances(context, output, typename AcceptsCenterMatrix<StdClusterMetric, typename Precision::Compute>::type());
+    }
+
+    /// batchDistances hands the cached squared norms of the centers to the metric
+    void batchDistances(std::size_t size, std::true_type){
+      _stdClusterMetric(_normalizedCenters.front().data(), _centerSquares.data(), nCenters, neighborhood, _batch.front().data(), size, _batchDistances.data());
+    }
+
+    /// batchDistances calls the metric with the centers only
+    void batchDistances(std::size_t size, std::false_type){
+      _stdClusterMetric(_normalizedCenters.front().data(), nCenters, neighborhood, _batch.front().data(), size, _batchDistances.data());
+    }
+
+    /// distances computes the distances to every center in one pass
+    void distances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::true_type){
+      _stdClusterMetric(_normalizedCenters.front().data(), nCenters, neighborhood, context.data(), output);
+    }
+
+    /// distances calls the metric once per center
+    void distances(std::array<typename Precision::Compute, neighborhood>& context, double* output, std::false_type){
+      for(uint64_t i = 0; i < nCenters; i++){
+        output[i] = _stdClusterMetric(_normalizedCenters[i].begin(),
+                                      _normalizedCenters[i].end(),
+                                      context.begin()
+                                      );
+      }
+    }
+
     double _baseLearningRate;
     double _baseLearningActivity;
     StdClusterMetric _stdClusterMetric;
     StdClusterEventFromEvent _stdClusterEventFromEvent;
     HandlerStdCluster _handlerStdCluster;
 
-    std::array<std::array<double, neighborhood>, nCenters> _centers;
+    // the centers are a center-major contiguous matrix, normalized once per learning update
+    // the normalized centers and the batches live on the heap, to keep deep networks built by value within the stack
+    static_assert(sizeof(std::array<typename Precision::Compute, neighborhood>) == neighborhood*sizeof(typename Precision::Compute), "the centers must be contiguous");
+    static_assert(sizeof(std::array<std::array<typename Precision::Value, neighborhood>, nCenters>) == nCenters*neighborhood*sizeof(typename Precision::Value), "the stored centers must be contiguous");
+    std::array<std::array<typename Precision::Value, neighborhood>, nCenters> _centers;
+    std::vector<std::array<typename Precision::Compute, neighborhood>> _normalizedCenters;
+    std::array<double, nCenters> _centerSquares;
     std::array<double, nCenters> _distances;
+
+    // the batches of contexts are sized to stay in cache along with a tile of centers
+    static constexpr std::size_t batchSize = 16;
+    std::vector<std::array<typename Precision::Compute, neighborhood>> _batch;
+    std::vector<double> _batchDistances;
     std::array<double, nCenters> _sumOfCenters;
     std::array<int64_t, nCenters> _activity;
-    int _first;
+    int64_t _first;
   };
 
   //------------------------------------------------------------------------------------------\\
@@ -392,6 +1606,7 @@ namespace tarsier {
     bool isLearning,
     typename Event,
     typename IiwkClusterEvent,
+    typename Precision = DoublePrecision,
     typename IiwkClusterMetric,
     typename IiwkClusterEventFromEvent,
     typename HandlerIiwkCluster
@@ -404,7 +1619,8 @@ namespace tarsier {
               IiwkClusterEvent,
               IiwkClusterMetric,
               IiwkClusterEventFromEvent,
-              HandlerIiwkCluster>
+              HandlerIiwkCluster,
+              Precision>
   make_iiwkCluster(double ksi1,
                    double ksi2,
                    double npow,
@@ -420,7 +1636,8 @@ namespace tarsier {
                        IiwkClusterEvent,
                        IiwkClusterMetric,
                        IiwkClusterEventFromEvent,
-                       HandlerIiwkCluster>
+                       HandlerIiwkCluster,
+                       Precision>
       (ksi1,
        ksi2,
        npow,
@@ -438,6 +1655,7 @@ namespace tarsier {
     bool isLearning,
     typename Event,
     typename IiwkClusterEvent,
+    typename Precision = DoublePrecision,
     typename IiwkClusterMetric,
     typename IiwkClusterEventFromEvent,
     typename HandlerIiwkCluster
@@ -450,7 +1668,8 @@ namespace tarsier {
               IiwkClusterEvent,
               IiwkClusterMetric,
               IiwkClusterEventFromEvent,
-              HandlerIiwkCluster>
+              HandlerIiwkCluster,
+              Precision>
   make_iiwkCluster(double ksi1,
                    double ksi2,
                    double npow,
@@ -467,7 +1686,8 @@ namespace tarsier {
                        IiwkClusterEvent,
                        IiwkClusterMetric,
                        IiwkClusterEventFromEvent,
-                       HandlerIiwkCluster>
+                       HandlerIiwkCluster,
+                       Precision>
       (ksi1,
        ksi2,
        npow,
@@ -488,7 +1708,8 @@ namespace tarsier {
     bool isLearning,
     typename Event, // require at least a field .context
     typename StdClusterEvent,
-    typename StdClusterMetric, // double f(std::array<double,neighborhood> iterator center begin,std::array<double,neighborhood> iterator center end,std::array<double,neighborhood> iterator context begin)
+    typename Precision = DoublePrecision,
+    typename StdClusterMetric, // double f(std::array<Precision::Compute,neighborhood> iterator center begin,std::array<Precision::Compute,neighborhood> iterator center end,std::array<Precision::Compute,neighborhood> iterator context begin)
     typename StdClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity)
     typename HandlerStdCluster // void f(IiwkClusterEvent)
     >
@@ -500,7 +1721,8 @@ namespace tarsier {
              StdClusterEvent,
              StdClusterMetric,
              StdClusterEventFromEvent,
-             HandlerStdCluster>
+             HandlerStdCluster,
+             Precision>
   make_stdCluster(double baseLearningRate,
                   double baseLearningActivity,
                   StdClusterMetric stdClusterMetric,
@@ -515,7 +1737,8 @@ namespace tarsier {
                       StdClusterEvent,
                       StdClusterMetric,
                       StdClusterEventFromEvent,
-                      HandlerStdCluster>
+                      HandlerStdCluster,
+                      Precision>
       (baseLearningRate,
        baseLearningActivity,
        std::forward<StdClusterMetric>(stdClusterMetric),
@@ -532,7 +1755,8 @@ namespace tarsier {
     bool isLearning,
     typename Event, // require at least a field .context
     typename StdClusterEvent,
-    typename StdClusterMetric, // double f(std::array<double,neighborhood> iterator center begin,std::array<double,neighborhood> iterator center end,std::array<double,neighborhood> iterator context begin)
+    typename Precision = DoublePrecision,
+    typename StdClusterMetric, // double f(std::array<Precision::Compute,neighborhood> iterator center begin,std::array<Precision::Compute,neighborhood> iterator center end,std::array<Precision::Compute,neighborhood> iterator context begin)
     typename StdClusterEventFromEvent, // IiwkClusterEvent f(Event,out_polarity)
     typename HandlerStdCluster // void f(IiwkClusterEvent)
     >
@@ -544,7 +1768,8 @@ namespace tarsier {
              StdClusterEvent,
              StdClusterMetric,
              StdClusterEventFromEvent,
-             HandlerStdCluster>
+             HandlerStdCluster,
+             Precision>
   make_stdCluster(double baseLearningRate,
                   double baseLearningActivity,
                   std::array<std::array<double, neighborhood>, nCenters> centers,
@@ -560,7 +1785,8 @@ namespace tarsier {
                       StdClusterEvent,
                       StdClusterMetric,
                       StdClusterEventFromEvent,
-                      HandlerStdCluster>
+                      HandlerStdCluster,
+                      Precision>
       (baseLearningRate,
        baseLearningActivity,
        centers,
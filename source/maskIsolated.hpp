@@ -4,6 +4,7 @@
 #include <utility>
 #include <vector>
 #include <limits>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -25,19 +26,36 @@ namespace tarsier {
 
             /// operator() handles an event.
             virtual void operator()(Event event) {
+                if (isNotIsolated(event)) {
+                    forwardEvent(_handleEvent, event);
+                }
+            }
+
+            /// operator() handles a contiguous range of events.
+            /// The events that are not isolated are compacted in place and forwarded.
+            void operator()(Event* begin, Event* end) {
+                auto outputIterator = begin;
+                for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                    *outputIterator = *eventIterator;
+                    outputIterator += isNotIsolated(*eventIterator);
+                }
+                forwardEvents(_handleEvent, begin, outputIterator);
+            }
+
+        protected:
+
+            /// isNotIsolated updates the timestamps and checks the event's neighbours.
+            bool isNotIsolated(const Event& event) {
                 const auto index = event.x + event.y * width;
                 _timestamps[index] = event.timestamp + decay;
-                if (
+                return (
                     (event.x > 0 && _timestamps[index - 1] > event.timestamp)
                     || (event.x < width - 1 && _timestamps[index + 1] > event.timestamp)
                     || (event.y > 0 && _timestamps[index - width] > event.timestamp)
                     || (event.y < height - 1 && _timestamps[index + width] > event.timestamp)
-                ) {
-                    _handleEvent(event);
-                }
+                );
             }
 
-        protected:
             HandleEvent _handleEvent;
             std::vector<uint64_t> _timestamps;
     };
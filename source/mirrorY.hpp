@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <utility>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -23,7 +24,15 @@ namespace tarsier {
             /// operator() handles an event.
             virtual void operator()(Event event) {
                 event.y = height - 1 - event.y;
-                _handleEvent(event);
+                forwardEvent(_handleEvent, event);
+            }
+
+            /// operator() handles a contiguous range of events, which are modified in place.
+            void operator()(Event* begin, Event* end) {
+                for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                    eventIterator->y = height - 1 - eventIterator->y;
+                }
+                forwardEvents(_handleEvent, begin, end);
             }
 
         protected:
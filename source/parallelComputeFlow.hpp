@@ -0,0 +1,272 @@
+#pragma once
+
+#include "computeFlow.hpp"
+#include "ringBuffer.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// ParallelComputeFlow evaluates the optical flow with one worker thread per spatial tile.
+    /// The sensor is split in horizontalTiles x verticalTiles tiles. Each tile keeps its own timestamps
+    /// for its pixels and a halo of window pixels around them, hence events near a tile border are sent to several tiles.
+    /// The flow events are identical to the ones produced by ComputeFlow.
+    /// FlowEventFromEvent and HandleFlowEvent are called from the worker threads, and must be thread-safe.
+    /// The flow events produced by a given tile are timestamp-ordered.
+    template <
+        typename Event,
+        typename FlowEvent,
+        uint64_t width,
+        uint64_t height,
+        uint64_t window,
+        std::size_t numberOfMostRecentEvents,
+        uint64_t lifespan,
+        uint64_t horizontalTiles,
+        uint64_t verticalTiles,
+        typename FlowEventFromEvent,
+        typename HandleFlowEvent
+    >
+    class ParallelComputeFlow {
+        static_assert(horizontalTiles > 0 && horizontalTiles <= width, "horizontalTiles must be in the range [1, width]");
+        static_assert(verticalTiles > 0 && verticalTiles <= height, "verticalTiles must be in the range [1, height]");
+        public:
+            ParallelComputeFlow(FlowEventFromEvent flowEventFromEvent, HandleFlowEvent handleFlowEvent, std::size_t queueCapacity = 1 << 16) :
+                _handlers(new Handlers{
+                    std::forward<FlowEventFromEvent>(flowEventFromEvent),
+                    std::forward<HandleFlowEvent>(handleFlowEvent),
+                })
+            {
+                const auto tileWidth = (width + horizontalTiles - 1) / horizontalTiles;
+                const auto tileHeight = (height + verticalTiles - 1) / verticalTiles;
+                for (uint64_t row = 0; row < verticalTiles; ++row) {
+                    for (uint64_t column = 0; column < horizontalTiles; ++column) {
+                        _tiles.emplace_back(new Tile(
+                            column * tileWidth,
+                            std::min(width, (column + 1) * tileWidth),
+                            row * tileHeight,
+                            std::min(height, (row + 1) * tileHeight),
+                            queueCapacity,
+                            _handlers.get()
+                        ));
+                    }
+                }
+            }
+            ParallelComputeFlow(const ParallelComputeFlow&) = delete;
+            ParallelComputeFlow(ParallelComputeFlow&&) = default;
+            ParallelComputeFlow& operator=(const ParallelComputeFlow&) = delete;
+            ParallelComputeFlow& operator=(ParallelComputeFlow&&) = default;
+            virtual ~ParallelComputeFlow() {}
+
+            /// operator() dispatches an event to the tiles whose halo contains it.
+            virtual void operator()(Event event) {
+                for (auto&& tile : _tiles) {
+                    if (tile->containsInHalo(event)) {
+                        tile->push(&event, &event + 1);
+                    }
+                }
+            }
+
+            /// operator() dispatches a contiguous range of events to the tiles.
+            /// Each tile receives the events within its halo as batches.
+            void operator()(Event* begin, Event* end) {
+                for (auto&& tile : _tiles) {
+                    _events.clear();
+                    for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                        if (tile->containsInHalo(*eventIterator)) {
+                            _events.push_back(*eventIterator);
+                        }
+                    }
+                    tile->push(_events.data(), _events.data() + _events.size());
+                }
+            }
+
+            /// flush blocks until every dispatched event has been processed.
+            void flush() {
+                for (auto&& tile : _tiles) {
+                    tile->flush();
+                }
+            }
+
+        protected:
+
+            /// Handlers holds the functors shared by the tiles.
+            struct Handlers {
+                FlowEventFromEvent flowEventFromEvent;
+                HandleFlowEvent handleFlowEvent;
+            };
+
+            /// Tile holds the timestamps of a region with its halo, and the worker thread which processes its events.
+            class Tile {
+                public:
+                    Tile(uint64_t left, uint64_t right, uint64_t bottom, uint64_t top, std::size_t queueCapacity, Handlers* handlers) :
+                        _left(left),
+                        _right(right),
+                        _bottom(bottom),
+                        _top(top),
+                        _haloLeft(left <= window ? 0 : left - window),
+                        _haloRight(std::min(width, right + window)),
+                        _haloBottom(bottom <= window ? 0 : bottom - window),
+                        _haloTop(std::min(height, top + window)),
+                        _handlers(handlers),
+                        _timestamps((_haloRight - _haloLeft) * (_haloTop - _haloBottom), 0),
+                        _queue(queueCapacity),
+                        _pushed(0),
+                        _processed(0),
+                        _running(true)
+                    {
+                        _worker = std::thread([this]() {
+                            work();
+                        });
+                    }
+                    Tile(const Tile&) = delete;
+                    Tile(Tile&&) = delete;
+                    Tile& operator=(const Tile&) = delete;
+                    Tile& operator=(Tile&&) = delete;
+                    virtual ~Tile() {
+                        flush();
+                        _running.store(false, std::memory_order_release);
+                        _worker.join();
+                    }
+
+                    /// containsInHalo determines whether the event lies within the tile or its halo.
+                    bool containsInHalo(const Event& event) const {
+                        return event.x >= _haloLeft && event.x < _haloRight && event.y >= _haloBottom && event.y < _haloTop;
+                    }
+
+                    /// push sends events to the worker, waiting for room in the queue when needed.
+                    void push(const Event* begin, const Event* end) {
+                        _pushed += static_cast<std::size_t>(end - begin);
+                        Backoff backoff;
+                        while (begin != end) {
+                            const auto count = _queue.push(begin, end);
+                            if (count == 0) {
+                                backoff.wait();
+                            } else {
+                                backoff.reset();
+                            }
+                            begin += count;
+                        }
+                    }
+
+                    /// flush waits until the worker has processed every pushed event.
+                    void flush() {
+                        Backoff backoff;
+                        while (_processed.load(std::memory_order_acquire) < _pushed) {
+                            backoff.wait();
+                        }
+                    }
+
+                protected:
+
+                    /// work pops batches of events and computes the flow, until the tile is destroyed.
+                    /// An idle worker backs off to sleeps (see Backoff), so that it does not hold a core while no events arrive.
+                    void work() {
+                        std::vector<Event> events(256);
+                        Backoff backoff;
+                        for (;;) {
+                            const auto count = _queue.pop(events.data(), events.size());
+                            if (count == 0) {
+                                if (!_running.load(std::memory_order_acquire)) {
+                                    return;
+                                }
+                                backoff.wait();
+                                continue;
+                            }
+                            backoff.reset();
+                            for (std::size_t index = 0; index < count; ++index) {
+                                compute(events[index]);
+                            }
+                            _processed.fetch_add(count, std::memory_order_release);
+                        }
+                    }
+
+                    /// compute updates the timestamps and sends the flow event for events within the tile.
+                    void compute(const Event& event) {
+                        const auto x = static_cast<uint64_t>(event.x) - _haloLeft;
+                        const auto y = static_cast<uint64_t>(event.y) - _haloBottom;
+                        _timestamps[x + y * (_haloRight - _haloLeft)] = event.timestamp;
+                        if (event.x >= _left && event.x < _right && event.y >= _bottom && event.y < _top) {
+                            auto vx = 0.0;
+                            auto vy = 0.0;
+                            if (_fitPlane(_timestamps.data(), _haloRight - _haloLeft, _haloTop - _haloBottom, x, y, event.timestamp, vx, vy)) {
+                                _handlers->handleFlowEvent(_handlers->flowEventFromEvent(event, vx, vy));
+                            }
+                        }
+                    }
+
+                    const uint64_t _left;
+                    const uint64_t _right;
+                    const uint64_t _bottom;
+                    const uint64_t _top;
+                    const uint64_t _haloLeft;
+                    const uint64_t _haloRight;
+                    const uint64_t _haloBottom;
+                    const uint64_t _haloTop;
+                    Handlers* _handlers;
+                    std::vector<uint64_t> _timestamps;
+                    FitPlane<window, numberOfMostRecentEvents, lifespan> _fitPlane;
+                    RingBuffer<Event> _queue;
+                    std::size_t _pushed;
+                    std::atomic<std::size_t> _processed;
+                    std::atomic<bool> _running;
+                    std::thread _worker;
+            };
+
+            std::unique_ptr<Handlers> _handlers;
+            std::vector<std::unique_ptr<Tile>> _tiles;
+            std::vector<Event> _events;
+    };
+
+    /// make_parallelComputeFlow creates a multi-threaded optical flow estimator from functors.
+    template <
+        typename Event,
+        typename FlowEvent,
+        uint64_t width,
+        uint64_t height,
+        uint64_t window,
+        std::size_t numberOfMostRecentEvents,
+        uint64_t lifespan,
+        uint64_t horizontalTiles,
+        uint64_t verticalTiles,
+        typename FlowEventFromEvent,
+        typename HandleFlowEvent
+    >
+    ParallelComputeFlow<
+        Event,
+        FlowEvent,
+        width,
+        height,
+        window,
+        numberOfMostRecentEvents,
+        lifespan,
+        horizontalTiles,
+        verticalTiles,
+        FlowEventFromEvent,
+        HandleFlowEvent
+    > make_parallelComputeFlow(FlowEventFromEvent flowEventFromEvent, HandleFlowEvent handleFlowEvent, std::size_t queueCapacity = 1 << 16) {
+        return ParallelComputeFlow<
+            Event,
+            FlowEvent,
+            width,
+            height,
+            window,
+            numberOfMostRecentEvents,
+            lifespan,
+            horizontalTiles,
+            verticalTiles,
+            FlowEventFromEvent,
+            HandleFlowEvent
+        >(
+            std::forward<FlowEventFromEvent>(flowEventFromEvent),
+            std::forward<HandleFlowEvent>(handleFlowEvent),
+            queueCapacity
+        );
+    }
+}
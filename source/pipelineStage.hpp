@@ -0,0 +1,152 @@
+#pragma once
+
+#include "ringBuffer.hpp"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// PipelineStage runs an event handler on its own worker thread.
+    /// Events are sent to the worker through a bounded single-producer single-consumer queue,
+    /// and the worker pops them by batches, so that the synchronisation cost is paid once per batch.
+    /// The handler receives the events in the order they were sent. Chaining stages (for instance one per HOTS layer)
+    /// runs the layers concurrently while keeping the event order of each layer exact.
+    /// Events must be sent from a single thread at a time. HandleEvent is called from the worker thread.
+    /// Copies of a PipelineStage share the same worker, so that stages can be composed by value like the other handlers.
+    /// The worker is drained and joined when the last copy is destroyed.
+    template <typename Event, typename HandleEvent>
+    class PipelineStage {
+        public:
+            PipelineStage(HandleEvent handleEvent, std::size_t queueCapacity = 1 << 16, std::size_t batchSize = 256) :
+                _worker(new Worker(std::forward<HandleEvent>(handleEvent), queueCapacity, batchSize))
+            {
+            }
+            PipelineStage(const PipelineStage&) = default;
+            PipelineStage(PipelineStage&&) = default;
+            PipelineStage& operator=(const PipelineStage&) = default;
+            PipelineStage& operator=(PipelineStage&&) = default;
+            virtual ~PipelineStage() {}
+
+            /// operator() sends an event to the worker, waiting for room in the queue when needed.
+            virtual void operator()(Event event) {
+                _worker->push(&event, &event + 1);
+            }
+
+            /// operator() sends a contiguous range of events to the worker as batches.
+            void operator()(const Event* begin, const Event* end) {
+                _worker->push(begin, end);
+            }
+
+            /// flush blocks until the worker has processed every sent event.
+            /// It must be called from the thread which sends the events, or after the upstream stages have been flushed.
+            /// Events emitted by the handler towards downstream stages are queued, but not necessarily processed, when flush returns.
+            void flush() {
+                _worker->flush();
+            }
+
+        protected:
+
+            /// Worker holds the queue, the handler and the thread which calls it.
+            class Worker {
+                public:
+                    Worker(HandleEvent handleEvent, std::size_t queueCapacity, std::size_t batchSize) :
+                        _handleEvent(std::forward<HandleEvent>(handleEvent)),
+                        _queue(queueCapacity),
+                        _batchSize(batchSize),
+                        _pushed(0),
+                        _processed(0),
+                        _running(true)
+                    {
+                        if (batchSize == 0) {
+                            throw std::logic_error("batchSize must be strictly positive");
+                        }
+                        _thread = std::thread([this]() {
+                            work();
+                        });
+                    }
+                    Worker(const Worker&) = delete;
+                    Worker(Worker&&) = delete;
+                    Worker& operator=(const Worker&) = delete;
+                    Worker& operator=(Worker&&) = delete;
+                    virtual ~Worker() {
+                        flush();
+                        _running.store(false, std::memory_order_release);
+                        _thread.join();
+                    }
+
+                    /// push sends events to the worker, waiting for room in the queue when needed.
+                    void push(const Event* begin, const Event* end) {
+                        _pushed += static_cast<std::size_t>(end - begin);
+                        Backoff backoff;
+                        while (begin != end) {
+                            const auto count = _queue.push(begin, end);
+                            if (count == 0) {
+                                backoff.wait();
+                            } else {
+                                backoff.reset();
+                            }
+                            begin += count;
+                        }
+                    }
+
+                    /// flush waits until the worker has processed every pushed event.
+                    void flush() {
+                        Backoff backoff;
+                        while (_processed.load(std::memory_order_acquire) < _pushed) {
+                            backoff.wait();
+                        }
+                    }
+
+                protected:
+
+                    /// work pops batches of events and calls the handler, until the worker is destroyed.
+                    /// An idle worker backs off to sleeps (see Backoff), so that it does not hold a core between bursts of events.
+                    void work() {
+                        std::vector<Event> events(_batchSize);
+                        Backoff backoff;
+                        for (;;) {
+                            const auto count = _queue.pop(events.data(), events.size());
+                            if (count == 0) {
+                                if (!_running.load(std::memory_order_acquire)) {
+                                    return;
+                                }
+                                backoff.wait();
+                                continue;
+                            }
+                            backoff.reset();
+                            for (std::size_t index = 0; index < count; ++index) {
+                                _handleEvent(events[index]);
+                            }
+                            _processed.fetch_add(count, std::memory_order_release);
+                        }
+                    }
+
+                    HandleEvent _handleEvent;
+                    RingBuffer<Event> _queue;
+                    const std::size_t _batchSize;
+                    std::size_t _pushed;
+                    std::atomic<std::size_t> _processed;
+                    std::atomic<bool> _running;
+                    std::thread _thread;
+            };
+
+            std::shared_ptr<Worker> _worker;
+    };
+
+    /// make_pipelineStage creates a pipeline stage from an event handler.
+    template <typename Event, typename HandleEvent>
+    PipelineStage<Event, HandleEvent> make_pipelineStage(
+        HandleEvent handleEvent,
+        std::size_t queueCapacity = 1 << 16,
+        std::size_t batchSize = 256
+    ) {
+        return PipelineStage<Event, HandleEvent>(std::forward<HandleEvent>(handleEvent), queueCapacity, batchSize);
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+  /// A precision policy sets how the HOTS contexts and centers are stored and computed with:
+  ///     Value is the stored type, which sets the memory bandwidth
+  ///     Compute is the arithmetic type handed to the metrics, which sets the SIMD width
+  ///     encode converts a double to a Value, and decode a Value to a Compute
+  /// Contexts and centers are within [0, 1], which bounds the fixed-point range.
+
+  /// DoublePrecision stores and computes doubles, the historical behaviour
+  class DoublePrecision{
+  public:
+    typedef double Value;
+    typedef double Compute;
+
+    static Value encode(double value){
+      return value;
+    }
+
+    static Compute decode(Value value){
+      return value;
+    }
+  };
+
+  /// SinglePrecision stores and computes floats
+  class SinglePrecision{
+  public:
+    typedef float Value;
+    typedef float Compute;
+
+    static Value encode(double value){
+      return static_cast<Value>(value);
+    }
+
+    static Compute decode(Value value){
+      return value;
+    }
+  };
+
+  /// FixedPrecision16 stores values in [0, 1] as 16 bits unsigned integers, and computes floats
+  /// The quantum is 1/65535: learning rates whose updates are smaller than half a quantum leave the centers unchanged.
+  class FixedPrecision16{
+  public:
+    typedef uint16_t Value;
+    typedef float Compute;
+
+    static Value encode(double value){
+      return static_cast<Value>(std::min(std::max(value, 0.), 1.)*65535. + 0.5);
+    }
+
+    static Compute decode(Value value){
+      return static_cast<Compute>(value)*(1.f/65535.f);
+    }
+  };
+};
@@ -0,0 +1,282 @@
+#pragma once
+
+#include "precision.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <array>
+#include <vector>
+#include <numeric>
+#include <stdexcept>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+  /// ProductQuantizationCluster assigns events to the nearest of fixed centers, such as the centers of a trained IiwkCluster or StdCluster, without a linear scan
+  /// The neighborhood is split into numberOfSubspaces subspaces, and the parts of the centers in each subspace are quantized to numberOfCodes codewords.
+  /// The squared euclidean distances between a context and the codewords are tabulated once per event, and approximate the distance to a center by a sum of numberOfSubspaces lookups.
+  /// The numberOfCandidates nearest centers in the approximation are reranked with the exact metric.
+  /// More subspaces, codes or candidates raise the recall and lower the speed. With as many candidates as centers, the search is exact.
+  /// The shortlist ranks the centers by euclidean distance, so other metrics need enough candidates to contain their nearest center.
+  template<
+    uint64_t nCenters,
+    std::size_t neighborhood,
+    bool normalize,
+    typename Event, // require at least a field .context, whose values are Precision::Value
+    typename ClusterEvent,
+    typename ClusterMetric, // double f(std::array<Precision::Compute,neighborhood> iterator center begin,std::array<Precision::Compute,neighborhood> iterator center end,std::array<Precision::Compute,neighborhood> iterator context begin)
+    typename ClusterEventFromEvent, // ClusterEvent f(Event,out_polarity), the event may be moved
+    typename HandlerCluster, // void f(ClusterEvent)
+    typename Precision = DoublePrecision
+    >
+  class ProductQuantizationCluster{
+  public:
+    ProductQuantizationCluster(const std::array<std::array<typename Precision::Value, neighborhood>, nCenters>& centers,
+                               std::size_t numberOfSubspaces,
+                               std::size_t numberOfCodes,
+                               std::size_t numberOfCandidates,
+                               ClusterMetric clusterMetric,
+                               ClusterEventFromEvent clusterEventFromEvent,
+                               HandlerCluster handlerCluster):
+      _numberOfSubspaces(numberOfSubspaces),
+      _numberOfCodes(std::min<std::size_t>(numberOfCodes, nCenters)),
+      _numberOfCandidates(numberOfCandidates),
+      _clusterMetric(std::forward<ClusterMetric>(clusterMetric)),
+      _clusterEventFromEvent(std::forward<ClusterEventFromEvent>(clusterEventFromEvent)),
+      _handlerCluster(std::forward<HandlerCluster>(handlerCluster)),
+      _normalizedCenters(nCenters),
+      _codewords(_numberOfCodes*neighborhood),
+      _codes(nCenters*numberOfSubspaces),
+      _table(numberOfSubspaces*_numberOfCodes),
+      _approximations(nCenters),
+      _candidates(nCenters)
+    {
+      if(numberOfSubspaces == 0 || numberOfSubspaces > neighborhood){
+        throw std::logic_error("numberOfSubspaces must be within [1, neighborhood]");
+      }
+      if(numberOfCodes == 0 || numberOfCodes > 256){
+        throw std::logic_error("numberOfCodes must be within [1, 256]");
+      }
+      if(numberOfCandidates == 0 || numberOfCandidates > nCenters){
+        throw std::logic_error("numberOfCandidates must be within [1, nCenters]");
+      }
+      for(uint64_t i = 0; i < nCenters; i++){
+        auto sumOfCenter = 0.;
+        for(std::size_t j = 0; j < neighborhood; j++){
+          _normalizedCenters[i][j] = Precision::decode(centers[i][j]);
+          sumOfCenter += _normalizedCenters[i][j];
+        }
+        if(normalize){
+          for(auto&& it: _normalizedCenters[i]){
+            it/=sumOfCenter;
+          }
+        }
+      }
+      for(std::size_t m = 0; m < _numberOfSubspaces; m++){
+        quantize(m);
+      }
+    }
+
+    virtual ~ProductQuantizationCluster(){}
+
+    virtual void operator()(Event ev){
+      /// Approximate
+      auto context = normalized(ev.context);
+      for(std::size_t m = 0; m < _numberOfSubspaces; m++){
+        const auto first = subspaceBegin(m);
+        const auto size = subspaceBegin(m + 1) - first;
+        for(std::size_t k = 0; k < _numberOfCodes; k++){
+          const auto codeword = _codewords.data() + _numberOfCodes*first + k*size;
+          auto distance = 0.;
+          for(std::size_t j = 0; j < size; j++){
+            const auto difference = codeword[j] - context[first + j];
+            distance += difference*difference;
+          }
+          _table[m*_numberOfCodes + k] = distance;
+        }
+      }
+      for(uint64_t i = 0; i < nCenters; i++){
+        const auto codes = _codes.data() + i*_numberOfSubspaces;
+        auto distance = 0.;
+        for(std::size_t m = 0; m < _numberOfSubspaces; m++){
+          distance += _table[m*_numberOfCodes + codes[m]];
+        }
+        _approximations[i] = distance;
+      }
+
+      /// Rerank
+      std::iota(_candidates.begin(), _candidates.end(), 0);
+      if(_numberOfCandidates < nCenters){
+        std::nth_element(_candidates.begin(), _candidates.begin() + (_numberOfCandidates - 1), _candidates.end(), [this](uint64_t first, uint64_t second){
+            return _approximations[first] < _approximations[second];
+          });
+      }
+      double minimum;
+      int64_t out_p = -1;
+      for(std::size_t r = 0; r < _numberOfCandidates; r++){
+        const auto i = _candidates[r];
+        const auto distance = _clusterMetric(_normalizedCenters[i].begin(), _normalizedCenters[i].end(), context.begin());
+        if(out_p < 0 || minimum > distance || (minimum == distance && static_cast<int64_t>(i) < out_p)){
+          minimum = distance;
+          out_p = i;
+        }
+      }
+
+      /// Send
+      _handlerCluster(_clusterEventFromEvent(std::move(ev), out_p));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        ProductQuantizationCluster::operator()(*begin);
+      }
+    }
+
+    /// getCodes returns the codeword index of every center in every subspace, center-major
+    const std::vector<uint8_t>& getCodes() const {
+      return _codes;
+    }
+
+  protected:
+    /// subspaceBegin returns the first index of a subspace, the subspaces sizes differing by one at most
+    std::size_t subspaceBegin(std::size_t m) const {
+      return m*neighborhood/_numberOfSubspaces;
+    }
+
+    /// quantize runs a k-means over the parts of the normalized centers in a subspace, and stores the codewords and the codes
+    /// The codewords start from evenly spaced centers, and a codeword left without centers keeps its value.
+    void quantize(std::size_t m){
+      const auto first = subspaceBegin(m);
+      const auto size = subspaceBegin(m + 1) - first;
+      const auto codewords = _codewords.data() + _numberOfCodes*first;
+      for(std::size_t k = 0; k < _numberOfCodes; k++){
+        const auto& center = _normalizedCenters[k*nCenters/_numberOfCodes];
+        std::copy(center.begin() + first, center.begin() + first + size, codewords + k*size);
+      }
+      std::vector<std::size_t> counts(_numberOfCodes);
+      std::vector<double> sums(_numberOfCodes*size);
+      for(auto iteration = 0; iteration < 32; iteration++){
+        auto changed = false;
+        for(uint64_t i = 0; i < nCenters; i++){
+          auto minimum = 0.;
+          std::size_t code = 0;
+          for(std::size_t k = 0; k < _numberOfCodes; k++){
+            auto distance = 0.;
+            for(std::size_t j = 0; j < size; j++){
+              const auto difference = codewords[k*size + j] - _normalizedCenters[i][first + j];
+              distance += difference*difference;
+            }
+            if(k == 0 || minimum > distance){
+              minimum = distance;
+              code = k;
+            }
+          }
+          auto& stored = _codes[i*_numberOfSubspaces + m];
+          if(iteration == 0 || stored != code){
+            stored = static_cast<uint8_t>(code);
+            changed = true;
+          }
+        }
+        if(!changed){
+          break;
+        }
+        std::fill(counts.begin(), counts.end(), 0);
+        std::fill(sums.begin(), sums.end(), 0.);
+        for(uint64_t i = 0; i < nCenters; i++){
+          const auto code = _codes[i*_numberOfSubspaces + m];
+          counts[code]++;
+          for(std::size_t j = 0; j < size; j++){
+            sums[code*size + j] += _normalizedCenters[i][first + j];
+          }
+        }
+        for(std::size_t k = 0; k < _numberOfCodes; k++){
+          if(counts[k] > 0){
+            for(std::size_t j = 0; j < size; j++){
+              codewords[k*size + j] = static_cast<typename Precision::Compute>(sums[k*size + j]/counts[k]);
+            }
+          }
+        }
+      }
+    }
+
+    /// normalized decodes a context, and divides it by its sum when normalize is set
+    template<typename Values>
+    static std::array<typename Precision::Compute, neighborhood> normalized(const Values& values){
+      std::array<typename Precision::Compute, neighborhood> context;
+      for(std::size_t i = 0; i < neighborhood; i++){
+        context[i] = Precision::decode(values[i]);
+      }
+      if(normalize){
+        auto sumOfContext = std::accumulate(context.begin(), context.end(), 0.);
+        for(auto&& it: context){
+          it/=sumOfContext;
+        }
+      }
+      return context;
+    }
+
+    const std::size_t _numberOfSubspaces;
+    const std::size_t _numberOfCodes;
+    const std::size_t _numberOfCandidates;
+    ClusterMetric _clusterMetric;
+    ClusterEventFromEvent _clusterEventFromEvent;
+    HandlerCluster _handlerCluster;
+
+    // the codewords of a subspace are contiguous and codeword-major, and the codes are center-major
+    std::vector<std::array<typename Precision::Compute, neighborhood>> _normalizedCenters;
+    std::vector<typename Precision::Compute> _codewords;
+    std::vector<uint8_t> _codes;
+    std::vector<double> _table;
+    std::vector<double> _approximations;
+    std::vector<uint64_t> _candidates;
+  };
+
+  /// make_productQuantizationCluster creates an approximate cluster from the centers of a trained cluster, for instance cluster.getCenters()
+  template<
+    uint64_t nCenters,
+    std::size_t neighborhood,
+    bool normalize,
+    typename Event,
+    typename ClusterEvent,
+    typename Precision = DoublePrecision,
+    typename ClusterMetric,
+    typename ClusterEventFromEvent,
+    typename HandlerCluster
+    >
+  ProductQuantizationCluster<nCenters,
+                             neighborhood,
+                             normalize,
+                             Event,
+                             ClusterEvent,
+                             ClusterMetric,
+                             ClusterEventFromEvent,
+                             HandlerCluster,
+                             Precision>
+  make_productQuantizationCluster(const std::array<std::array<typename Precision::Value, neighborhood>, nCenters>& centers,
+                                  std::size_t numberOfSubspaces,
+                                  std::size_t numberOfCodes,
+                                  std::size_t numberOfCandidates,
+                                  ClusterMetric clusterMetric,
+                                  ClusterEventFromEvent clusterEventFromEvent,
+                                  HandlerCluster handlerCluster)
+  {
+    return ProductQuantizationCluster<nCenters,
+                                      neighborhood,
+                                      normalize,
+                                      Event,
+                                      ClusterEvent,
+                                      ClusterMetric,
+                                      ClusterEventFromEvent,
+                                      HandlerCluster,
+                                      Precision>
+      (centers,
+       numberOfSubspaces,
+       numberOfCodes,
+       numberOfCandidates,
+       std::forward<ClusterMetric>(clusterMetric),
+       std::forward<ClusterEventFromEvent>(clusterEventFromEvent),
+       std::forward<HandlerCluster>(handlerCluster));
+  }
+}
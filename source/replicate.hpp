@@ -4,6 +4,8 @@
 #include <utility>
 #include <tuple>
 #include <type_traits>
+#include <vector>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -28,13 +30,20 @@ namespace tarsier {
                 Replicate<Event, HandleEventCallbacks...>::trigger<0>(std::forward<Event>(event));
             }
 
+            /// operator() handles a contiguous range of events.
+            /// Every handler but the last one receives a copy of the range, since handlers may modify it in place.
+            void operator()(Event* begin, Event* end) {
+                Replicate<Event, HandleEventCallbacks...>::triggerEvents<0>(begin, end);
+            }
+
         protected:
 
             /// trigger calls the n-th event callback.
             template<std::size_t Index>
             typename std::enable_if<Index < sizeof...(HandleEventCallbacks), void>::type
             trigger(Event event) {
-                std::get<Index>(_handleEventCallbacks)(event);
+                auto eventCopy = event;
+                forwardEvent(std::get<Index>(_handleEventCallbacks), eventCopy);
                 trigger<Index + 1>(std::forward<Event>(event));
             }
 
@@ -43,7 +52,29 @@ namespace tarsier {
             typename std::enable_if<Index == sizeof...(HandleEventCallbacks), void>::type
             trigger(Event) {}
 
+            /// triggerEvents calls the n-th event callback with a copy of the range.
+            template<std::size_t Index>
+            typename std::enable_if<Index + 1 < sizeof...(HandleEventCallbacks), void>::type
+            triggerEvents(Event* begin, Event* end) {
+                _events.assign(begin, end);
+                forwardEvents(std::get<Index>(_handleEventCallbacks), _events.data(), _events.data() + _events.size());
+                triggerEvents<Index + 1>(begin, end);
+            }
+
+            /// triggerEvents calls the last event callback with the original range.
+            template<std::size_t Index>
+            typename std::enable_if<Index + 1 == sizeof...(HandleEventCallbacks), void>::type
+            triggerEvents(Event* begin, Event* end) {
+                forwardEvents(std::get<Index>(_handleEventCallbacks), begin, end);
+            }
+
+            /// triggerEvents is a termination for the template loop without callbacks.
+            template<std::size_t Index>
+            typename std::enable_if<Index == sizeof...(HandleEventCallbacks), void>::type
+            triggerEvents(Event*, Event*) {}
+
             std::tuple<HandleEventCallbacks...> _handleEventCallbacks;
+            std::vector<Event> _events;
     };
 
     /// make_replicate creates a Replicate from functors.
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+    /// RingBuffer is a bounded lock-free queue with a single producer and a single consumer.
+    /// push must always be called from the same thread, and pop from another (or the same) thread.
+    /// Both sides transfer whole ranges, so that the synchronisation cost is paid once per batch.
+    template <typename Event>
+    class RingBuffer {
+        public:
+            RingBuffer(std::size_t capacity) :
+                _events(capacity),
+                _head(0),
+                _tail(0)
+            {
+                if (capacity == 0) {
+                    throw std::logic_error("capacity must be strictly positive");
+                }
+            }
+            RingBuffer(const RingBuffer&) = delete;
+            RingBuffer(RingBuffer&&) = delete;
+            RingBuffer& operator=(const RingBuffer&) = delete;
+            RingBuffer& operator=(RingBuffer&&) = delete;
+            virtual ~RingBuffer() {}
+
+            /// capacity returns the maximum number of events in the queue.
+            std::size_t capacity() const {
+                return _events.size();
+            }
+
+            /// push inserts as many events from the range as possible, and returns how many were inserted.
+            std::size_t push(const Event* begin, const Event* end) {
+                const auto tail = _tail.load(std::memory_order_relaxed);
+                const auto head = _head.load(std::memory_order_acquire);
+                const auto count = std::min(static_cast<std::size_t>(end - begin), _events.size() - (tail - head));
+                for (std::size_t index = 0; index < count; ++index) {
+                    _events[(tail + index) % _events.size()] = begin[index];
+                }
+                _tail.store(tail + count, std::memory_order_release);
+                return count;
+            }
+
+            /// push inserts an event, and returns false if the queue is full.
+            bool push(const Event& event) {
+                return push(&event, &event + 1) == 1;
+            }
+
+            /// pop moves up to maximum events to output, and returns how many were moved.
+            std::size_t pop(Event* output, std::size_t maximum) {
+                const auto head = _head.load(std::memory_order_relaxed);
+                const auto tail = _tail.load(std::memory_order_acquire);
+                const auto count = std::min(maximum, static_cast<std::size_t>(tail - head));
+                for (std::size_t index = 0; index < count; ++index) {
+                    output[index] = _events[(head + index) % _events.size()];
+                }
+                _head.store(head + count, std::memory_order_release);
+                return count;
+            }
+
+            /// pop moves an event to output, and returns false if the queue is empty.
+            bool pop(Event& output) {
+                return pop(&output, 1) == 1;
+            }
+
+        protected:
+            std::vector<Event> _events;
+            std::atomic<std::size_t> _head;
+            char _headPadding[64];
+            std::atomic<std::size_t> _tail;
+            char _tailPadding[64];
+    };
+
+    /// Backoff paces a thread waiting on a RingBuffer, for instance a worker whose queue is empty.
+    /// The first waits yield, so that a busy queue keeps a low latency, then the thread sleeps for durations doubling up to a millisecond,
+    /// so that an idle worker releases its core. reset must be called once the wait is over.
+    class Backoff {
+        public:
+            Backoff() :
+                _waits(0)
+            {
+            }
+
+            /// wait yields or sleeps, depending on the number of waits since the last reset.
+            void wait() {
+                if (_waits < 64) {
+                    std::this_thread::yield();
+                } else {
+                    std::this_thread::sleep_for(std::chrono::microseconds(1 << std::min<std::size_t>(_waits - 64, 10)));
+                }
+                ++_waits;
+            }
+
+            /// reset restarts the backoff from yields.
+            void reset() {
+                _waits = 0;
+            }
+
+        protected:
+            std::size_t _waits;
+    };
+}
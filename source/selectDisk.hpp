@@ -2,6 +2,7 @@
 
 #include <utility>
 #include <cmath>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -26,10 +27,23 @@ namespace tarsier {
             /// operator() handles an event.
             virtual void operator()(Event event) {
                 if (std::pow(static_cast<double>(event.x) - _centerX, 2) + std::pow(static_cast<double>(event.y) - _centerY, 2) < _squaredRadius) {
-                    _handleEvent(event);
+                    forwardEvent(_handleEvent, event);
                 }
             }
 
+            /// operator() handles a contiguous range of events.
+            /// The events within the disk are compacted in place and forwarded.
+            void operator()(Event* begin, Event* end) {
+                auto outputIterator = begin;
+                for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                    const auto xDelta = static_cast<double>(eventIterator->x) - _centerX;
+                    const auto yDelta = static_cast<double>(eventIterator->y) - _centerY;
+                    *outputIterator = *eventIterator;
+                    outputIterator += (xDelta * xDelta + yDelta * yDelta < _squaredRadius);
+                }
+                forwardEvents(_handleEvent, begin, outputIterator);
+            }
+
         protected:
             const double _centerX;
             const double _centerY;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <utility>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -23,10 +24,24 @@ namespace tarsier {
             /// operator() handles an event.
             virtual void operator()(Event event) {
                 if (event.x >= left && event.x < left + width && event.y >= bottom && event.y < bottom + height) {
-                    _handleEvent(event);
+                    forwardEvent(_handleEvent, event);
                 }
             }
 
+            /// operator() handles a contiguous range of events.
+            /// The events within the window are compacted in place and forwarded.
+            void operator()(Event* begin, Event* end) {
+                auto outputIterator = begin;
+                for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                    *outputIterator = *eventIterator;
+                    outputIterator += (
+                        (eventIterator->x >= left) & (eventIterator->x < left + width)
+                        & (eventIterator->y >= bottom) & (eventIterator->y < bottom + height)
+                    );
+                }
+                forwardEvents(_handleEvent, begin, outputIterator);
+            }
+
         protected:
             HandleEvent _handleEvent;
     };
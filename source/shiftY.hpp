@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <utility>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -25,10 +26,23 @@ namespace tarsier {
                 const auto shifted = static_cast<int64_t>(event.y) + shift;
                 if (shifted >= 0 && static_cast<uint64_t>(shifted) < height) {
                     event.y = shifted;
-                    _handleEvent(event);
+                    forwardEvent(_handleEvent, event);
                 }
             }
 
+            /// operator() handles a contiguous range of events.
+            /// The events are shifted and compacted in place, and the ones within the sensor are forwarded.
+            void operator()(Event* begin, Event* end) {
+                auto outputIterator = begin;
+                for (auto eventIterator = begin; eventIterator != end; ++eventIterator) {
+                    const auto shifted = static_cast<int64_t>(eventIterator->y) + shift;
+                    *outputIterator = *eventIterator;
+                    outputIterator->y = shifted;
+                    outputIterator += (shifted >= 0) & (static_cast<uint64_t>(shifted) < height);
+                }
+                forwardEvents(_handleEvent, begin, outputIterator);
+            }
+
         protected:
             HandleEvent _handleEvent;
     };
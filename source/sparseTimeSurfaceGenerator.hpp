@@ -0,0 +1,381 @@
+#pragma once
+
+#include "timeSurfaceGenerator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// tarsier is a collection of event handlers.
+namespace tarsier {
+
+  /// Generic SparseTimeSurfaceGenerator, pure virtual
+  /// The event is moved to timeSurfaceEventFromEvent, and the context is passed as the buffer of the generator:
+  /// taking the context by const reference avoids a copy, and the reference stays valid until the next event.
+  /// Each pixel stores only its recently active polarities, as (polarity, timestamp) entries.
+  /// A timestamp-ordered queue evicts the entries older than the horizon, hence the memory is bounded
+  /// by the number of events within the horizon instead of X*Y*nP.
+  /// The kernel must be zero for time differences greater than or equal to the horizon,
+  /// and the initMemory of the dense generators must be at least the horizon older than the first event (hotsMain's INIT_MEMORY=-1000 is):
+  /// the evicted cells and the cells never written to then both contribute zero, and the contexts are identical to the ones produced by the dense generators.
+  template<
+    int64_t pixels,
+    int64_t contextSize,
+    typename Event,
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<double,contextSize>&)
+    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    >
+  class SparseTimeSurfaceGenerator{
+  public:
+    SparseTimeSurfaceGenerator(Kernel kernel,
+                               int64_t horizon,
+                               TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                               HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      _kernel(std::forward<Kernel>(kernel)),
+      _horizon(horizon),
+      _timeSurfaceEventFromEvent(std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent)),
+      _handlerTimeSurfaceGenerator(std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)),
+      _entries(pixels),
+      _evictions(64),
+      _evictionsHead(0),
+      _evictionsSize(0)
+    {
+      if(horizon <= 0){
+        throw std::logic_error("the horizon must be strictly positive");
+      }
+    }
+
+    virtual ~SparseTimeSurfaceGenerator(){}
+
+    virtual void operator()(Event ev)=0;
+
+    /// size returns the number of stored entries
+    std::size_t size() const {
+      std::size_t total = 0;
+      for(auto&& pixelEntries: _entries){
+        total += pixelEntries.size();
+      }
+      return total;
+    }
+
+  protected:
+    /// Entry is the last timestamp of a polarity at a given pixel
+    struct Entry{
+      int64_t polarity;
+      int64_t timestamp;
+    };
+
+    /// Eviction schedules the removal of an entry, once it is older than the horizon
+    struct Eviction{
+      int64_t pixel;
+      int64_t polarity;
+      int64_t timestamp;
+    };
+
+    /// update stores the event timestamp in its pixel, and evicts the entries which fell beyond the horizon
+    /// The events must be timestamp-ordered
+    void update(int64_t pixel, int64_t polarity, int64_t timestamp){
+      auto& pixelEntries = _entries[pixel];
+      auto entry = std::find_if(pixelEntries.begin(), pixelEntries.end(), [polarity](const Entry& candidate){
+        return candidate.polarity == polarity;
+      });
+      if(entry == pixelEntries.end()){
+        pixelEntries.push_back(Entry{polarity, timestamp});
+      }else{
+        entry->timestamp = timestamp;
+      }
+      pushEviction(Eviction{pixel, polarity, timestamp});
+      while(timestamp - _evictions[_evictionsHead].timestamp >= _horizon){
+        const auto& eviction = _evictions[_evictionsHead];
+        auto& evictedEntries = _entries[eviction.pixel];
+        for(auto&& candidate: evictedEntries){
+          // entries refreshed since are evicted by a later item of the queue
+          if(candidate.polarity == eviction.polarity && candidate.timestamp == eviction.timestamp){
+            candidate = evictedEntries.back();
+            evictedEntries.pop_back();
+            break;
+          }
+        }
+        _evictionsHead = (_evictionsHead + 1) & (_evictions.size() - 1);
+        --_evictionsSize;
+      }
+    }
+
+    /// pushEviction appends an eviction to the circular queue, whose capacity is a power of two
+    /// The capacity doubles when the queue is full, hence the queue stops allocating once it fits the events within the horizon.
+    void pushEviction(const Eviction& eviction){
+      if(_evictionsSize == _evictions.size()){
+        std::vector<Eviction> evictions(2*_evictions.size());
+        for(std::size_t index = 0; index < _evictionsSize; index++){
+          evictions[index] = _evictions[(_evictionsHead + index) & (_evictions.size() - 1)];
+        }
+        _evictions.swap(evictions);
+        _evictionsHead = 0;
+      }
+      _evictions[(_evictionsHead + _evictionsSize) & (_evictions.size() - 1)] = eviction;
+      ++_evictionsSize;
+    }
+
+    /// visit calls handleEntry(polarity, timestamp) for each entry of a pixel
+    template<typename HandleEntry>
+    void visit(int64_t pixel, HandleEntry handleEntry){
+      for(auto&& entry: _entries[pixel]){
+        handleEntry(entry.polarity, entry.timestamp);
+      }
+    }
+
+    /// kernel evaluates a timestamps kernel, without building the neighbor event
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::true_type, Coordinates...){
+      return _kernel(static_cast<int64_t>(ev.t), neighborTimestamp);
+    }
+
+    /// kernel evaluates an events kernel
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::false_type, Coordinates... coordinates){
+      return _kernel(ev, Event{neighborTimestamp, coordinates...});
+    }
+
+    Kernel _kernel;
+    int64_t _horizon;
+    TimeSurfaceEventFromEvent _timeSurfaceEventFromEvent;
+    HandlerTimeSurfaceGenerator _handlerTimeSurfaceGenerator;
+
+    std::vector<std::vector<Entry>> _entries;
+    std::vector<Eviction> _evictions;
+    std::size_t _evictionsHead;
+    std::size_t _evictionsSize;
+    std::array<double, contextSize> _context;
+  };
+
+  /// 1D SparseTimeSurfaceGenerator, whose contexts are laid out as the TimeSurfaceGenerator1D ones
+  template<
+    int64_t X,
+    int64_t nP,
+    int64_t radius,
+    typename Event, // require at least a field .t .x .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<double,contextSize>&)
+    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    >
+  class SparseTimeSurfaceGenerator1D: public SparseTimeSurfaceGenerator<X,
+                                                                        (2*radius+1)*nP,
+                                                                        Event,
+                                                                        TimeSurfaceEvent,
+                                                                        Kernel,
+                                                                        TimeSurfaceEventFromEvent,
+                                                                        HandlerTimeSurfaceGenerator
+                                                                        >{
+  public:
+    SparseTimeSurfaceGenerator1D(Kernel kernel,
+                                 int64_t horizon,
+                                 TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                 HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      SparseTimeSurfaceGenerator<X,
+                                 (2*radius+1)*nP,
+                                 Event,
+                                 TimeSurfaceEvent,
+                                 Kernel,
+                                 TimeSurfaceEventFromEvent,
+                                 HandlerTimeSurfaceGenerator
+                                 >(std::forward<Kernel>(kernel),
+                                   horizon,
+                                   std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+                                   std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator))
+    {}
+
+    virtual void operator()(Event ev){
+      const auto eventX = static_cast<int64_t>(ev.x);
+      const auto timestamp = static_cast<int64_t>(ev.t);
+      this->update(eventX, static_cast<int64_t>(ev.p), timestamp);
+
+      std::fill(this->_context.begin(), this->_context.end(), 0.);
+      const auto xMin = std::max(eventX - radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + radius, X - 1);
+      for(int64_t x = xMin; x <= xMax; x++){
+        this->visit(x, [&](int64_t p, int64_t neighborTimestamp){
+          this->_context[p*(2*radius+1) + x - eventX + radius] = this->kernel(ev, neighborTimestamp, typename AcceptsTimestamps<Kernel>::type(), x, p);
+        });
+      }
+
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        SparseTimeSurfaceGenerator1D::operator()(*begin);
+      }
+    }
+  };
+
+  /// 2D SparseTimeSurfaceGenerator, whose contexts are laid out as the TimeSurfaceGenerator2D ones
+  template<
+    int64_t X,
+    int64_t Y,
+    int64_t nP,
+    int64_t radius,
+    typename Event, // require at least a field .t .x .y .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<double,contextSize>&)
+    typename HandlerTimeSurfaceGenerator, //  void f(TimeSurfaceEvent)
+    ContextOrder order = ContextOrder::polarityMajor
+    >
+  class SparseTimeSurfaceGenerator2D: public SparseTimeSurfaceGenerator<X*Y,
+                                                                        (2*radius+1)*(2*radius+1)*nP,
+                                                                        Event,
+                                                                        TimeSurfaceEvent,
+                                                                        Kernel,
+                                                                        TimeSurfaceEventFromEvent,
+                                                                        HandlerTimeSurfaceGenerator
+                                                                        >{
+  public:
+    SparseTimeSurfaceGenerator2D(Kernel kernel,
+                                 int64_t horizon,
+                                 TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                 HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+      SparseTimeSurfaceGenerator<X*Y,
+                                 (2*radius+1)*(2*radius+1)*nP,
+                                 Event,
+                                 TimeSurfaceEvent,
+                                 Kernel,
+                                 TimeSurfaceEventFromEvent,
+                                 HandlerTimeSurfaceGenerator
+                                 >(std::forward<Kernel>(kernel),
+                                   horizon,
+                                   std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+                                   std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator))
+    {}
+
+    virtual void operator()(Event ev){
+      const auto eventX = static_cast<int64_t>(ev.x);
+      const auto eventY = static_cast<int64_t>(ev.y);
+      const auto timestamp = static_cast<int64_t>(ev.t);
+      this->update(eventY*X + eventX, static_cast<int64_t>(ev.p), timestamp);
+
+      std::fill(this->_context.begin(), this->_context.end(), 0.);
+      const auto xMin = std::max(eventX - radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + radius, X - 1);
+      const auto yMin = std::max(eventY - radius, static_cast<int64_t>(0));
+      const auto yMax = std::min(eventY + radius, Y - 1);
+      for(int64_t y = yMin; y <= yMax; y++){
+        for(int64_t x = xMin; x <= xMax; x++){
+          this->visit(y*X + x, [&](int64_t p, int64_t neighborTimestamp){
+            this->_context[contextIndex(x - eventX + radius, y - eventY + radius, p)] = this->kernel(ev, neighborTimestamp, typename AcceptsTimestamps<Kernel>::type(), x, y, p);
+          });
+        }
+      }
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        SparseTimeSurfaceGenerator2D::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// contextIndex returns the position of a neighbor in the context, given its coordinates within the window
+    static int64_t contextIndex(int64_t x, int64_t y, int64_t p){
+      return (order == ContextOrder::polarityMajor) ?
+        (p*(2*radius+1) + x)*(2*radius+1) + y :
+        (y*(2*radius+1) + x)*nP + p;
+    }
+  };
+
+  //------------------------------------------------------------------------------------------
+  /// make_sparseTimeSurfaceGenerator
+
+  /// 1D version
+  template<
+    int64_t X,
+    int64_t nP,
+    int64_t radius,
+    typename Event, //Requires at least a field .t, .x, .p
+    typename TimeSurfaceEvent,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<double,contextSize>&)
+    typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
+    >
+  SparseTimeSurfaceGenerator1D<X,
+                               nP,
+                               radius,
+                               Event,
+                               TimeSurfaceEvent,
+                               Kernel,
+                               TimeSurfaceEventFromEvent,
+                               HandlerTimeSurfaceGenerator>
+  make_sparseTimeSurfaceGenerator(Kernel kernel,
+                                  int64_t horizon,
+                                  TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+  {
+    return SparseTimeSurfaceGenerator1D<X,
+                                        nP,
+                                        radius,
+                                        Event,
+                                        TimeSurfaceEvent,
+                                        Kernel,
+                                        TimeSurfaceEventFromEvent,
+                                        HandlerTimeSurfaceGenerator>
+      (std::forward<Kernel>(kernel),
+       horizon,
+       std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       );
+  }
+
+  /// 2D version
+  template<
+    int64_t X,
+    int64_t Y,
+    int64_t nP,
+    int64_t radius,
+    typename Event, //Requires at least a field .t, .x, .y, .p
+    typename TimeSurfaceEvent,
+    ContextOrder order = ContextOrder::polarityMajor,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<double,contextSize>&)
+    typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
+    >
+  SparseTimeSurfaceGenerator2D<X,
+                               Y,
+                               nP,
+                               radius,
+                               Event,
+                               TimeSurfaceEvent,
+                               Kernel,
+                               TimeSurfaceEventFromEvent,
+                               HandlerTimeSurfaceGenerator,
+                               order>
+  make_sparseTimeSurfaceGenerator(Kernel kernel,
+                                  int64_t horizon,
+                                  TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
+                                  HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+  {
+    return SparseTimeSurfaceGenerator2D<X,
+                                        Y,
+                                        nP,
+                                        radius,
+                                        Event,
+                                        TimeSurfaceEvent,
+                                        Kernel,
+                                        TimeSurfaceEventFromEvent,
+                                        HandlerTimeSurfaceGenerator,
+                                        order>
+      (std::forward<Kernel>(kernel),
+       horizon,
+       std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       );
+  }
+};
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <utility>
 #include <vector>
+#include "forwardEvents.hpp"
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -27,6 +28,30 @@ namespace tarsier {
 
             /// operator() handles a threshold crossing.
             virtual void operator()(const ThresholdCrossing& thresholdCrossing) {
+                auto forwardGeneratedEvent = [this](Event event) -> void {
+                    forwardEvent(_handleEvent, event);
+                };
+                stitch(thresholdCrossing, forwardGeneratedEvent);
+            }
+
+            /// operator() handles a contiguous range of threshold crossings.
+            /// The generated events are buffered and forwarded as a single range.
+            void operator()(const ThresholdCrossing* begin, const ThresholdCrossing* end) {
+                _events.clear();
+                auto bufferEvent = [this](Event event) -> void {
+                    _events.push_back(event);
+                };
+                for (; begin != end; ++begin) {
+                    stitch(*begin, bufferEvent);
+                }
+                forwardEvents(_handleEvent, _events.data(), _events.data() + _events.size());
+            }
+
+        protected:
+
+            /// stitch updates the pixel state and sends the generated event, if any, to the given functor.
+            template <typename HandleGeneratedEvent>
+            void stitch(const ThresholdCrossing& thresholdCrossing, HandleGeneratedEvent& handleGeneratedEvent) {
                 auto& isTriggeredAndTimestamp = _areTriggeredAndTimestamps[thresholdCrossing.x + thresholdCrossing.y * width];
                 if (!isTriggeredAndTimestamp.first) {
                     if (!thresholdCrossing.isSecond) {
@@ -36,7 +61,7 @@ namespace tarsier {
                 } else {
                     if (thresholdCrossing.isSecond) {
                         isTriggeredAndTimestamp.first = false;
-                        _handleEvent(_eventFromThresholdCrossing(
+                        handleGeneratedEvent(_eventFromThresholdCrossing(
                             thresholdCrossing,
                             static_cast<uint64_t>(thresholdCrossing.timestamp) - isTriggeredAndTimestamp.second
                         ));
@@ -46,10 +71,10 @@ namespace tarsier {
                 }
             }
 
-        protected:
             EventFromThresholdCrossing _eventFromThresholdCrossing;
             HandleEvent _handleEvent;
             std::vector<std::pair<bool, uint64_t>> _areTriggeredAndTimestamps;
+            std::vector<Event> _events;
     };
 
     /// make_stitch creates a Stitch from functors.
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "precision.hpp"
+
 #include <iostream>
 #include <algorithm>
 #include <cstdint>
@@ -7,36 +9,406 @@
 #include <utility>
 #include <array>
 #include <numeric>
+#include <stdexcept>
+#include <vector>
+#include <type_traits>
+#include <memory>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sys/mman.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
 
+  /// AcceptsTimestamps determines whether a kernel works on raw timestamps.
+  /// A timestamps kernel must have the signature:
+  ///     double f(int64_t timestamp, int64_t neighborTimestamp)
+  /// Other kernels are called with whole events: double f(Event ref, Event neighbor)
+  template<typename Kernel>
+  class AcceptsTimestamps{
+    template<typename Candidate>
+    static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<int64_t>(), std::declval<int64_t>()), std::true_type());
+
+    template<typename Candidate>
+    static std::false_type test(...);
+
+  public:
+    typedef decltype(test<Kernel>(0)) type;
+    static constexpr bool value = type::value;
+  };
+
+  /// AcceptsTimestampRows determines whether a timestamps kernel also processes contiguous rows of neighbors.
+  /// A rows kernel must have the signature:
+  ///     void f(int64_t timestamp, const int64_t* neighborTimestamps, double* output, std::size_t count)
+  template<typename Kernel>
+  class AcceptsTimestampRows{
+    template<typename Candidate>
+    static auto test(int) -> decltype(std::declval<Candidate&>()(std::declval<int64_t>(), std::declval<const int64_t*>(), std::declval<double*>(), std::declval<std::size_t>()), std::true_type());
+
+    template<typename Candidate>
+    static std::false_type test(...);
+
+  public:
+    typedef decltype(test<Kernel>(0)) type;
+    static constexpr bool value = type::value;
+  };
+
+  /// DecayKernel is a timestamps kernel backed by a lookup table
+  /// The table is indexed by the time difference divided by quantum, and the kernel is zero beyond the horizon
+  class DecayKernel{
+  public:
+    DecayKernel(int64_t horizon, int64_t quantum):
+      _quantum(quantum)
+    {
+      if(horizon <= 0 || quantum <= 0){
+        throw std::logic_error("the horizon and the quantum must be strictly positive");
+      }
+      // the table is padded with a zero, so that differences beyond the horizon read the last entry
+      _table.resize((horizon + quantum - 1)/quantum + 1, 0.);
+      _horizon = static_cast<int64_t>(_table.size() - 1)*quantum;
+    }
+
+    virtual ~DecayKernel(){}
+
+    /// operator() returns the decay for the given timestamps
+    double operator()(int64_t timestamp, int64_t neighborTimestamp) const {
+      const auto difference = timestamp - neighborTimestamp;
+      return _table[(difference >= 0 && difference < _horizon) ? difference/_quantum : _table.size() - 1];
+    }
+
+  protected:
+    int64_t _horizon;
+    int64_t _quantum;
+    std::vector<double> _table;
+  };
+
+  /// ExponentialDecayKernel evaluates exp(-difference/tau) for differences smaller than horizon, and zero otherwise
+  /// With the default quantum of one, the values are identical to a direct evaluation on integer timestamps
+  class ExponentialDecayKernel: public DecayKernel{
+  public:
+    ExponentialDecayKernel(double tau, int64_t horizon, int64_t quantum = 1):
+      DecayKernel(horizon, quantum)
+    {
+      for(int64_t i = 0; i < static_cast<int64_t>(_table.size()) - 1; i++){
+        const auto difference = static_cast<double>(i*_quantum);
+        _table[i] = (difference < static_cast<double>(horizon)) ? std::exp(-difference/tau) : 0.;
+      }
+    }
+  };
+
+  /// LinearDecayKernel evaluates 1 - difference/horizon for differences smaller than horizon, and zero otherwise
+  class LinearDecayKernel: public DecayKernel{
+  public:
+    LinearDecayKernel(int64_t horizon, int64_t quantum = 1):
+      DecayKernel(horizon, quantum)
+    {
+      for(int64_t i = 0; i < static_cast<int64_t>(_table.size()) - 1; i++){
+        const auto difference = static_cast<double>(i*_quantum);
+        _table[i] = (difference < static_cast<double>(horizon)) ? 1. - difference/static_cast<double>(horizon) : 0.;
+      }
+    }
+  };
+
+  /// ApproximateExponentialDecayKernel evaluates exp(-difference/tau) for differences smaller than horizon, and zero otherwise
+  /// The exponential is a range reduction followed by a degree 11 polynomial (relative error below 1e-12),
+  /// and rows of neighbors are processed four at a time with AVX2 when the compiler targets it (for example with -march=native).
+  /// The scalar and vector paths perform the same operations, hence they return identical values
+  class ApproximateExponentialDecayKernel{
+  public:
+    ApproximateExponentialDecayKernel(double tau, int64_t horizon):
+      _negativeInverseTau(-1./tau),
+      _horizon(horizon)
+    {
+      if(tau <= 0 || horizon <= 0 || horizon >= (static_cast<int64_t>(1) << 52)){
+        throw std::logic_error("tau must be strictly positive, and the horizon in the range [1, 2^52)");
+      }
+    }
+
+    virtual ~ApproximateExponentialDecayKernel(){}
+
+    /// operator() returns the decay for the given timestamps
+    double operator()(int64_t timestamp, int64_t neighborTimestamp) const {
+      const auto difference = timestamp - neighborTimestamp;
+      if(difference < 0 || difference >= _horizon){
+        return 0.;
+      }
+      auto exponent = std::max(static_cast<double>(difference)*_negativeInverseTau, minimumExponent());
+      const auto k = std::nearbyint(exponent*log2e());
+      const auto r = (exponent - k*ln2High()) - k*ln2Low();
+      const auto polynomial = taylor(1./39916800., [r](double value, double coefficient){
+        return value*r + coefficient;
+      });
+      const auto bits = static_cast<uint64_t>(static_cast<int64_t>(k) + 1023) << 52;
+      double scale;
+      std::memcpy(&scale, &bits, sizeof(double));
+      return polynomial*scale;
+    }
+
+    /// operator() writes the decays for a row of neighbor timestamps
+    void operator()(int64_t timestamp, const int64_t* neighborTimestamps, double* output, std::size_t count) const {
+      std::size_t index = 0;
+#if defined(__AVX2__)
+      const auto timestamps = _mm256_set1_epi64x(timestamp);
+      const auto horizons = _mm256_set1_epi64x(_horizon);
+      const auto zeros = _mm256_setzero_si256();
+      const auto magic = _mm256_set1_epi64x(0x4330000000000000);
+      const auto twoPower52 = _mm256_set1_pd(4503599627370496.);
+      const auto negativeInverseTaus = _mm256_set1_pd(_negativeInverseTau);
+      const auto minimumExponents = _mm256_set1_pd(minimumExponent());
+      const auto log2es = _mm256_set1_pd(log2e());
+      const auto ln2Highs = _mm256_set1_pd(ln2High());
+      const auto ln2Lows = _mm256_set1_pd(ln2Low());
+      const auto biases = _mm256_set1_epi64x(1023);
+      for(; index + 4 <= count; index += 4){
+        const auto differences = _mm256_sub_epi64(timestamps, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(neighborTimestamps + index)));
+        const auto mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(zeros, differences), _mm256_cmpgt_epi64(horizons, differences));
+        if(_mm256_testz_si256(mask, mask)){
+          // sparse surfaces are mostly older than the horizon
+          _mm256_storeu_pd(output + index, _mm256_setzero_pd());
+          continue;
+        }
+
+        // differences in [0, 2^52) are converted exactly by inserting them in the mantissa of 2^52
+        const auto values = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(differences, mask), magic)), twoPower52);
+        const auto exponents = _mm256_max_pd(_mm256_mul_pd(values, negativeInverseTaus), minimumExponents);
+        const auto k = _mm256_round_pd(_mm256_mul_pd(exponents, log2es), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const auto r = _mm256_sub_pd(_mm256_sub_pd(exponents, _mm256_mul_pd(k, ln2Highs)), _mm256_mul_pd(k, ln2Lows));
+        const auto polynomial = taylor(_mm256_set1_pd(1./39916800.), [r](__m256d value, double coefficient){
+          return _mm256_add_pd(_mm256_mul_pd(value, r), _mm256_set1_pd(coefficient));
+        });
+        const auto scales = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k)), biases), 52));
+        _mm256_storeu_pd(output + index, _mm256_and_pd(_mm256_mul_pd(polynomial, scales), _mm256_castsi256_pd(mask)));
+      }
+#endif
+      for(; index < count; index++){
+        output[index] = (*this)(timestamp, neighborTimestamps[index]);
+      }
+    }
+
+  protected:
+    /// minimumExponent keeps 2^k within the normal range
+    static constexpr double minimumExponent(){
+      return -708.;
+    }
+
+    static constexpr double log2e(){
+      return 1.4426950408889634;
+    }
+
+    /// ln2High and ln2Low split ln(2), so that k*ln2High is exact
+    static constexpr double ln2High(){
+      return 6.93147180369123816490e-01;
+    }
+
+    static constexpr double ln2Low(){
+      return 1.90821492927058770002e-10;
+    }
+
+
+    /// taylor evaluates the degree 11 Taylor polynomial of the exponential with Horner's method,
+    /// given the leading coefficient and step(value, coefficient) = value*r + coefficient
+    template<typename Value, typename Step>
+    static Value taylor(Value value, Step step){
+      value = step(value, 1./3628800.);
+      value = step(value, 1./362880.);
+      value = step(value, 1./40320.);
+      value = step(value, 1./5040.);
+      value = step(value, 1./720.);
+      value = step(value, 1./120.);
+      value = step(value, 1./24.);
+      value = step(value, 1./6.);
+      value = step(value, 1./2.);
+      value = step(value, 1.);
+      return step(value, 1.);
+    }
+
+    double _negativeInverseTau;
+    int64_t _horizon;
+  };
+
+  /// AlignedAllocator is a standard allocator whose buffers are aligned on the given boundary
+  /// Buffers aligned on 2 MiB are advised to use transparent huge pages, when the platform supports it
+  template<typename T, std::size_t alignment>
+  class AlignedAllocator{
+  public:
+    typedef T value_type;
+
+    template<typename U>
+    struct rebind{
+      typedef AlignedAllocator<U, alignment> other;
+    };
+
+    AlignedAllocator(){}
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, alignment>&){}
+
+    T* allocate(std::size_t n){
+      void* pointer = nullptr;
+      const auto size = ((n*sizeof(T) + alignment - 1)/alignment)*alignment;
+      if(posix_memalign(&pointer, alignment, size) != 0){
+        throw std::bad_alloc();
+      }
+      #ifdef MADV_HUGEPAGE
+      if(alignment >= (1 << 21)){
+        madvise(pointer, size, MADV_HUGEPAGE);
+      }
+      #endif
+      return static_cast<T*>(pointer);
+    }
+
+    void deallocate(T* pointer, std::size_t){
+      free(pointer);
+    }
+  };
+
+  template<typename T, typename U, std::size_t alignment>
+  bool operator==(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&){
+    return true;
+  }
+
+  template<typename T, typename U, std::size_t alignment>
+  bool operator!=(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&){
+    return false;
+  }
+
+  /// InlineStorage keeps the memory inside the generator, with a compile-time size
+  /// It is the fastest option for small sensors, but large memories overflow the stack
+  struct InlineStorage{
+    template<std::size_t size>
+    using memory = std::array<int64_t, size>;
+  };
+
+  /// HeapMemory is a fixed-size memory allocated with the given allocator
+  template<std::size_t size, typename Allocator>
+  class HeapMemory{
+  public:
+    HeapMemory(const Allocator& allocator = Allocator()):
+      _values(size, 0, allocator)
+    {}
+
+    int64_t& operator[](std::size_t index){
+      return _values[index];
+    }
+
+    const int64_t& operator[](std::size_t index) const {
+      return _values[index];
+    }
+
+    int64_t* data(){
+      return _values.data();
+    }
+
+    const int64_t* data() const {
+      return _values.data();
+    }
+
+  protected:
+    std::vector<int64_t, Allocator> _values;
+  };
+
+  /// HeapStorage allocates the memory with an allocator
+  template<typename Allocator = std::allocator<int64_t>>
+  struct HeapStorage{
+    template<std::size_t size>
+    using memory = HeapMemory<size, Allocator>;
+  };
+
+  /// HugePageStorage allocates the memory on 2 MiB boundaries, to reduce TLB misses on large sensors
+  typedef HeapStorage<AlignedAllocator<int64_t, 1 << 21>> HugePageStorage;
+
+  /// BufferMemory uses a buffer owned by the user, which must outlive the generator
+  /// The buffer is overwritten with the initial memory value when the generator is created
+  template<std::size_t size>
+  class BufferMemory{
+  public:
+    BufferMemory(int64_t* buffer, std::size_t length):
+      _buffer(buffer)
+    {
+      if(length < size){
+        throw std::logic_error("the buffer is too small for the generator memory");
+      }
+    }
+
+    int64_t& operator[](std::size_t index){
+      return _buffer[index];
+    }
+
+    const int64_t& operator[](std::size_t index) const {
+      return _buffer[index];
+    }
+
+    int64_t* data(){
+      return _buffer;
+    }
+
+    const int64_t* data() const {
+      return _buffer;
+    }
+
+  protected:
+    int64_t* _buffer;
+  };
+
+  /// BufferStorage uses a user-provided buffer, given to the generator constructor as {pointer, length}
+  struct BufferStorage{
+    template<std::size_t size>
+    using memory = BufferMemory<size>;
+  };
+
+  /// AutomaticStorage uses InlineStorage for memories up to inlineSize timestamps, and HeapStorage otherwise
+  template<std::size_t inlineSize = 1 << 13>
+  struct AutomaticStorage{
+    template<std::size_t size>
+    using memory = typename std::conditional<
+      (size <= inlineSize),
+      InlineStorage::memory<size>,
+      HeapStorage<>::memory<size>
+      >::type;
+  };
+
+  /// ContextOrder selects the layout of the 2D contexts
+  ///     polarityMajor: [p][x][y], the historical order
+  ///     pixelMajor: [y][x][p], the order of the generator memory
+  enum class ContextOrder{
+    polarityMajor,
+    pixelMajor,
+  };
+
   /// Generic TimeSurfaceGenerator, pure virtual
+  /// The event is moved to timeSurfaceEventFromEvent, and the context is passed as the buffer of the generator:
+  /// taking the context by const reference avoids a copy, and the reference stays valid until the next event.
   template<
     int64_t memorySize,
     int64_t contextSize,
     int64_t initMemory,
     typename Event,
     typename TimeSurfaceEvent,
-    typename Kernel, // double f(Event ref, Event neighbor)
-    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, std::array<double,contextSize>)
-    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<Precision::Value,contextSize>&)
+    typename HandlerTimeSurfaceGenerator, //  void f(TimeSurfaceEvent)
+    typename Storage = AutomaticStorage<>,
+    typename Precision = DoublePrecision
     >
   class TimeSurfaceGenerator{
   public:
+    typedef typename Storage::template memory<memorySize> Memory;
+
     TimeSurfaceGenerator(Kernel kernel,
                          TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
-                         HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+                         HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator,
+                         Memory memory = Memory()):
       _kernel(std::forward<Kernel>(kernel)),
       _timeSurfaceEventFromEvent(std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent)),
-      _handlerTimeSurfaceGenerator(std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator))
+      _handlerTimeSurfaceGenerator(std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)),
+      _memory(std::move(memory))
     {
-      for(auto&& it: _memory){
-        it = initMemory;
-      }
-      for(auto&& it: _context){
-        it = 0.;
-      }
+      std::fill_n(_memory.data(), memorySize, initMemory);
+      _context.fill(Precision::encode(0.));
     }
 
     virtual ~TimeSurfaceGenerator(){}
@@ -44,12 +416,24 @@ namespace tarsier {
     virtual void operator()(Event ev)=0;
 
   protected:
+    /// kernel evaluates a timestamps kernel, without building the neighbor event
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::true_type, Coordinates...){
+      return _kernel(static_cast<int64_t>(ev.t), neighborTimestamp);
+    }
+
+    /// kernel evaluates an events kernel
+    template<typename... Coordinates>
+    double kernel(const Event& ev, int64_t neighborTimestamp, std::false_type, Coordinates... coordinates){
+      return _kernel(ev, Event{neighborTimestamp, coordinates...});
+    }
+
     Kernel _kernel;
     TimeSurfaceEventFromEvent _timeSurfaceEventFromEvent;
     HandlerTimeSurfaceGenerator _handlerTimeSurfaceGenerator;
 
-    std::array<int64_t, memorySize> _memory;
-    std::array<double, contextSize> _context;
+    Memory _memory;
+    std::array<typename Precision::Value, contextSize> _context;
   };
 
   /// 1D TimeSurfaceGenerator
@@ -60,9 +444,11 @@ namespace tarsier {
     int64_t initMemory,
     typename Event, // require at least a field .t .x .p
     typename TimeSurfaceEvent,
-    typename Kernel, // double f(Event ref, Event neighbor)
-    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, std::array<double,contextSize>)
-    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<Precision::Value,contextSize>&)
+    typename HandlerTimeSurfaceGenerator, //  void f(TimeSurfaceEvent)
+    typename Storage = AutomaticStorage<>,
+    typename Precision = DoublePrecision
     >
   class TimeSurfaceGenerator1D: public TimeSurfaceGenerator<X*nP,
                                                             (2*radius+1)*nP,
@@ -71,12 +457,17 @@ namespace tarsier {
                                                             TimeSurfaceEvent,
                                                             Kernel,
                                                             TimeSurfaceEventFromEvent,
-                                                            HandlerTimeSurfaceGenerator
+                                                            HandlerTimeSurfaceGenerator,
+                                                            Storage,
+                                                            Precision
                                                             >{
   public:
+    typedef typename Storage::template memory<X*nP> Memory;
+
     TimeSurfaceGenerator1D(Kernel kernel,
                            TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
-                           HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+                           HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator,
+                           Memory memory = Memory()):
       TimeSurfaceGenerator<X*nP,
                            (2*radius+1)*nP,
                            initMemory,
@@ -84,33 +475,72 @@ namespace tarsier {
                            TimeSurfaceEvent,
                            Kernel,
                            TimeSurfaceEventFromEvent,
-                           HandlerTimeSurfaceGenerator
+                           HandlerTimeSurfaceGenerator,
+                           Storage,
+                           Precision
                            >(std::forward<Kernel>(kernel),
                              std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
-                             std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator))
+                             std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator),
+                             std::move(memory))
     {}
 
     virtual void operator()(Event ev) {
+      const auto eventX = static_cast<int64_t>(ev.x);
       this->_memory[ev.p*X+ev.x] = static_cast<int64_t>(ev.t);
-      uint64_t cpt = 0;
 
+      // the window is clamped once, and the context is cleared only when it crosses a border
+      const auto xMin = std::max(eventX - radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + radius, X - 1);
+      if(xMax - xMin < 2*radius){
+        this->_context.fill(Precision::encode(0.));
+      }
       for(int64_t p = 0; p < nP; p++){
-        for(int64_t x = static_cast<int64_t>(ev.x)-radius;
-            x <= static_cast<int64_t>(ev.x)+radius;
-            x++){
-          if(x >= 0 && x < X){
-            this->_context[cpt++] = this->_kernel(ev,Event{this->_memory[p*X+x], x, p});
-          }else{
-            this->_context[cpt++] = 0;
-          }
-        }
+        row(ev,
+            this->_memory.data() + p*X + xMin,
+            this->_context.data() + p*(2*radius+1) + xMin - eventX + radius,
+            xMax - xMin + 1,
+            xMin,
+            p,
+            typename AcceptsTimestampRows<Kernel>::type());
+      }
+
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        TimeSurfaceGenerator1D::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// row evaluates a rows kernel on count contiguous neighbors
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t, int64_t, std::true_type){
+      this->_kernel(static_cast<int64_t>(ev.t), input, output, static_cast<std::size_t>(count));
+    }
+
+    /// row evaluates the kernel on count contiguous neighbors, one at a time
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t p, std::false_type){
+      for(int64_t i = 0; i < count; i++){
+        output[i] = this->kernel(ev, input[i], typename AcceptsTimestamps<Kernel>::type(), xMin + i, p);
       }
+    }
 
-      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(ev,this->_context));
+    /// row evaluates the kernel in double precision, and encodes the values with the precision policy
+    template<typename Value, typename Rows>
+    void row(const Event& ev, const int64_t* input, Value* output, int64_t count, int64_t xMin, int64_t p, Rows rows){
+      row(ev, input, _row.data(), count, xMin, p, rows);
+      for(int64_t i = 0; i < count; i++){
+        output[i] = Precision::encode(_row[i]);
+      }
     }
+
+    std::array<double, 2*radius+1> _row;
   };
 
   /// 2D TimeSurfaceGenerator
+  /// The memory is pixel-interleaved ([y][x][p]), so that each row of the neighbourhood is read contiguously
   template<
     int64_t X,
     int64_t Y,
@@ -119,9 +549,12 @@ namespace tarsier {
     int64_t initMemory,
     typename Event, // require at least a field .t .x .y .p
     typename TimeSurfaceEvent,
-    typename Kernel, // double f(Event ref, Event neighbor)
-    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, std::array<double,contextSize>)
-    typename HandlerTimeSurfaceGenerator //  void f(TimeSurfaceEvent)
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<Precision::Value,contextSize>&)
+    typename HandlerTimeSurfaceGenerator, //  void f(TimeSurfaceEvent)
+    ContextOrder order = ContextOrder::polarityMajor,
+    typename Storage = AutomaticStorage<>,
+    typename Precision = DoublePrecision
     >
   class TimeSurfaceGenerator2D: public TimeSurfaceGenerator<X*Y*nP,
                                                             (2*radius+1)*(2*radius+1)*nP,
@@ -130,12 +563,17 @@ namespace tarsier {
                                                             TimeSurfaceEvent,
                                                             Kernel,
                                                             TimeSurfaceEventFromEvent,
-                                                            HandlerTimeSurfaceGenerator
+                                                            HandlerTimeSurfaceGenerator,
+                                                            Storage,
+                                                            Precision
                                                             >{
   public:
+    typedef typename Storage::template memory<X*Y*nP> Memory;
+
     TimeSurfaceGenerator2D(Kernel kernel,
                            TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
-                           HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator):
+                           HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator,
+                           Memory memory = Memory()):
       TimeSurfaceGenerator<X*Y*nP,
                            (2*radius+1)*(2*radius+1)*nP,
                            initMemory,
@@ -143,33 +581,85 @@ namespace tarsier {
                            TimeSurfaceEvent,
                            Kernel,
                            TimeSurfaceEventFromEvent,
-                           HandlerTimeSurfaceGenerator
+                           HandlerTimeSurfaceGenerator,
+                           Storage,
+                           Precision
                            >(std::forward<Kernel>(kernel),
                              std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
-                             std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator))
+                             std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator),
+                             std::move(memory))
     {}
 
     virtual void operator()(Event ev){
-      this->_memory[ev.p*X*Y + ev.y*X + ev.x] = static_cast<int64_t>(ev.t);
-      uint64_t cpt = 0;
+      const auto eventX = static_cast<int64_t>(ev.x);
+      const auto eventY = static_cast<int64_t>(ev.y);
+      this->_memory[(eventY*X + eventX)*nP + ev.p] = static_cast<int64_t>(ev.t);
 
-      for(int64_t p = 0; p < nP; p++){
-        for(int64_t x = static_cast<int64_t>(ev.x)-radius;
-            x <= static_cast<int64_t>(ev.x)+radius;
-            x++){
-          for(int64_t y = static_cast<int64_t>(ev.y)-radius;
-              y <= static_cast<int64_t>(ev.y)+radius;
-              y++){
-            if(x >= 0 && x < X & y >= 0 && y < Y){
-              this->_context[cpt++] = this->_kernel(ev,Event{this->_memory[p*X*Y + y*X + x], x, y, p});
-            }else{
-              this->_context[cpt++] = 0;
+      // the window is clamped once, and the context is cleared only when it crosses a border
+      const auto xMin = std::max(eventX - radius, static_cast<int64_t>(0));
+      const auto xMax = std::min(eventX + radius, X - 1);
+      const auto yMin = std::max(eventY - radius, static_cast<int64_t>(0));
+      const auto yMax = std::min(eventY + radius, Y - 1);
+      if(xMax - xMin < 2*radius || yMax - yMin < 2*radius){
+        this->_context.fill(Precision::encode(0.));
+      }
+
+      const auto rowSize = (xMax - xMin + 1)*nP;
+      for(int64_t y = yMin; y <= yMax; y++){
+        const auto input = this->_memory.data() + (y*X + xMin)*nP;
+        if(order == ContextOrder::pixelMajor){
+          row(ev,
+              input,
+              this->_context.data() + ((y - eventY + radius)*(2*radius+1) + xMin - eventX + radius)*nP,
+              rowSize,
+              xMin,
+              y,
+              typename AcceptsTimestampRows<Kernel>::type());
+        }else{
+          row(ev, input, _row.data(), rowSize, xMin, y, typename AcceptsTimestampRows<Kernel>::type());
+          const auto output = this->_context.data() + (xMin - eventX + radius)*(2*radius+1) + y - eventY + radius;
+          for(int64_t x = 0; x <= xMax - xMin; x++){
+            for(int64_t p = 0; p < nP; p++){
+              output[(p*(2*radius+1) + x)*(2*radius+1)] = Precision::encode(_row[x*nP + p]);
             }
           }
         }
       }
-      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(ev,this->_context));
+      this->_handlerTimeSurfaceGenerator(this->_timeSurfaceEventFromEvent(std::move(ev),this->_context));
+    }
+
+    /// operator() handles a contiguous range of events
+    void operator()(Event* begin, Event* end){
+      for(; begin != end; ++begin){
+        TimeSurfaceGenerator2D::operator()(*begin);
+      }
+    }
+
+  protected:
+    /// row evaluates a rows kernel on count contiguous neighbors
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t, int64_t, std::true_type){
+      this->_kernel(static_cast<int64_t>(ev.t), input, output, static_cast<std::size_t>(count));
+    }
+
+    /// row evaluates the kernel on count contiguous neighbors, one at a time
+    void row(const Event& ev, const int64_t* input, double* output, int64_t count, int64_t xMin, int64_t y, std::false_type){
+      for(int64_t x = 0; x < count/nP; x++){
+        for(int64_t p = 0; p < nP; p++){
+          output[x*nP + p] = this->kernel(ev, input[x*nP + p], typename AcceptsTimestamps<Kernel>::type(), xMin + x, y, p);
+        }
+      }
     }
+
+    /// row evaluates the kernel in double precision, and encodes the values with the precision policy
+    template<typename Value, typename Rows>
+    void row(const Event& ev, const int64_t* input, Value* output, int64_t count, int64_t xMin, int64_t y, Rows rows){
+      row(ev, input, _row.data(), count, xMin, y, rows);
+      for(int64_t i = 0; i < count; i++){
+        output[i] = Precision::encode(_row[i]);
+      }
+    }
+
+    std::array<double, (2*radius+1)*nP> _row;
   };
 
   //------------------------------------------------------------------------------------------\\
@@ -183,8 +673,10 @@ namespace tarsier {
     int64_t initMemory,
     typename Event, //Requires at least a field .t, .x, .p
     typename TimeSurfaceEvent,
-    typename Kernel, // double f(Event ref, Event neighbor)
-    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, std::array<double,contextSize>)
+    typename Storage = AutomaticStorage<>,
+    typename Precision = DoublePrecision,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<Precision::Value,contextSize>&)
     typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
     >
   TimeSurfaceGenerator1D<X,
@@ -195,10 +687,13 @@ namespace tarsier {
                          TimeSurfaceEvent,
                          Kernel,
                          TimeSurfaceEventFromEvent,
-                         HandlerTimeSurfaceGenerator>
+                         HandlerTimeSurfaceGenerator,
+                         Storage,
+                         Precision>
   make_timeSurfaceGenerator(Kernel kernel,
                             TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
-                            HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+                            HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator,
+                            typename Storage::template memory<X*nP> memory = typename Storage::template memory<X*nP>())
   {
     return TimeSurfaceGenerator1D<X,
                                   nP,
@@ -208,10 +703,13 @@ namespace tarsier {
                                   TimeSurfaceEvent,
                                   Kernel,
                                   TimeSurfaceEventFromEvent,
-                                  HandlerTimeSurfaceGenerator>
+                                  HandlerTimeSurfaceGenerator,
+                                  Storage,
+                                  Precision>
       (std::forward<Kernel>(kernel),
        std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
-       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator),
+       std::move(memory)
        );
   }
 
@@ -224,8 +722,11 @@ namespace tarsier {
     int64_t initMemory,
     typename Event, //Requires at least a field .t, .x, .y, .p
     typename TimeSurfaceEvent,
-    typename Kernel, // double f(Event ref, Event neighbor)
-    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, std::array<double,contextSize>)
+    ContextOrder order = ContextOrder::polarityMajor,
+    typename Storage = AutomaticStorage<>,
+    typename Precision = DoublePrecision,
+    typename Kernel, // double f(Event ref, Event neighbor) or double f(int64_t timestamp, int64_t neighborTimestamp)
+    typename TimeSurfaceEventFromEvent, // TimeSurfaceEvent f(Event, const std::array<Precision::Value,contextSize>&)
     typename HandlerTimeSurfaceGenerator // void f(TimeSurfaceEvent)
     >
   TimeSurfaceGenerator2D<X,
@@ -237,10 +738,14 @@ namespace tarsier {
                          TimeSurfaceEvent,
                          Kernel,
                          TimeSurfaceEventFromEvent,
-                         HandlerTimeSurfaceGenerator>
+                         HandlerTimeSurfaceGenerator,
+                         order,
+                         Storage,
+                         Precision>
   make_timeSurfaceGenerator(Kernel kernel,
                             TimeSurfaceEventFromEvent timeSurfaceEventFromEvent,
-                            HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator)
+                            HandlerTimeSurfaceGenerator handlerTimeSurfaceGenerator,
+                            typename Storage::template memory<X*Y*nP> memory = typename Storage::template memory<X*Y*nP>())
   {
     return TimeSurfaceGenerator2D<X,
                                   Y,
@@ -251,10 +756,14 @@ namespace tarsier {
                                   TimeSurfaceEvent,
                                   Kernel,
                                   TimeSurfaceEventFromEvent,
-                                  HandlerTimeSurfaceGenerator>
+                                  HandlerTimeSurfaceGenerator,
+                                  order,
+                                  Storage,
+                                  Precision>
       (std::forward<Kernel>(kernel),
        std::forward<TimeSurfaceEventFromEvent>(timeSurfaceEventFromEvent),
-       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator)
+       std::forward<HandlerTimeSurfaceGenerator>(handlerTimeSurfaceGenerator),
+       std::move(memory)
        );
   }
 };
@@ -8,6 +8,7 @@
 #include <array>
 #include <stdexcept>
 #include <algorithm>
+#include <limits>
 
 /// tarsier is a collection of event handlers.
 namespace tarsier {
@@ -31,6 +32,433 @@ namespace tarsier {
         double squaredSigmaY;
     } __attribute__((packed));
 
+    /// BlobsView is a structure-of-arrays view on the tracked blobs' parameters.
+    struct BlobsView {
+        std::size_t size;
+        const double* xs;
+        const double* ys;
+        const double* squaredSigmaXs;
+        const double* sigmaXYs;
+        const double* squaredSigmaYs;
+    };
+
+    /// blobExponent calculates the exponent of the gaussian probability density
+    /// at the given position relative to a blob's center.
+    inline double blobExponent(double xPosition, double yPosition, double squaredSigmaX, double sigmaXY, double squaredSigmaY, double determinant) {
+        return -(
+            xPosition * xPosition * squaredSigmaY
+            + yPosition * yPosition * squaredSigmaX
+            - 2 * xPosition * yPosition * sigmaXY
+        ) / (2 * determinant);
+    }
+
+    /// blobDensity calculates the gaussian probability density (without the 1 / (2 * pi) factor)
+    /// at the given position relative to a blob's center.
+    inline double blobDensity(double xPosition, double yPosition, double squaredSigmaX, double sigmaXY, double squaredSigmaY) {
+        const auto determinant = squaredSigmaX * squaredSigmaY - sigmaXY * sigmaXY;
+        return
+            std::exp(blobExponent(xPosition, yPosition, squaredSigmaX, sigmaXY, squaredSigmaY, determinant))
+            /
+            std::sqrt(determinant)
+        ;
+    }
+
+    /// ExhaustiveWinnerSearch evaluates the probability of every blob for every event.
+    class ExhaustiveWinnerSearch {
+        public:
+
+            /// reserve preallocates memory for the given number of blobs.
+            void reserve(std::size_t capacity) {
+                _exponents.reserve(capacity);
+                _squareRoots.reserve(capacity);
+            }
+
+            /// insert adds the blob with the given index.
+            void insert(std::size_t, const Blob&) {}
+
+            /// update notifies the index that the blob with the given index changed.
+            void update(std::size_t, const Blob&) {}
+
+            /// erase removes the blob with the given index, and gives its index to the last blob.
+            void erase(std::size_t) {}
+
+            /// operator() returns the index of the most probable blob, or blobs.size if no blob has a positive probability.
+            std::size_t operator()(uint64_t x, uint64_t y, const BlobsView& blobs, double& probability) {
+                // the exponents and normalisation factors are calculated in a separate (vectorizable) loop
+                _exponents.resize(blobs.size);
+                _squareRoots.resize(blobs.size);
+                for (std::size_t index = 0; index < blobs.size; ++index) {
+                    const auto determinant = blobs.squaredSigmaXs[index] * blobs.squaredSigmaYs[index] - blobs.sigmaXYs[index] * blobs.sigmaXYs[index];
+                    _exponents[index] = blobExponent(
+                        static_cast<double>(x) - blobs.xs[index],
+                        static_cast<double>(y) - blobs.ys[index],
+                        blobs.squaredSigmaXs[index],
+                        blobs.sigmaXYs[index],
+                        blobs.squaredSigmaYs[index],
+                        determinant
+                    );
+                    _squareRoots[index] = std::sqrt(determinant);
+                }
+                probability = 0;
+                auto winner = blobs.size;
+                for (auto index = blobs.size; index > 0; --index) {
+                    const auto candidate = std::exp(_exponents[index - 1]) / _squareRoots[index - 1];
+                    if (candidate > probability) {
+                        probability = candidate;
+                        winner = index - 1;
+                    }
+                }
+                return winner;
+            }
+
+        protected:
+            std::vector<double> _exponents;
+            std::vector<double> _squareRoots;
+    };
+
+    /// GridWinnerSearch registers every blob in the cells of a uniform grid covered by its 3-sigma bounding box.
+    /// Only the blobs registered in the event's cell are evaluated, hence an event further than 3 sigmas
+    /// from every blob has no winner. Otherwise, the winner is the same as with ExhaustiveWinnerSearch.
+    template <uint64_t width, uint64_t height, uint64_t cellSize>
+    class GridWinnerSearch {
+        static_assert(cellSize > 0, "cellSize must be strictly positive");
+        public:
+            GridWinnerSearch() :
+                _cells(columns * rows)
+            {
+            }
+            GridWinnerSearch(const GridWinnerSearch&) = default;
+            GridWinnerSearch(GridWinnerSearch&&) = default;
+            GridWinnerSearch& operator=(const GridWinnerSearch&) = default;
+            GridWinnerSearch& operator=(GridWinnerSearch&&) = default;
+            virtual ~GridWinnerSearch() {}
+
+            /// reserve preallocates memory for the given number of blobs.
+            /// The cells still grow on demand, until they reach their largest occupancy.
+            void reserve(std::size_t capacity) {
+                _extents.reserve(capacity);
+            }
+
+            /// insert adds the blob with the given index.
+            void insert(std::size_t index, const Blob& blob) {
+                if (index >= _extents.size()) {
+                    _extents.resize(index + 1, Extent{0, 0, 0, 0});
+                }
+                _extents[index] = extentOf(blob);
+                add(index);
+            }
+
+            /// update notifies the index that the blob with the given index changed.
+            void update(std::size_t index, const Blob& blob) {
+                const auto extent = extentOf(blob);
+                if (
+                    extent.left != _extents[index].left
+                    || extent.right != _extents[index].right
+                    || extent.bottom != _extents[index].bottom
+                    || extent.top != _extents[index].top
+                ) {
+                    remove(index);
+                    _extents[index] = extent;
+                    add(index);
+                }
+            }
+
+            /// erase removes the blob with the given index, and gives its index to the last blob.
+            void erase(std::size_t index) {
+                remove(index);
+                const auto last = _extents.size() - 1;
+                if (index != last) {
+                    forEachCell(_extents[last], [index, last](std::vector<std::size_t>& cell) {
+                        *std::find(cell.begin(), cell.end(), last) = index;
+                    });
+                    _extents[index] = _extents[last];
+                }
+                _extents.pop_back();
+            }
+
+            /// operator() returns the index of the most probable blob, or blobs.size if no blob has a positive probability.
+            std::size_t operator()(uint64_t x, uint64_t y, const BlobsView& blobs, double& probability) const {
+                probability = 0;
+                auto winner = blobs.size;
+                if (x < width && y < height) {
+                    for (auto index : _cells[x / cellSize + (y / cellSize) * columns]) {
+                        const auto candidate = blobDensity(
+                            static_cast<double>(x) - blobs.xs[index],
+                            static_cast<double>(y) - blobs.ys[index],
+                            blobs.squaredSigmaXs[index],
+                            blobs.sigmaXYs[index],
+                            blobs.squaredSigmaYs[index]
+                        );
+                        if (candidate > probability || (candidate == probability && candidate > 0 && index > winner)) {
+                            probability = candidate;
+                            winner = index;
+                        }
+                    }
+                }
+                return winner;
+            }
+
+        protected:
+            static constexpr uint64_t columns = (width + cellSize - 1) / cellSize;
+            static constexpr uint64_t rows = (height + cellSize - 1) / cellSize;
+
+            /// Extent represents the range of cells covered by a blob, with exclusive upper bounds.
+            struct Extent {
+                uint64_t left;
+                uint64_t right;
+                uint64_t bottom;
+                uint64_t top;
+            };
+
+            /// cellRange converts a coordinates interval to a range of cells.
+            static std::pair<uint64_t, uint64_t> cellRange(double minimum, double maximum, uint64_t size) {
+                if (!(maximum >= 0) || !(minimum < static_cast<double>(size * cellSize))) {
+                    return std::make_pair(static_cast<uint64_t>(0), static_cast<uint64_t>(0));
+                }
+                return std::make_pair(
+                    minimum <= 0 ? static_cast<uint64_t>(0) : static_cast<uint64_t>(minimum) / cellSize,
+                    maximum >= static_cast<double>(size * cellSize) ? size : static_cast<uint64_t>(maximum) / cellSize + 1
+                );
+            }
+
+            /// extentOf calculates the cells covered by the blob's 3-sigma bounding box.
+            static Extent extentOf(const Blob& blob) {
+                const auto xRadius = 3 * std::sqrt(blob.squaredSigmaX);
+                const auto yRadius = 3 * std::sqrt(blob.squaredSigmaY);
+                const auto xRange = cellRange(blob.x - xRadius, blob.x + xRadius, columns);
+                const auto yRange = cellRange(blob.y - yRadius, blob.y + yRadius, rows);
+                if (xRange.first == xRange.second || yRange.first == yRange.second) {
+                    return Extent{0, 0, 0, 0};
+                }
+                return Extent{xRange.first, xRange.second, yRange.first, yRange.second};
+            }
+
+            /// forEachCell calls operation on every cell covered by the extent.
+            template <typename Operation>
+            void forEachCell(const Extent& extent, Operation operation) {
+                for (auto row = extent.bottom; row < extent.top; ++row) {
+                    for (auto column = extent.left; column < extent.right; ++column) {
+                        operation(_cells[column + row * columns]);
+                    }
+                }
+            }
+
+            /// add registers the blob's index in the cells covered by its extent.
+            void add(std::size_t index) {
+                forEachCell(_extents[index], [index](std::vector<std::size_t>& cell) {
+                    cell.push_back(index);
+                });
+            }
+
+            /// remove unregisters the blob's index from the cells covered by its extent.
+            void remove(std::size_t index) {
+                forEachCell(_extents[index], [index](std::vector<std::size_t>& cell) {
+                    cell.erase(std::find(cell.begin(), cell.end(), index));
+                });
+            }
+
+            std::vector<std::vector<std::size_t>> _cells;
+            std::vector<Extent> _extents;
+    };
+
+    /// PairwiseRepulsion calculates the repulsion between every pair of blobs.
+    class PairwiseRepulsion {
+        public:
+
+            /// reserve preallocates memory for the given number of blobs.
+            void reserve(std::size_t) {}
+
+            /// operator() subtracts the repulsion displacements from xDeltas and yDeltas.
+            void operator()(
+                std::size_t size,
+                const double* xs,
+                const double* ys,
+                const double* squaredActivities,
+                double repulsionStrength,
+                double repulsionLength,
+                double* xDeltas,
+                double* yDeltas
+            ) {
+                for (std::size_t index = 0; index < size; ++index) {
+                    for (auto otherIndex = index + 1; otherIndex < size; ++otherIndex) {
+                        repel(index, otherIndex, xs, ys, squaredActivities, repulsionStrength, repulsionLength, xDeltas, yDeltas);
+                    }
+                }
+            }
+
+            /// repel calculates the repulsion between two blobs.
+            static void repel(
+                std::size_t index,
+                std::size_t otherIndex,
+                const double* xs,
+                const double* ys,
+                const double* squaredActivities,
+                double repulsionStrength,
+                double repulsionLength,
+                double* xDeltas,
+                double* yDeltas
+            ) {
+                const auto activitySum = squaredActivities[index] + squaredActivities[otherIndex];
+                const auto distanceDecay = repulsionStrength * std::exp(
+                    -std::hypot(xs[index] - xs[otherIndex], ys[index] - ys[otherIndex]) / repulsionLength
+                );
+                {
+                    const auto activityCorrection = (activitySum == 0 ? 0 : squaredActivities[otherIndex] / activitySum);
+                    xDeltas[index] -= distanceDecay * activityCorrection * (xs[otherIndex] - xs[index]);
+                    yDeltas[index] -= distanceDecay * activityCorrection * (ys[otherIndex] - ys[index]);
+                }
+                {
+                    const auto activityCorrection = (activitySum == 0 ? 0 : squaredActivities[index] / activitySum);
+                    xDeltas[otherIndex] -= distanceDecay * activityCorrection * (xs[index] - xs[otherIndex]);
+                    yDeltas[otherIndex] -= distanceDecay * activityCorrection * (ys[index] - ys[otherIndex]);
+                }
+            }
+    };
+
+    /// CellListRepulsion only calculates the repulsion between blobs closer than cutoff * repulsionLength.
+    /// The blobs are sorted in a cell list with cells larger than the cutoff, so that each blob is only compared
+    /// with the blobs in its cell and the adjacent ones. The neglected repulsions are smaller than
+    /// repulsionStrength * exp(-cutoff) times the distance.
+    template <std::size_t cutoff>
+    class CellListRepulsion {
+        static_assert(cutoff > 0, "cutoff must be strictly positive");
+        public:
+
+            /// reserve preallocates memory for the given number of blobs.
+            void reserve(std::size_t capacity) {
+                _cells.reserve(capacity);
+                _offsets.reserve(4 * capacity + 65);
+                _cursors.reserve(4 * capacity + 64);
+                _indices.reserve(capacity);
+            }
+
+            /// operator() subtracts the repulsion displacements from xDeltas and yDeltas.
+            void operator()(
+                std::size_t size,
+                const double* xs,
+                const double* ys,
+                const double* squaredActivities,
+                double repulsionStrength,
+                double repulsionLength,
+                double* xDeltas,
+                double* yDeltas
+            ) {
+                if (size < 2) {
+                    return;
+                }
+                const auto squaredCutoffDistance = std::pow(cutoff * repulsionLength, 2);
+                auto left = std::numeric_limits<double>::infinity();
+                auto right = -std::numeric_limits<double>::infinity();
+                auto bottom = std::numeric_limits<double>::infinity();
+                auto top = -std::numeric_limits<double>::infinity();
+                for (std::size_t index = 0; index < size; ++index) {
+                    if (std::isfinite(xs[index]) && std::isfinite(ys[index])) {
+                        left = std::min(left, xs[index]);
+                        right = std::max(right, xs[index]);
+                        bottom = std::min(bottom, ys[index]);
+                        top = std::max(top, ys[index]);
+                    }
+                }
+                if (left > right) {
+                    return;
+                }
+                auto cellSize = cutoff * repulsionLength;
+                auto columns = static_cast<std::size_t>((right - left) / cellSize) + 1;
+                auto rows = static_cast<std::size_t>((top - bottom) / cellSize) + 1;
+                while (static_cast<double>(columns) * static_cast<double>(rows) > static_cast<double>(4 * size + 64)) {
+                    cellSize *= 2;
+                    columns = static_cast<std::size_t>((right - left) / cellSize) + 1;
+                    rows = static_cast<std::size_t>((top - bottom) / cellSize) + 1;
+                }
+
+                // counting sort of the blobs by cell
+                _cells.resize(size);
+                _offsets.assign(columns * rows + 1, 0);
+                for (std::size_t index = 0; index < size; ++index) {
+                    if (std::isfinite(xs[index]) && std::isfinite(ys[index])) {
+                        _cells[index] =
+                            std::min(static_cast<std::size_t>((xs[index] - left) / cellSize), columns - 1)
+                            + std::min(static_cast<std::size_t>((ys[index] - bottom) / cellSize), rows - 1) * columns;
+                        ++_offsets[_cells[index] + 1];
+                    } else {
+                        _cells[index] = columns * rows;
+                    }
+                }
+                for (std::size_t cell = 0; cell < columns * rows; ++cell) {
+                    _offsets[cell + 1] += _offsets[cell];
+                }
+                _indices.resize(_offsets.back());
+                _cursors.assign(_offsets.begin(), std::prev(_offsets.end()));
+                for (std::size_t index = 0; index < size; ++index) {
+                    if (_cells[index] < columns * rows) {
+                        _indices[_cursors[_cells[index]]] = index;
+                        ++_cursors[_cells[index]];
+                    }
+                }
+
+                // each pair of adjacent cells is visited once, using the cell itself and four of its neighbours
+                for (std::size_t row = 0; row < rows; ++row) {
+                    for (std::size_t column = 0; column < columns; ++column) {
+                        const auto cell = column + row * columns;
+                        for (auto first = _offsets[cell]; first < _offsets[cell + 1]; ++first) {
+                            for (auto second = first + 1; second < _offsets[cell + 1]; ++second) {
+                                repelIfClose(_indices[first], _indices[second], xs, ys, squaredActivities, repulsionStrength, repulsionLength, squaredCutoffDistance, xDeltas, yDeltas);
+                            }
+                        }
+                        const std::pair<std::ptrdiff_t, std::ptrdiff_t> neighbours[] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+                        for (auto neighbour : neighbours) {
+                            const auto otherColumn = static_cast<std::ptrdiff_t>(column) + neighbour.first;
+                            const auto otherRow = row + neighbour.second;
+                            if (otherColumn < 0 || otherColumn >= static_cast<std::ptrdiff_t>(columns) || otherRow >= rows) {
+                                continue;
+                            }
+                            const auto otherCell = static_cast<std::size_t>(otherColumn) + otherRow * columns;
+                            for (auto first = _offsets[cell]; first < _offsets[cell + 1]; ++first) {
+                                for (auto second = _offsets[otherCell]; second < _offsets[otherCell + 1]; ++second) {
+                                    repelIfClose(_indices[first], _indices[second], xs, ys, squaredActivities, repulsionStrength, repulsionLength, squaredCutoffDistance, xDeltas, yDeltas);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+
+        protected:
+
+            /// repelIfClose calculates the repulsion between two blobs if they are closer than the cutoff distance.
+            static void repelIfClose(
+                std::size_t index,
+                std::size_t otherIndex,
+                const double* xs,
+                const double* ys,
+                const double* squaredActivities,
+                double repulsionStrength,
+                double repulsionLength,
+                double squaredCutoffDistance,
+                double* xDeltas,
+                double* yDeltas
+            ) {
+                if (std::pow(xs[index] - xs[otherIndex], 2) + std::pow(ys[index] - ys[otherIndex], 2) < squaredCutoffDistance) {
+                    PairwiseRepulsion::repel(
+                        std::min(index, otherIndex),
+                        std::max(index, otherIndex),
+                        xs,
+                        ys,
+                        squaredActivities,
+                        repulsionStrength,
+                        repulsionLength,
+                        xDeltas,
+                        yDeltas
+                    );
+                }
+            }
+
+            std::vector<std::size_t> _cells;
+            std::vector<std::size_t> _offsets;
+            std::vector<std::size_t> _cursors;
+            std::vector<std::size_t> _indices;
+    };
+
     /// TrackBlobs tracks the incoming events with gaussian blobs.
     /// HandlePromotedBlob must have the signature:
     ///     handlePromotedBlob(std::size_t id, const Blob& blob) -> void
@@ -38,6 +466,14 @@ namespace tarsier {
     ///     handleUpdatedBlob(std::size_t id, const Blob& blob) -> void
     /// HandleDemotedBlob must have the signature:
     ///     handleDemotedBlob(std::size_t id, const Blob& blob) -> void
+    /// WinnerSearch selects the blob which absorbs each event (see ExhaustiveWinnerSearch and GridWinnerSearch).
+    /// Repulsion calculates the displacements which push blobs apart (see PairwiseRepulsion and CellListRepulsion).
+    /// The blobs are stored as a structure of arrays. Deleted blobs are replaced with the last blob, hence ids are stable
+    /// but indexes are not. The initial (hidden) blobs are never deleted, and keep the first indexes.
+    /// Activities are decayed on demand from their last update, and the promoted and demoted blobs are kept in a heap
+    /// sorted by the timestamp at which their activity crosses the next threshold.
+    /// If capacity is not zero, the memory for capacity blobs is allocated on construction and the event path does not
+    /// allocate (with the default policies or CellListRepulsion). Hidden blobs are not promoted while the tracker is full.
     template <
         typename Event,
         typename HandlePromotedBlob,
@@ -46,7 +482,10 @@ namespace tarsier {
         typename HandlePromotedHiddenBlob,
         typename HandleUpdatedHiddenBlob,
         typename HandleDemotedHiddenBlob,
-        typename HandleDeletedBlob
+        typename HandleDeletedBlob,
+        typename WinnerSearch = ExhaustiveWinnerSearch,
+        typename Repulsion = PairwiseRepulsion,
+        std::size_t capacity = 0
     >
     class TrackBlobs {
         public:
@@ -90,17 +529,32 @@ namespace tarsier {
                 _handleUpdatedHiddenBlob(std::forward<HandleUpdatedHiddenBlob>(handleUpdatedHiddenBlob)),
                 _handleDemotedHiddenBlob(std::forward<HandleDemotedHiddenBlob>(handleDemotedHiddenBlob)),
                 _handleDeletedBlob(std::forward<HandleDeletedBlob>(handleDeletedBlob)),
-                _previousTimestamp(0),
                 _skippedEvents(0),
                 _inhibitedEvents(0),
-                _datum(_initialBlobs.size()),
                 _idOffset(_initialBlobs.size())
             {
+                if (capacity > 0) {
+                    if (_initialBlobs.size() > capacity) {
+                        throw std::logic_error("the number of initial blobs cannot be larger than the capacity");
+                    }
+                    _ids.reserve(capacity);
+                    _xs.reserve(capacity);
+                    _ys.reserve(capacity);
+                    _squaredSigmaXs.reserve(capacity);
+                    _sigmaXYs.reserve(capacity);
+                    _squaredSigmaYs.reserve(capacity);
+                    _activities.reserve(capacity);
+                    _activityTimestamps.reserve(capacity);
+                    _statuses.reserve(capacity);
+                    _crossings.reserve(capacity);
+                    _xDeltas.reserve(capacity);
+                    _yDeltas.reserve(capacity);
+                    _squaredActivities.reserve(capacity);
+                    _winnerSearch.reserve(capacity);
+                    _repulsion.reserve(capacity);
+                }
                 for (auto blobIterator = _initialBlobs.begin(); blobIterator != _initialBlobs.end(); ++blobIterator) {
-                    _datum[blobIterator - _initialBlobs.begin()].id = blobIterator - _initialBlobs.begin();
-                    _datum[blobIterator - _initialBlobs.begin()].blob = *blobIterator;
-                    _datum[blobIterator - _initialBlobs.begin()].activity = 0;
-                    _datum[blobIterator - _initialBlobs.begin()].status = Status::hidden;
+                    pushBack(blobIterator - _initialBlobs.begin(), *blobIterator, 0, 0, Status::hidden);
                     _handlePromotedHiddenBlob((blobIterator - _initialBlobs.begin()), *blobIterator);
                 }
             }
@@ -114,166 +568,145 @@ namespace tarsier {
             virtual void operator()(Event event) {
                 {
                     auto probability = 0.0;
-                    auto winner = _datum.end();
-                    for (auto dataIterator = _datum.rbegin(); dataIterator != _datum.rend(); ++dataIterator) {
-                        const auto xPosition = static_cast<double>(event.x) - dataIterator->blob.x;
-                        const auto yPosition = static_cast<double>(event.y) - dataIterator->blob.y;
-                        const auto determinant = dataIterator->blob.squaredSigmaX * dataIterator->blob.squaredSigmaY - std::pow(dataIterator->blob.sigmaXY, 2);
-                        const auto probabilityCandidate =
-                            std::exp(-(
-                                std::pow(xPosition, 2) * dataIterator->blob.squaredSigmaY
-                                + std::pow(yPosition, 2) * dataIterator->blob.squaredSigmaX
-                                - 2 * xPosition * yPosition * dataIterator->blob.sigmaXY
-                            ) / (2 * determinant))
-                            /
-                            std::sqrt(determinant)
-                        ;
-                        if (probabilityCandidate > probability) {
-                            probability = probabilityCandidate;
-                            winner = std::next(dataIterator).base();
-                        }
-                    }
+                    const auto winner = _winnerSearch(
+                        event.x,
+                        event.y,
+                        BlobsView{
+                            _ids.size(),
+                            _xs.data(),
+                            _ys.data(),
+                            _squaredSigmaXs.data(),
+                            _sigmaXYs.data(),
+                            _squaredSigmaYs.data(),
+                        },
+                        probability
+                    );
                     probability /= (2 * M_PI);
 
-                    const auto exponentialDecay = std::exp(-static_cast<double>(event.timestamp - _previousTimestamp) / _activityDecay);
-                    auto datumToAdd = std::vector<Data>();
-                    for (auto dataIterator = _datum.begin(); dataIterator != _datum.end();) {
-                        dataIterator->activity *= exponentialDecay;
-                        if (dataIterator == winner && probability > _minimumProbability) {
-                            winner->activity += probability;
-                            dataIterator->blob.x = _meanInertia * dataIterator->blob.x + (1 - _meanInertia) * static_cast<double>(event.x);
-                            dataIterator->blob.y = _meanInertia * dataIterator->blob.y + (1 - _meanInertia) * static_cast<double>(event.y);
-                            const auto xPosition = static_cast<double>(event.x) - dataIterator->blob.x;
-                            const auto yPosition = static_cast<double>(event.y) - dataIterator->blob.y;
-                            dataIterator->blob.squaredSigmaX = _covarianceInertia * dataIterator->blob.squaredSigmaX
-                                + (1 - _covarianceInertia) * std::pow(xPosition, 2);
-                            dataIterator->blob.sigmaXY = _covarianceInertia * dataIterator->blob.sigmaXY
-                                + (1 - _covarianceInertia) * xPosition * yPosition;
-                            dataIterator->blob.squaredSigmaY = _covarianceInertia * dataIterator->blob.squaredSigmaY
-                                + (1 - _covarianceInertia) * std::pow(yPosition, 2);
-                            if (dataIterator->status == Status::promoted) {
-                                _handleUpdatedBlob(dataIterator->id, dataIterator->blob);
-                            } else {
-                                _handleUpdatedHiddenBlob(dataIterator->id, dataIterator->blob);
-                            }
+                    if (winner < _ids.size() && probability > _minimumProbability) {
+                        _activities[winner] = activityAt(winner, event.timestamp) + probability;
+                        _activityTimestamps[winner] = event.timestamp;
+                        _xs[winner] = _meanInertia * _xs[winner] + (1 - _meanInertia) * static_cast<double>(event.x);
+                        _ys[winner] = _meanInertia * _ys[winner] + (1 - _meanInertia) * static_cast<double>(event.y);
+                        const auto xPosition = static_cast<double>(event.x) - _xs[winner];
+                        const auto yPosition = static_cast<double>(event.y) - _ys[winner];
+                        _squaredSigmaXs[winner] = _covarianceInertia * _squaredSigmaXs[winner]
+                            + (1 - _covarianceInertia) * std::pow(xPosition, 2);
+                        _sigmaXYs[winner] = _covarianceInertia * _sigmaXYs[winner]
+                            + (1 - _covarianceInertia) * xPosition * yPosition;
+                        _squaredSigmaYs[winner] = _covarianceInertia * _squaredSigmaYs[winner]
+                            + (1 - _covarianceInertia) * std::pow(yPosition, 2);
+                        const auto blob = blobAt(winner);
+                        _winnerSearch.update(winner, blob);
+                        if (_statuses[winner] == Status::promoted) {
+                            _handleUpdatedBlob(_ids[winner], blob);
+                        } else {
+                            _handleUpdatedHiddenBlob(_ids[winner], blob);
                         }
 
-                        switch (dataIterator->status) {
+                        // only the winner's activity increases, hence it is the only blob which can be promoted
+                        switch (_statuses[winner]) {
                             case Status::hidden:
-                                if (dataIterator->activity > _promotionActivity) {
-                                    datumToAdd.push_back(Data{
-                                        _idOffset,
-                                        dataIterator->blob,
-                                        dataIterator->activity,
-                                        Status::promoted,
-                                    });
-                                    _handlePromotedBlob(datumToAdd.back().id, datumToAdd.back().blob);
+                                if (_activities[winner] > _promotionActivity && (capacity == 0 || _ids.size() < capacity)) {
+                                    const auto activity = _activities[winner];
+                                    _handlePromotedBlob(_idOffset, blob);
+                                    setBlob(winner, _initialBlobs[_ids[winner]]);
+                                    _activities[winner] = 0;
+                                    _winnerSearch.update(winner, _initialBlobs[_ids[winner]]);
+                                    _handleUpdatedHiddenBlob(_ids[winner], _initialBlobs[_ids[winner]]);
+                                    pushBack(_idOffset, blob, activity, event.timestamp, Status::promoted);
                                     ++_idOffset;
-                                    dataIterator->blob = _initialBlobs[dataIterator->id];
-                                    dataIterator->activity = 0;
-                                    _handleUpdatedHiddenBlob(dataIterator->id, dataIterator->blob);
                                 }
-                                ++dataIterator;
                                 break;
                             case Status::promoted:
-                                if (dataIterator->activity <= _promotionActivity) {
-                                    if (dataIterator->activity <= _deletionActivity) {
-                                        _handleDeletedBlob(dataIterator->id, dataIterator->blob);
-                                        dataIterator = _datum.erase(dataIterator);
-                                    } else {
-                                        _handleDemotedBlob(dataIterator->id, dataIterator->blob);
-                                        _handlePromotedHiddenBlob(dataIterator->id, dataIterator->blob);
-                                        dataIterator->status = Status::demoted;
-                                        ++dataIterator;
-                                    }
-                                } else {
-                                    ++dataIterator;
-                                }
+                                schedule(winner);
                                 break;
-
                             case Status::demoted:
-                                if (dataIterator->activity <= _deletionActivity) {
-                                    _handleDeletedBlob(dataIterator->id, dataIterator->blob);
-                                    dataIterator = _datum.erase(dataIterator);
-                                } else if (dataIterator->activity > _promotionActivity) {
-                                    _handlePromotedBlob(dataIterator->id, dataIterator->blob);
-                                    _handleDemotedHiddenBlob(dataIterator->id, dataIterator->blob);
-                                    dataIterator->status = Status::promoted;
-                                    ++dataIterator;
-                                } else {
-                                    ++dataIterator;
+                                if (_activities[winner] > _promotionActivity) {
+                                    _handlePromotedBlob(_ids[winner], blob);
+                                    _handleDemotedHiddenBlob(_ids[winner], blob);
+                                    _statuses[winner] = Status::promoted;
                                 }
+                                schedule(winner);
                                 break;
                         }
                     }
-                    _datum.insert(_datum.end(), datumToAdd.begin(), datumToAdd.end());
+
+                    // the other blobs' activities decrease, and are checked when they cross a threshold
+                    while (!_crossings.empty() && _crossings.topKey() <= static_cast<double>(event.timestamp)) {
+                        const auto index = _crossings.top();
+                        if (
+                            _statuses[index] == Status::promoted
+                            && crossing(index, _deletionActivity) > static_cast<double>(event.timestamp)
+                        ) {
+                            const auto blob = blobAt(index);
+                            _handleDemotedBlob(_ids[index], blob);
+                            _handlePromotedHiddenBlob(_ids[index], blob);
+                            _statuses[index] = Status::demoted;
+                            schedule(index);
+                        } else {
+                            _handleDeletedBlob(_ids[index], blobAt(index));
+                            swapAndPop(index);
+                        }
+                    }
                 }
 
                 if (_skippedEvents >= _pairwiseCalculationsToSkip) {
                     _skippedEvents = 0;
-                    auto xDeltas = std::vector<double>(_datum.size());
-                    auto yDeltas = std::vector<double>(_datum.size());
-                    for (auto dataIterator = _datum.begin(); dataIterator != _datum.end(); ++dataIterator) {
-                        for (auto otherDataIterator = std::next(dataIterator); otherDataIterator != _datum.end(); ++otherDataIterator) {
-                            const auto squaredActivity = std::pow(dataIterator->activity, 2);
-                            const auto otherSquaredActivity = std::pow(otherDataIterator->activity, 2);
-                            const auto activitySum = squaredActivity + otherSquaredActivity;
-                            const auto distanceDecay = _repulsionStrength * std::exp(
-                                -std::hypot(dataIterator->blob.x - otherDataIterator->blob.x, dataIterator->blob.y - otherDataIterator->blob.y)
-                                /
-                                _repulsionLength
-                            );
-                            {
-                                const auto activityCorrection = (activitySum == 0 ? 0 : otherSquaredActivity / activitySum);
-                                xDeltas[dataIterator - _datum.begin()] -= distanceDecay * activityCorrection * (
-                                    otherDataIterator->blob.x - dataIterator->blob.x
-                                );
-                                yDeltas[dataIterator - _datum.begin()] -= distanceDecay * activityCorrection * (
-                                    otherDataIterator->blob.y - dataIterator->blob.y
-                                );
-                            }
-                            {
-                                const auto activityCorrection = (activitySum == 0 ? 0 : squaredActivity / activitySum);
-                                xDeltas[otherDataIterator - _datum.begin()] -= distanceDecay * activityCorrection * (
-                                    dataIterator->blob.x
-                                    -
-                                    otherDataIterator->blob.x
-                                );
-                                yDeltas[otherDataIterator - _datum.begin()] -= distanceDecay * activityCorrection * (
-                                    dataIterator->blob.y
-                                    -
-                                    otherDataIterator->blob.y
-                                );
-                            }
-                        }
+                    _xDeltas.assign(_ids.size(), 0);
+                    _yDeltas.assign(_ids.size(), 0);
+                    _squaredActivities.resize(_ids.size());
+                    for (std::size_t index = 0; index < _ids.size(); ++index) {
+                        _squaredActivities[index] = std::pow(activityAt(index, event.timestamp), 2);
                     }
-                    std::for_each(_datum.begin(), std::next(_datum.begin(), _initialBlobs.size()), [this, &xDeltas, &yDeltas](Data& data) {
+                    _repulsion(
+                        _ids.size(),
+                        _xs.data(),
+                        _ys.data(),
+                        _squaredActivities.data(),
+                        _repulsionStrength,
+                        _repulsionLength,
+                        _xDeltas.data(),
+                        _yDeltas.data()
+                    );
+                    for (std::size_t index = 0; index < _initialBlobs.size(); ++index) {
                         if (
-                            std::pow(_initialBlobs[data.id].x - data.blob.x, 2) + std::pow(_initialBlobs[data.id].y - data.blob.y, 2)
+                            std::pow(_initialBlobs[index].x - _xs[index], 2) + std::pow(_initialBlobs[index].y - _ys[index], 2)
                             < _attractionResetDistanceSquared
                         ) {
-                            xDeltas[data.id] += _attractionStrength * (_initialBlobs[data.id].x - data.blob.x);
-                            yDeltas[data.id] += _attractionStrength * (_initialBlobs[data.id].y - data.blob.y);
+                            _xDeltas[index] += _attractionStrength * (_initialBlobs[index].x - _xs[index]);
+                            _yDeltas[index] += _attractionStrength * (_initialBlobs[index].y - _ys[index]);
                         } else {
-                            xDeltas[data.id] = 0;
-                            yDeltas[data.id] = 0;
-                            data.blob = _initialBlobs[data.id];
-                            data.activity = 0;
+                            _xDeltas[index] = 0;
+                            _yDeltas[index] = 0;
+                            setBlob(index, _initialBlobs[index]);
+                            _activities[index] = 0;
+                            _activityTimestamps[index] = event.timestamp;
                         }
-                    });
-                    for (auto dataIterator = _datum.begin(); dataIterator != _datum.end(); ++dataIterator) {
-                        dataIterator->blob.x += xDeltas[dataIterator - _datum.begin()];
-                        dataIterator->blob.y += yDeltas[dataIterator - _datum.begin()];
-                        if (dataIterator->status == Status::promoted) {
-                            _handleUpdatedBlob(dataIterator->id, dataIterator->blob);
+                    }
+                    for (std::size_t index = 0; index < _ids.size(); ++index) {
+                        _xs[index] += _xDeltas[index];
+                        _ys[index] += _yDeltas[index];
+                    }
+                    for (std::size_t index = 0; index < _ids.size(); ++index) {
+                        const auto blob = blobAt(index);
+                        _winnerSearch.update(index, blob);
+                        if (_statuses[index] == Status::promoted) {
+                            _handleUpdatedBlob(_ids[index], blob);
                         } else {
-                            _handleUpdatedHiddenBlob(dataIterator->id, dataIterator->blob);
+                            _handleUpdatedHiddenBlob(_ids[index], blob);
                         }
                     }
                 } else {
                     ++_skippedEvents;
                 }
-                _previousTimestamp = event.timestamp;
+            }
+
+            /// operator() handles a contiguous range of events.
+            void operator()(Event* begin, Event* end) {
+                for (; begin != end; ++begin) {
+                    TrackBlobs::operator()(*begin);
+                }
             }
 
         protected:
@@ -285,14 +718,191 @@ namespace tarsier {
                 demoted,
             };
 
-            /// Data represents the algorithm's inner data associated with a blob.
-            struct Data {
-                std::size_t id;
-                Blob blob;
-                double activity;
-                Status status;
+            /// Crossings is an indexed min-heap of the blobs' next threshold crossing timestamps.
+            class Crossings {
+                public:
+
+                    /// reserve preallocates memory for the given number of blobs.
+                    void reserve(std::size_t size) {
+                        _heap.reserve(size);
+                        _positions.reserve(size);
+                        _keys.reserve(size);
+                    }
+
+                    /// empty determines whether the heap contains blobs.
+                    bool empty() const {
+                        return _heap.empty();
+                    }
+
+                    /// top returns the index of the blob with the earliest crossing.
+                    std::size_t top() const {
+                        return _heap.front();
+                    }
+
+                    /// topKey returns the earliest crossing.
+                    double topKey() const {
+                        return _keys[_heap.front()];
+                    }
+
+                    /// set inserts a blob or updates its crossing.
+                    void set(std::size_t index, double key) {
+                        if (index >= _positions.size()) {
+                            _positions.resize(index + 1, std::numeric_limits<std::size_t>::max());
+                            _keys.resize(index + 1, 0);
+                        }
+                        _keys[index] = key;
+                        if (_positions[index] == absent) {
+                            _positions[index] = _heap.size();
+                            _heap.push_back(index);
+                        }
+                        siftDown(siftUp(_positions[index]));
+                    }
+
+                    /// erase removes a blob from the heap, if it belongs to it.
+                    void erase(std::size_t index) {
+                        if (index >= _positions.size() || _positions[index] == absent) {
+                            return;
+                        }
+                        const auto position = _positions[index];
+                        _positions[index] = absent;
+                        const auto last = _heap.back();
+                        _heap.pop_back();
+                        if (position < _heap.size()) {
+                            _heap[position] = last;
+                            _positions[last] = position;
+                            siftDown(siftUp(position));
+                        }
+                    }
+
+                    /// relabel gives the entry of the blob from (if any) to the blob to, which must not belong to the heap.
+                    void relabel(std::size_t from, std::size_t to) {
+                        if (from >= _positions.size() || _positions[from] == absent) {
+                            return;
+                        }
+                        _positions[to] = _positions[from];
+                        _keys[to] = _keys[from];
+                        _heap[_positions[to]] = to;
+                        _positions[from] = absent;
+                    }
+
+                protected:
+                    static constexpr std::size_t absent = std::numeric_limits<std::size_t>::max();
+
+                    /// siftUp moves an entry towards the root, and returns its new position.
+                    std::size_t siftUp(std::size_t position) {
+                        while (position > 0 && _keys[_heap[position]] < _keys[_heap[(position - 1) / 2]]) {
+                            swap(position, (position - 1) / 2);
+                            position = (position - 1) / 2;
+                        }
+                        return position;
+                    }
+
+                    /// siftDown moves an entry towards the leaves.
+                    void siftDown(std::size_t position) {
+                        for (;;) {
+                            auto smallest = position;
+                            for (auto child = 2 * position + 1; child < std::min(2 * position + 3, _heap.size()); ++child) {
+                                if (_keys[_heap[child]] < _keys[_heap[smallest]]) {
+                                    smallest = child;
+                                }
+                            }
+                            if (smallest == position) {
+                                return;
+                            }
+                            swap(position, smallest);
+                            position = smallest;
+                        }
+                    }
+
+                    /// swap exchanges two entries.
+                    void swap(std::size_t first, std::size_t second) {
+                        std::swap(_heap[first], _heap[second]);
+                        _positions[_heap[first]] = first;
+                        _positions[_heap[second]] = second;
+                    }
+
+                    std::vector<std::size_t> _heap;
+                    std::vector<std::size_t> _positions;
+                    std::vector<double> _keys;
             };
 
+            /// blobAt gathers the parameters of the blob with the given index.
+            Blob blobAt(std::size_t index) const {
+                return Blob{_xs[index], _ys[index], _squaredSigmaXs[index], _sigmaXYs[index], _squaredSigmaYs[index]};
+            }
+
+            /// setBlob scatters the parameters of the blob with the given index.
+            void setBlob(std::size_t index, const Blob& blob) {
+                _xs[index] = blob.x;
+                _ys[index] = blob.y;
+                _squaredSigmaXs[index] = blob.squaredSigmaX;
+                _sigmaXYs[index] = blob.sigmaXY;
+                _squaredSigmaYs[index] = blob.squaredSigmaY;
+            }
+
+            /// activityAt calculates the blob's activity at the given timestamp.
+            double activityAt(std::size_t index, uint64_t timestamp) const {
+                return _activities[index] * std::exp(-static_cast<double>(timestamp - _activityTimestamps[index]) / _activityDecay);
+            }
+
+            /// crossing calculates the timestamp at which the blob's activity falls to the threshold.
+            double crossing(std::size_t index, double threshold) const {
+                if (_activities[index] <= threshold) {
+                    return static_cast<double>(_activityTimestamps[index]);
+                }
+                if (threshold <= 0) {
+                    return std::numeric_limits<double>::infinity();
+                }
+                return static_cast<double>(_activityTimestamps[index]) + _activityDecay * std::log(_activities[index] / threshold);
+            }
+
+            /// schedule updates the next threshold crossing of a promoted or demoted blob.
+            void schedule(std::size_t index) {
+                _crossings.set(index, crossing(index, _statuses[index] == Status::promoted ? _promotionActivity : _deletionActivity));
+            }
+
+            /// pushBack appends a blob to the arrays.
+            void pushBack(std::size_t id, const Blob& blob, double activity, uint64_t timestamp, Status status) {
+                _ids.push_back(id);
+                _xs.push_back(blob.x);
+                _ys.push_back(blob.y);
+                _squaredSigmaXs.push_back(blob.squaredSigmaX);
+                _sigmaXYs.push_back(blob.sigmaXY);
+                _squaredSigmaYs.push_back(blob.squaredSigmaY);
+                _activities.push_back(activity);
+                _activityTimestamps.push_back(timestamp);
+                _statuses.push_back(status);
+                _winnerSearch.insert(_ids.size() - 1, blob);
+                if (status != Status::hidden) {
+                    schedule(_ids.size() - 1);
+                }
+            }
+
+            /// swapAndPop replaces the blob with the given index with the last blob.
+            void swapAndPop(std::size_t index) {
+                _winnerSearch.erase(index);
+                _crossings.erase(index);
+                _crossings.relabel(_ids.size() - 1, index);
+                _ids[index] = _ids.back();
+                _xs[index] = _xs.back();
+                _ys[index] = _ys.back();
+                _squaredSigmaXs[index] = _squaredSigmaXs.back();
+                _sigmaXYs[index] = _sigmaXYs.back();
+                _squaredSigmaYs[index] = _squaredSigmaYs.back();
+                _activities[index] = _activities.back();
+                _activityTimestamps[index] = _activityTimestamps.back();
+                _statuses[index] = _statuses.back();
+                _ids.pop_back();
+                _xs.pop_back();
+                _ys.pop_back();
+                _squaredSigmaXs.pop_back();
+                _sigmaXYs.pop_back();
+                _squaredSigmaYs.pop_back();
+                _activities.pop_back();
+                _activityTimestamps.pop_back();
+                _statuses.pop_back();
+            }
+
             std::vector<Blob> _initialBlobs;
             const double _activityDecay;
             const double _minimumProbability;
@@ -312,16 +922,32 @@ namespace tarsier {
             HandleUpdatedHiddenBlob _handleUpdatedHiddenBlob;
             HandleDemotedHiddenBlob _handleDemotedHiddenBlob;
             HandleDeletedBlob _handleDeletedBlob;
-            uint64_t _previousTimestamp;
             std::size_t _skippedEvents;
             std::size_t _inhibitedEvents;
-            std::vector<Data> _datum;
+            std::vector<std::size_t> _ids;
+            std::vector<double> _xs;
+            std::vector<double> _ys;
+            std::vector<double> _squaredSigmaXs;
+            std::vector<double> _sigmaXYs;
+            std::vector<double> _squaredSigmaYs;
+            std::vector<double> _activities;
+            std::vector<uint64_t> _activityTimestamps;
+            std::vector<Status> _statuses;
+            Crossings _crossings;
+            std::vector<double> _xDeltas;
+            std::vector<double> _yDeltas;
+            std::vector<double> _squaredActivities;
             std::size_t _idOffset;
+            WinnerSearch _winnerSearch;
+            Repulsion _repulsion;
     };
 
     /// make_trackBlobs creates a TrackBlob from functors.
     template <
         typename Event,
+        typename WinnerSearch = ExhaustiveWinnerSearch,
+        typename Repulsion = PairwiseRepulsion,
+        std::size_t capacity = 0,
         typename HandlePromotedBlob,
         typename HandleUpdatedBlob,
         typename HandleDemotedBlob,
@@ -338,7 +964,10 @@ namespace tarsier {
         HandlePromotedHiddenBlob,
         HandleUpdatedHiddenBlob,
         HandleDemotedHiddenBlob,
-        HandleDeletedBlob
+        HandleDeletedBlob,
+        WinnerSearch,
+        Repulsion,
+        capacity
     > make_trackBlobs(
         const std::vector<Blob>& initialBlobs,
         double activityDecay,
@@ -368,7 +997,10 @@ namespace tarsier {
             HandlePromotedHiddenBlob,
             HandleUpdatedHiddenBlob,
             HandleDemotedHiddenBlob,
-            HandleDeletedBlob
+            HandleDeletedBlob,
+            WinnerSearch,
+            Repulsion,
+            capacity
         >(
             initialBlobs,
             activityDecay,
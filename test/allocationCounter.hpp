@@ -0,0 +1,8 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/// allocations counts the calls to the global operator new (throwing and nothrow), which test/allocationCounter.cpp replaces for the whole test binary.
+/// Workers of other tests allocate concurrently, hence the atomic counter.
+extern std::atomic<std::size_t> allocations;
@@ -40,3 +40,149 @@ TEST_CASE("Compute the optical flow from the given events", "[ComputeFlow]") {
     computeFlow(Event{100, 100, 2010000});
     REQUIRE(flowEventGenerated);
 }
+
+TEST_CASE("Compute the optical flow from a range of events", "[ComputeFlow]") {
+    std::vector<FlowEvent> flowEvents;
+    std::vector<FlowEvent> batchedFlowEvents;
+    auto flowEventFromEvent = [](Event event, double vx, double vy) -> FlowEvent {
+        return FlowEvent{event.x, event.y, event.timestamp, vx, vy};
+    };
+    auto computeFlow = tarsier::make_computeFlow<Event, FlowEvent, 304, 240, 2, 10, 1000000>(
+        flowEventFromEvent,
+        [&flowEvents](FlowEvent flowEvent) -> void {
+            flowEvents.push_back(flowEvent);
+        }
+    );
+    auto batchedComputeFlow = tarsier::make_computeFlow<Event, FlowEvent, 304, 240, 2, 10, 1000000>(
+        flowEventFromEvent,
+        [&batchedFlowEvents](FlowEvent* begin, FlowEvent* end) -> void {
+            batchedFlowEvents.insert(batchedFlowEvents.end(), begin, end);
+        }
+    );
+    std::vector<Event> events;
+    for (uint16_t x = 100; x < 140; ++x) {
+        for (uint16_t y = 100; y < 120; ++y) {
+            events.push_back(Event{x, y, static_cast<uint64_t>(2000000 + x * 2000 + ((y * 7) % 20) * 50)});
+        }
+    }
+    for (auto event : events) {
+        computeFlow(event);
+    }
+    for (std::size_t index = 0; index < events.size(); index += 256) {
+        batchedComputeFlow(events.data() + index, events.data() + std::min(index + 256, events.size()));
+    }
+    REQUIRE(!flowEvents.empty());
+    REQUIRE(flowEvents.size() == batchedFlowEvents.size());
+    for (std::size_t index = 0; index < flowEvents.size(); ++index) {
+        REQUIRE(flowEvents[index].timestamp == batchedFlowEvents[index].timestamp);
+        REQUIRE(flowEvents[index].vx == batchedFlowEvents[index].vx);
+        REQUIRE(flowEvents[index].vy == batchedFlowEvents[index].vy);
+    }
+}
+
+TEST_CASE("Fit planes on the most recent timestamps", "[FitPlane]") {
+    const uint64_t width = 64;
+    const uint64_t height = 48;
+    const uint64_t window = 3;
+    const std::size_t numberOfMostRecentEvents = 12;
+    const uint64_t lifespan = 100000;
+    tarsier::FitPlane<window, numberOfMostRecentEvents, lifespan> fitPlane;
+    std::vector<uint64_t> timestamps(width * height, 0);
+    uint64_t seed = 1;
+    std::size_t validFits = 0;
+    for (uint64_t timestamp = 200000; timestamp < 400000; timestamp += 20) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        const auto x = (seed >> 33) % width;
+        const auto y = (seed >> 17) % height;
+        timestamps[x + y * width] = ((seed >> 50) % 8 == 0 ? timestamp - 50000 : timestamp - (width - x) * 1000);
+        timestamps[x + y * width] = std::min(timestamps[x + y * width], timestamp);
+        auto vx = 0.0;
+        auto vy = 0.0;
+        const auto isValid = fitPlane(timestamps.data(), width, height, x, y, timestamp, vx, vy);
+
+        // reference implementation: full sort on (time delta, y, x)
+        std::vector<std::array<int64_t, 3>> candidates;
+        for (uint64_t yIndex = (y <= window ? 0 : y - window); yIndex <= std::min(height - 1, y + window); ++yIndex) {
+            for (uint64_t xIndex = (x <= window ? 0 : x - window); xIndex <= std::min(width - 1, x + window); ++xIndex) {
+                if (timestamps[xIndex + yIndex * width] > timestamp - lifespan) {
+                    candidates.push_back({{
+                        static_cast<int64_t>(timestamp - timestamps[xIndex + yIndex * width]),
+                        static_cast<int64_t>(yIndex) - static_cast<int64_t>(y),
+                        static_cast<int64_t>(xIndex) - static_cast<int64_t>(x),
+                    }});
+                }
+            }
+        }
+        auto expectedIsValid = false;
+        auto expectedVx = 0.0;
+        auto expectedVy = 0.0;
+        if (candidates.size() >= numberOfMostRecentEvents) {
+            std::sort(candidates.begin(), candidates.end());
+            auto xMean = 0.0;
+            auto yMean = 0.0;
+            auto timeDeltaMean = 0.0;
+            for (std::size_t index = 0; index < numberOfMostRecentEvents; ++index) {
+                timeDeltaMean += static_cast<double>(candidates[index][0]) / numberOfMostRecentEvents;
+                yMean += static_cast<double>(candidates[index][1]) / numberOfMostRecentEvents;
+                xMean += static_cast<double>(candidates[index][2]) / numberOfMostRecentEvents;
+            }
+            auto xSquaredSum = 0.0;
+            auto ySquaredSum = 0.0;
+            auto xySum = 0.0;
+            auto xTimeDeltaSum = 0.0;
+            auto yTimeDeltaSum = 0.0;
+            for (std::size_t index = 0; index < numberOfMostRecentEvents; ++index) {
+                const auto timeDeltaDelta = candidates[index][0] - timeDeltaMean;
+                const auto yDelta = candidates[index][1] - yMean;
+                const auto xDelta = candidates[index][2] - xMean;
+                xSquaredSum += xDelta * xDelta;
+                ySquaredSum += yDelta * yDelta;
+                xySum += xDelta * yDelta;
+                xTimeDeltaSum += xDelta * timeDeltaDelta;
+                yTimeDeltaSum += yDelta * timeDeltaDelta;
+            }
+            const auto determinant = xSquaredSum * ySquaredSum - xySum * xySum;
+            if (std::abs(determinant) > 1) {
+                const auto xCoefficient = (xTimeDeltaSum * ySquaredSum - yTimeDeltaSum * xySum) / determinant;
+                const auto yCoefficient = (yTimeDeltaSum * xSquaredSum - xTimeDeltaSum * xySum) / determinant;
+                const auto invertedSquaredCoefficientsSum = 1.0 / (xCoefficient * xCoefficient + yCoefficient * yCoefficient);
+                if (invertedSquaredCoefficientsSum > 1e-10 && invertedSquaredCoefficientsSum < 4e-6) {
+                    expectedIsValid = true;
+                    expectedVx = -xCoefficient * invertedSquaredCoefficientsSum;
+                    expectedVy = -yCoefficient * invertedSquaredCoefficientsSum;
+                }
+            }
+        }
+        REQUIRE(isValid == expectedIsValid);
+        if (isValid) {
+            ++validFits;
+            REQUIRE(std::abs(vx - expectedVx) < 1e-9 * (std::abs(expectedVx) + 1e-9));
+            REQUIRE(std::abs(vy - expectedVy) < 1e-9 * (std::abs(expectedVy) + 1e-9));
+        }
+    }
+    REQUIRE(validFits > 0);
+}
+
+TEST_CASE("Fit planes on timestamps much older than the current one", "[FitPlane]") {
+    const uint64_t width = 32;
+    const uint64_t height = 32;
+    const uint64_t window = 10;
+    const std::size_t numberOfMostRecentEvents = 121;
+    const uint64_t lifespan = (static_cast<uint64_t>(1) << 48) - 1;
+    tarsier::FitPlane<window, numberOfMostRecentEvents, lifespan> fitPlane;
+
+    // a plane 2^47 microseconds old, seen from a corner, whose products of moments overflow 64-bit integers
+    const uint64_t base = 1000000;
+    const uint64_t timestamp = base + (static_cast<uint64_t>(1) << 47);
+    std::vector<uint64_t> timestamps(width * height, 0);
+    for (uint64_t y = 0; y <= window; ++y) {
+        for (uint64_t x = 0; x <= window; ++x) {
+            timestamps[x + y * width] = base + 1000 * x + 500 * y;
+        }
+    }
+    auto vx = 0.0;
+    auto vy = 0.0;
+    REQUIRE(fitPlane(timestamps.data(), width, height, 0, 0, timestamp, vx, vy));
+    REQUIRE(vx == Approx(1000.0 / (1000.0 * 1000.0 + 500.0 * 500.0)).epsilon(1e-9));
+    REQUIRE(vy == Approx(500.0 / (1000.0 * 1000.0 + 500.0 * 500.0)).epsilon(1e-9));
+}
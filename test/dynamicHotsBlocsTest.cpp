@@ -0,0 +1,103 @@
+#include "../source/hotsBlocs.hpp"
+#include "../source/dynamicHotsBlocs.hpp"
+
+#include "catch.hpp"
+
+#define DYNAMIC_NCENTERS 6
+#define DYNAMIC_NEIGHBORHOOD 20
+
+struct DynamicClusterEvent{
+  std::array<double, DYNAMIC_NEIGHBORHOOD> context;
+};
+
+/// EuclideanDistance works with the iterators of the templated clusters and the pointers of the dynamic ones
+struct EuclideanDistance{
+  template<typename CenterIterator, typename ContextIterator>
+  double operator()(CenterIterator centerBegin, CenterIterator centerEnd, ContextIterator contextBegin) const {
+    auto distance = 0.;
+    for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+      distance += (*centerBegin - *contextBegin)*(*centerBegin - *contextBegin);
+    }
+    return std::sqrt(distance);
+  }
+};
+
+TEST_CASE("Cluster with dynamic layers identical to the templated ones", "[DynamicHots]") {
+  std::vector<DynamicClusterEvent> events;
+  srand(0);
+  for(auto i = 0; i < 2000; i++){
+    DynamicClusterEvent event;
+    const auto pattern = rand()%3;
+    for(auto j = 0; j < DYNAMIC_NEIGHBORHOOD; j++){
+      event.context[j] = (j%3 == pattern ? 0.8 : 0.1) + 0.1*static_cast<double>(rand())/RAND_MAX;
+    }
+    events.push_back(event);
+  }
+  auto fromEvent = [](DynamicClusterEvent, int64_t p){
+    return p;
+  };
+
+  std::vector<int64_t> iiwkPolarities;
+  std::vector<int64_t> dynamicIiwkPolarities;
+  auto iiwk = tarsier::make_iiwkCluster<DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, true, true, DynamicClusterEvent, int64_t>(
+    2e-2, 2e-2, 1., EuclideanDistance(), fromEvent, [&iiwkPolarities](int64_t p){
+      iiwkPolarities.push_back(p);
+    });
+  auto dynamicIiwk = tarsier::make_dynamicIiwkCluster<true, true, DynamicClusterEvent, int64_t>(
+    DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, 2e-2, 2e-2, 1., EuclideanDistance(), fromEvent, [&dynamicIiwkPolarities](int64_t p){
+      dynamicIiwkPolarities.push_back(p);
+    });
+
+  std::vector<int64_t> stdPolarities;
+  std::vector<int64_t> dynamicStdPolarities;
+  auto standard = tarsier::make_stdCluster<DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, true, true, DynamicClusterEvent, int64_t>(
+    0.5, 500, EuclideanDistance(), fromEvent, [&stdPolarities](int64_t p){
+      stdPolarities.push_back(p);
+    });
+  auto dynamicStandard = tarsier::make_dynamicStdCluster<true, true, DynamicClusterEvent, int64_t>(
+    DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, 0.5, 500, EuclideanDistance(), fromEvent, [&dynamicStdPolarities](int64_t p){
+      dynamicStdPolarities.push_back(p);
+    });
+
+  for(auto&& event: events){
+    iiwk(event);
+    dynamicIiwk(event);
+    standard(event);
+    dynamicStandard(event);
+  }
+  REQUIRE(iiwkPolarities == dynamicIiwkPolarities);
+  REQUIRE(stdPolarities == dynamicStdPolarities);
+  // the compiler may contract the updates to fused multiply-adds differently in the two clusters, hence the approximate centers
+  const auto centers = iiwk.getCenters();
+  const auto stdCenters = standard.getCenters();
+  for(auto i = 0; i < DYNAMIC_NCENTERS; i++){
+    for(auto j = 0; j < DYNAMIC_NEIGHBORHOOD; j++){
+      REQUIRE(centers[i][j] == Approx(dynamicIiwk.getCenters()[i*DYNAMIC_NEIGHBORHOOD + j]).epsilon(1e-9));
+      REQUIRE(stdCenters[i][j] == Approx(dynamicStandard.getCenters()[i*DYNAMIC_NEIGHBORHOOD + j]).epsilon(1e-9));
+    }
+  }
+
+  // metrics accepting a center matrix get the blocked pass over the normalized centers, as in the templated clusters
+  std::vector<int64_t> matrixPolarities;
+  std::vector<int64_t> dynamicMatrixPolarities;
+  auto matrixIiwk = tarsier::make_iiwkCluster<DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, true, true, DynamicClusterEvent, int64_t>(
+    2e-2, 2e-2, 1., tarsier::EuclideanMetric(), fromEvent, [&matrixPolarities](int64_t p){
+      matrixPolarities.push_back(p);
+    });
+  auto dynamicMatrixIiwk = tarsier::make_dynamicIiwkCluster<true, true, DynamicClusterEvent, int64_t>(
+    DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, 2e-2, 2e-2, 1., tarsier::EuclideanMetric(), fromEvent, [&dynamicMatrixPolarities](int64_t p){
+      dynamicMatrixPolarities.push_back(p);
+    });
+  for(auto&& event: events){
+    matrixIiwk(event);
+    dynamicMatrixIiwk(event);
+  }
+  REQUIRE(matrixPolarities == dynamicMatrixPolarities);
+  REQUIRE(matrixPolarities == iiwkPolarities);
+
+  const auto makeWithTooFewCenters = [&fromEvent](){
+    tarsier::make_dynamicStdCluster<true, true, DynamicClusterEvent, int64_t>(
+      DYNAMIC_NCENTERS, DYNAMIC_NEIGHBORHOOD, 0.5, 500, std::vector<double>(3), EuclideanDistance(), fromEvent, [](int64_t){});
+  };
+  REQUIRE_THROWS_AS(makeWithTooFewCenters(), const std::logic_error&);
+}
@@ -0,0 +1,123 @@
+#include "../source/dynamicTimeSurfaceGenerator.hpp"
+
+#include "catch.hpp"
+
+#define DYNAMIC_NP 3
+#define DYNAMIC_RADIUS 3
+#define DYNAMIC_XSIZE 40
+#define DYNAMIC_YSIZE 30
+
+struct DynamicEvent1d{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+};
+
+struct DynamicEvent2d{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+};
+
+TEST_CASE("Compute dynamic timeSurfaces identical to the templated ones", "[DynamicTimeSurface]") {
+  typedef std::array<double, (2*DYNAMIC_RADIUS+1)*DYNAMIC_NP> Context1d;
+  typedef std::array<double, (2*DYNAMIC_RADIUS+1)*(2*DYNAMIC_RADIUS+1)*DYNAMIC_NP> Context2d;
+  std::vector<std::vector<double>> contexts1d;
+  std::vector<std::vector<double>> dynamicContexts1d;
+  std::vector<std::vector<double>> contexts2d;
+  std::vector<std::vector<double>> dynamicContexts2d;
+  std::vector<std::vector<double>> tableContexts2d;
+  std::vector<std::vector<double>> dynamicTableContexts2d;
+  std::vector<std::vector<double>> pixelMajorContexts2d;
+  std::vector<std::vector<double>> dynamicPixelMajorContexts2d;
+  auto kernel1d = [](DynamicEvent1d evRef, DynamicEvent1d evNeighbor){
+    auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+    return (diff < 300.) ? exp(-(diff)/100.) : 0;
+  };
+
+  auto ts1d = tarsier::make_timeSurfaceGenerator<DYNAMIC_XSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000, DynamicEvent1d, int>(
+    kernel1d,
+    [&contexts1d](DynamicEvent1d, Context1d context){
+      contexts1d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto dynamicTs1d = tarsier::make_dynamicTimeSurfaceGenerator<DynamicEvent1d, int>(
+    DYNAMIC_XSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000,
+    kernel1d,
+    [&dynamicContexts1d](DynamicEvent1d, const tarsier::DynamicBuffer<double>& context){
+      dynamicContexts1d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto ts2d = tarsier::make_timeSurfaceGenerator<DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000, DynamicEvent2d, int>(
+    tarsier::ApproximateExponentialDecayKernel(100., 300),
+    [&contexts2d](DynamicEvent2d, Context2d context){
+      contexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto dynamicTs2d = tarsier::make_dynamicTimeSurfaceGenerator<DynamicEvent2d, int>(
+    DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000,
+    tarsier::ApproximateExponentialDecayKernel(100., 300),
+    [&dynamicContexts2d](DynamicEvent2d, const tarsier::DynamicBuffer<double>& context){
+      dynamicContexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto tableTs2d = tarsier::make_timeSurfaceGenerator<DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000, DynamicEvent2d, int>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    [&tableContexts2d](DynamicEvent2d, Context2d context){
+      tableContexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto dynamicTableTs2d = tarsier::make_dynamicTimeSurfaceGenerator<DynamicEvent2d, int>(
+    DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000,
+    tarsier::ExponentialDecayKernel(100., 300),
+    [&dynamicTableContexts2d](DynamicEvent2d, const tarsier::DynamicBuffer<double>& context){
+      dynamicTableContexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto kernel2d = [](DynamicEvent2d evRef, DynamicEvent2d evNeighbor){
+    auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+    return (diff < 300.) ? exp(-(diff)/100.) : 0;
+  };
+  auto pixelMajorTs2d = tarsier::make_timeSurfaceGenerator<DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000, DynamicEvent2d, int, tarsier::ContextOrder::pixelMajor>(
+    kernel2d,
+    [&pixelMajorContexts2d](DynamicEvent2d, Context2d context){
+      pixelMajorContexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  auto dynamicPixelMajorTs2d = tarsier::make_dynamicTimeSurfaceGenerator<DynamicEvent2d, int, tarsier::ContextOrder::pixelMajor>(
+    DYNAMIC_XSIZE, DYNAMIC_YSIZE, DYNAMIC_NP, DYNAMIC_RADIUS, -1000,
+    kernel2d,
+    [&dynamicPixelMajorContexts2d](DynamicEvent2d, const tarsier::DynamicBuffer<double>& context){
+      dynamicPixelMajorContexts2d.emplace_back(context.begin(), context.end());
+      return 0;
+    },
+    [](int){});
+  REQUIRE(dynamicTs2d.contextSize() == Context2d().size());
+
+  srand(0);
+  for(int64_t i = 0; i < 2000; i++){
+    const auto x = rand()%DYNAMIC_XSIZE;
+    const auto y = rand()%DYNAMIC_YSIZE;
+    const auto p = rand()%DYNAMIC_NP;
+    ts1d(DynamicEvent1d{i*5, x, p});
+    dynamicTs1d(DynamicEvent1d{i*5, x, p});
+    ts2d(DynamicEvent2d{i*5, x, y, p});
+    dynamicTs2d(DynamicEvent2d{i*5, x, y, p});
+    tableTs2d(DynamicEvent2d{i*5, x, y, p});
+    dynamicTableTs2d(DynamicEvent2d{i*5, x, y, p});
+    pixelMajorTs2d(DynamicEvent2d{i*5, x, y, p});
+    dynamicPixelMajorTs2d(DynamicEvent2d{i*5, x, y, p});
+  }
+  REQUIRE(contexts1d == dynamicContexts1d);
+  REQUIRE(contexts2d == dynamicContexts2d);
+  REQUIRE(tableContexts2d == dynamicTableContexts2d);
+  REQUIRE(pixelMajorContexts2d == dynamicPixelMajorContexts2d);
+}
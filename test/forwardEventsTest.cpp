@@ -0,0 +1,46 @@
+#include "../source/forwardEvents.hpp"
+#include "../source/mirrorX.hpp"
+#include "../source/shiftX.hpp"
+#include "../source/selectRectangle.hpp"
+
+#include "catch.hpp"
+
+struct ForwardedEvent {
+    uint16_t x;
+    uint16_t y;
+} __attribute__((packed));
+
+TEST_CASE("Forward a range of events through a pipeline", "[ForwardEvents]") {
+    std::size_t batches = 0;
+    std::size_t count = 0;
+    auto pipeline = tarsier::make_mirrorX<ForwardedEvent, 304>(
+        tarsier::make_shiftX<ForwardedEvent, 304, 10>(
+            tarsier::make_selectRectangle<ForwardedEvent, 0, 0, 200, 240>([&batches, &count](ForwardedEvent* begin, ForwardedEvent* end) -> void {
+                ++batches;
+                for (; begin != end; ++begin) {
+                    REQUIRE(begin->x < 200);
+                    ++count;
+                }
+            })
+        )
+    );
+    std::vector<ForwardedEvent> events;
+    for (uint16_t x = 0; x < 304; ++x) {
+        events.push_back(ForwardedEvent{x, 100});
+    }
+    tarsier::forwardEvents(pipeline, events.data(), events.data() + events.size());
+    REQUIRE(batches == 1);
+    REQUIRE(count == 190);
+}
+
+TEST_CASE("Forward a range of events to a single-event functor", "[ForwardEvents]") {
+    std::size_t count = 0;
+    auto handleEvent = [&count](ForwardedEvent event) -> void {
+        REQUIRE(event.y == 100);
+        ++count;
+    };
+    REQUIRE(!(tarsier::AcceptsEvents<decltype(handleEvent), ForwardedEvent>::value));
+    std::vector<ForwardedEvent> events(16, ForwardedEvent{0, 100});
+    tarsier::forwardEvents(handleEvent, events.data(), events.data() + events.size());
+    REQUIRE(count == 16);
+}
@@ -1,6 +1,12 @@
 #include "../source/hotsBlocs.hpp"
+#include "../source/timeSurfaceGenerator.hpp"
 #include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <sstream>
 
+#include "allocationCounter.hpp"
 #include "catch.hpp"
 
 #define TSSIZE (5*2+1)*2
@@ -170,3 +176,548 @@ TEST_CASE("Compute Hots from the given events", "[Hots]") {
   duration = std::chrono::duration_cast< std::chrono::milliseconds >(std::chrono::steady_clock::now() - start);
   std::cout << "IIWK NL\t\t-> Speed: " << static_cast<double>(Nevents)/(static_cast<double>(duration.count())/1000.) << " evs/secs" << std::endl;*/
 }
+
+/// metricMatrixError returns the largest difference between the one-pass and the per-center distances
+template<typename Compute, typename Metric>
+double metricMatrixError(Metric metric){
+  std::vector<Compute> centers(7*TSSIZE);
+  std::vector<Compute> context(TSSIZE);
+  for(auto&& value: centers){
+    value = static_cast<Compute>(rand())/RAND_MAX;
+  }
+  for(auto&& value: context){
+    value = static_cast<Compute>(rand())/RAND_MAX;
+  }
+  std::array<double, 7> distances;
+  metric(centers.data(), 7, TSSIZE, context.data(), distances.data());
+  auto error = 0.;
+  for(std::size_t i = 0; i < 7; i++){
+    error = std::max(error, std::abs(distances[i] - metric(centers.data() + i*TSSIZE, centers.data() + (i + 1)*TSSIZE, context.data())));
+  }
+  return error;
+}
+
+TEST_CASE("Compute the distances to every center in one pass", "[Hots]") {
+  srand(0);
+  REQUIRE((tarsier::AcceptsCenterMatrix<tarsier::EuclideanMetric, double>::type::value));
+  REQUIRE((tarsier::AcceptsCenterMatrix<tarsier::BhattacharyyaMetric, float>::type::value));
+  REQUIRE(metricMatrixError<double>(tarsier::EuclideanMetric()) < 1e-12);
+  REQUIRE(metricMatrixError<double>(tarsier::CosineMetric()) < 1e-12);
+  REQUIRE(metricMatrixError<double>(tarsier::BhattacharyyaMetric()) < 1e-12);
+  REQUIRE(metricMatrixError<float>(tarsier::EuclideanMetric()) < 1e-5);
+  REQUIRE(metricMatrixError<float>(tarsier::CosineMetric()) < 1e-5);
+  REQUIRE(metricMatrixError<float>(tarsier::BhattacharyyaMetric()) < 1e-5);
+
+  // a metric wrapped in a lambda is only called with iterators, once per center
+  auto perCenter = [](std::array<double, TSSIZE>::iterator begin, std::array<double, TSSIZE>::iterator end, std::array<double, TSSIZE>::iterator context){
+    return tarsier::BhattacharyyaMetric()(begin, end, context);
+  };
+  REQUIRE_FALSE((tarsier::AcceptsCenterMatrix<decltype(perCenter), double>::type::value));
+  std::vector<int64_t> polarities;
+  std::vector<int64_t> perCenterPolarities;
+  auto cluster = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-2, 2e-2, 1., tarsier::BhattacharyyaMetric(), [](TsEvent, int64_t p){
+      return p;
+    }, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  auto perCenterCluster = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-2, 2e-2, 1., perCenter, [](TsEvent, int64_t p){
+      return p;
+    }, [&perCenterPolarities](int64_t p){
+      perCenterPolarities.push_back(p);
+    });
+  for(auto i = 0; i < 2000; i++){
+    TsEvent event;
+    const auto pattern = rand()%NCENTERS;
+    for(auto j = 0; j < TSSIZE; j++){
+      event.context[j] = (j%NCENTERS == pattern ? 0.8 : 0.1) + 0.1*static_cast<double>(rand())/RAND_MAX;
+    }
+    cluster(event);
+    perCenterCluster(event);
+  }
+  REQUIRE(polarities == perCenterPolarities);
+  const auto centers = cluster.getCenters();
+  const auto perCenterCenters = perCenterCluster.getCenters();
+  for(std::size_t i = 0; i < NCENTERS; i++){
+    for(std::size_t j = 0; j < TSSIZE; j++){
+      REQUIRE(std::abs(centers[i][j] - perCenterCenters[i][j]) < 1e-9);
+    }
+  }
+}
+
+/// metricBatchIdentical checks that a batch of contexts gets the same distances as each context alone
+template<typename Compute, typename Metric>
+bool metricBatchIdentical(Metric metric){
+  std::vector<Compute> centers(7*TSSIZE);
+  std::vector<Compute> contexts(5*TSSIZE);
+  for(auto&& value: centers){
+    value = static_cast<Compute>(rand())/RAND_MAX;
+  }
+  for(auto&& value: contexts){
+    value = static_cast<Compute>(rand())/RAND_MAX;
+  }
+  std::array<double, 5*7> distances;
+  metric(centers.data(), 7, TSSIZE, contexts.data(), 5, distances.data());
+  for(std::size_t c = 0; c < 5; c++){
+    std::array<double, 7> contextDistances;
+    metric(centers.data(), 7, TSSIZE, contexts.data() + c*TSSIZE, contextDistances.data());
+    if(!std::equal(contextDistances.begin(), contextDistances.end(), distances.begin() + c*7)){
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST_CASE("Classify batches of contexts", "[Hots]") {
+  srand(0);
+  REQUIRE((tarsier::AcceptsContextMatrix<tarsier::CosineMetric, double>::type::value));
+  REQUIRE(metricBatchIdentical<double>(tarsier::EuclideanMetric()));
+  REQUIRE(metricBatchIdentical<double>(tarsier::CosineMetric()));
+  REQUIRE(metricBatchIdentical<double>(tarsier::BhattacharyyaMetric()));
+  REQUIRE(metricBatchIdentical<float>(tarsier::EuclideanMetric()));
+  REQUIRE(metricBatchIdentical<float>(tarsier::CosineMetric()));
+  REQUIRE(metricBatchIdentical<float>(tarsier::BhattacharyyaMetric()));
+
+  std::array<std::array<double, TSSIZE>, NCENTERS> centers;
+  for(std::size_t i = 0; i < NCENTERS; i++){
+    for(std::size_t j = 0; j < TSSIZE; j++){
+      centers[i][j] = (j%NCENTERS == i ? 0.8 : 0.1);
+    }
+  }
+  std::vector<TsEvent> events;
+  for(auto i = 0; i < 37; i++){
+    TsEvent event;
+    const auto pattern = rand()%NCENTERS;
+    for(auto j = 0; j < TSSIZE; j++){
+      event.context[j] = (j%NCENTERS == pattern ? 0.8 : 0.1) + 0.3*static_cast<double>(rand())/RAND_MAX;
+    }
+    events.push_back(event);
+  }
+  auto fromEvent = [](TsEvent, int64_t p){
+    return p;
+  };
+
+  std::vector<int64_t> iiwkPolarities;
+  std::vector<int64_t> iiwkBatchPolarities;
+  auto iiwk = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, false, TsEvent, int64_t>(
+    2e-4, 2e-4, 1., centers, tarsier::BhattacharyyaMetric(), fromEvent, [&iiwkPolarities](int64_t p){
+      iiwkPolarities.push_back(p);
+    });
+  auto iiwkBatch = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, false, TsEvent, int64_t>(
+    2e-4, 2e-4, 1., centers, tarsier::BhattacharyyaMetric(), fromEvent, [&iiwkBatchPolarities](int64_t p){
+      iiwkBatchPolarities.push_back(p);
+    });
+  std::vector<int64_t> stdPolarities;
+  std::vector<int64_t> stdBatchPolarities;
+  auto standard = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, false, TsEvent, int64_t>(
+    0.005, 20000., centers, tarsier::CosineMetric(), fromEvent, [&stdPolarities](int64_t p){
+      stdPolarities.push_back(p);
+    });
+  auto standardBatch = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, false, TsEvent, int64_t>(
+    0.005, 20000., centers, tarsier::CosineMetric(), fromEvent, [&stdBatchPolarities](int64_t p){
+      stdBatchPolarities.push_back(p);
+    });
+  for(auto&& event: events){
+    iiwk(event);
+    standard(event);
+  }
+  iiwkBatch(events.data(), events.data() + events.size());
+  standardBatch(events.data(), events.data() + events.size());
+  REQUIRE(iiwkPolarities.size() == events.size());
+  REQUIRE(iiwkPolarities == iiwkBatchPolarities);
+  REQUIRE(stdPolarities == stdBatchPolarities);
+}
+
+TEST_CASE("Cache the squared norms of the centers", "[Hots]") {
+  srand(0);
+  REQUIRE((tarsier::AcceptsCenterSquares<tarsier::CosineMetric, double>::type::value));
+  REQUIRE_FALSE((tarsier::AcceptsCenterSquares<tarsier::EuclideanMetric, double>::type::value));
+  std::vector<double> centers(7*TSSIZE);
+  std::vector<double> contexts(5*TSSIZE);
+  for(auto&& value: centers){
+    value = static_cast<double>(rand())/RAND_MAX;
+  }
+  for(auto&& value: contexts){
+    value = static_cast<double>(rand())/RAND_MAX;
+  }
+  std::array<double, 7> centerSquares;
+  for(std::size_t i = 0; i < 7; i++){
+    tarsier::CenterMatrix::sums(centers.data() + i*TSSIZE, 1, TSSIZE, centers.data() + i*TSSIZE, 1, &centerSquares[i], tarsier::SquareTerm());
+  }
+  std::array<double, 5*7> distances;
+  std::array<double, 5*7> cachedDistances;
+  tarsier::CosineMetric()(centers.data(), 7, TSSIZE, contexts.data(), 5, distances.data());
+  tarsier::CosineMetric()(centers.data(), centerSquares.data(), 7, TSSIZE, contexts.data(), 5, cachedDistances.data());
+  REQUIRE(distances == cachedDistances);
+
+  // the cached norms follow the centers through learning
+  auto perCenter = [](std::array<double, TSSIZE>::iterator begin, std::array<double, TSSIZE>::iterator end, std::array<double, TSSIZE>::iterator context){
+    return tarsier::CosineMetric()(begin, end, context);
+  };
+  std::vector<int64_t> polarities;
+  std::vector<int64_t> perCenterPolarities;
+  auto cluster = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    0.5, 500, tarsier::CosineMetric(), [](TsEvent, int64_t p){
+      return p;
+    }, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  auto perCenterCluster = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    0.5, 500, perCenter, [](TsEvent, int64_t p){
+      return p;
+    }, [&perCenterPolarities](int64_t p){
+      perCenterPolarities.push_back(p);
+    });
+  for(auto i = 0; i < 2000; i++){
+    TsEvent event;
+    const auto pattern = rand()%NCENTERS;
+    for(auto j = 0; j < TSSIZE; j++){
+      event.context[j] = (j%NCENTERS == pattern ? 0.8 : 0.1) + 0.1*static_cast<double>(rand())/RAND_MAX;
+    }
+    cluster(event);
+    perCenterCluster(event);
+  }
+  REQUIRE(polarities == perCenterPolarities);
+}
+
+/// quantizationError returns the mean squared distance between the normalized contexts and their nearest normalized center
+double quantizationError(const std::array<std::array<double, TSSIZE>, NCENTERS>& centers, const std::vector<TsEvent>& events){
+  auto error = 0.;
+  for(auto&& event: events){
+    const auto sumOfContext = std::accumulate(event.context.begin(), event.context.end(), 0.);
+    auto minimum = std::numeric_limits<double>::infinity();
+    for(auto&& center: centers){
+      const auto sumOfCenter = std::accumulate(center.begin(), center.end(), 0.);
+      auto distance = 0.;
+      for(std::size_t j = 0; j < TSSIZE; j++){
+        distance += std::pow(center[j]/sumOfCenter - event.context[j]/sumOfContext, 2);
+      }
+      minimum = std::min(minimum, distance);
+    }
+    error += minimum;
+  }
+  return error/events.size();
+}
+
+/// maximumCenterDifference returns the largest absolute difference between the values of two sets of centers
+double maximumCenterDifference(const std::array<std::array<double, TSSIZE>, NCENTERS>& first, const std::array<std::array<double, TSSIZE>, NCENTERS>& second){
+  auto difference = 0.;
+  for(std::size_t i = 0; i < NCENTERS; i++){
+    for(std::size_t j = 0; j < TSSIZE; j++){
+      difference = std::max(difference, std::abs(first[i][j] - second[i][j]));
+    }
+  }
+  return difference;
+}
+
+TEST_CASE("Learn by parallel mini-batches", "[Hots]") {
+  srand(1);
+  auto patternEvents = [](std::size_t size){
+    std::vector<TsEvent> events;
+    for(std::size_t i = 0; i < size; i++){
+      TsEvent event;
+      const auto pattern = rand()%NCENTERS;
+      event.p = pattern;
+      for(auto j = 0; j < TSSIZE; j++){
+        event.context[j] = (j%NCENTERS == pattern ? 0.8 : 0.1) + 0.2*static_cast<double>(rand())/RAND_MAX;
+      }
+      events.push_back(event);
+    }
+    return events;
+  };
+  auto events = patternEvents(20000);
+  const auto testEvents = patternEvents(2000);
+  std::array<std::array<double, TSSIZE>, NCENTERS> centers;
+  for(auto&& center: centers){
+    for(auto&& value: center){
+      value = 0.3 + 0.4*static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  auto fromEvent = [](TsEvent, int64_t p){
+    return p;
+  };
+  std::size_t count = 0;
+  auto handler = [&count](int64_t){
+    count++;
+  };
+
+  auto iiwk = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-3, 2e-3, 1., centers, tarsier::EuclideanMetric(), fromEvent, handler);
+  auto iiwkSingle = iiwk;
+  auto iiwkParallel = iiwk;
+  for(auto&& event: events){
+    iiwk(event);
+  }
+  iiwkSingle.learn(events.data(), events.data() + events.size(), 1, 64);
+  count = 0;
+  iiwkParallel.learn(events.data(), events.data() + events.size(), 3, 64);
+  REQUIRE(count == events.size());
+  REQUIRE(maximumCenterDifference(iiwkSingle.getCenters(), iiwkParallel.getCenters()) < 1e-9);
+  const auto iiwkError = quantizationError(iiwk.getCenters(), testEvents);
+  const auto iiwkParallelError = quantizationError(iiwkParallel.getCenters(), testEvents);
+  REQUIRE(iiwkError < quantizationError(centers, testEvents));
+  REQUIRE(iiwkParallelError < 1.1*iiwkError);
+
+  auto standard = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    0.05, 20000., tarsier::CosineMetric(), fromEvent, handler);
+  auto standardSingle = standard;
+  auto standardParallel = standard;
+  for(auto&& event: events){
+    standard(event);
+  }
+  standardSingle.learn(events.data(), events.data() + events.size(), 1, 64);
+  count = 0;
+  standardParallel.learn(events.data(), events.data() + events.size(), 3, 64);
+  REQUIRE(count == events.size());
+  REQUIRE(maximumCenterDifference(standardSingle.getCenters(), standardParallel.getCenters()) < 1e-9);
+  const auto standardError = quantizationError(standard.getCenters(), testEvents);
+  const auto standardParallelError = quantizationError(standardParallel.getCenters(), testEvents);
+  REQUIRE(standardParallelError < 1.1*standardError);
+
+  auto failing = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-3, 2e-3, 1., centers, tarsier::EuclideanMetric(), fromEvent, [&count](int64_t){
+      if(++count == 1000){
+        throw std::runtime_error("send failed");
+      }
+    });
+  count = 0;
+  REQUIRE_THROWS_AS(failing.learn(events.data(), events.data() + events.size(), 3, 64), const std::runtime_error&);
+  REQUIRE(count == 1000);
+  std::atomic<std::size_t> merges(0);
+  REQUIRE_THROWS_AS(tarsier::learnByMiniBatches(events.data(), events.data() + events.size(), 3, 64,
+    [](std::size_t thread, TsEvent*, TsEvent*, int64_t*){
+      if(thread == 2){
+        throw std::logic_error("accumulate failed");
+      }
+    },
+    [&merges](std::size_t){
+      merges++;
+    },
+    [](TsEvent*, TsEvent*, int64_t*){}), const std::logic_error&);
+  REQUIRE(merges.load() == 0);
+}
+
+/// handoffCopies counts the copies of the events handed over between the HOTS blocks
+/// The conversion functions take the events by value, hence the blocks must move them.
+std::size_t handoffCopies = 0;
+
+struct HandoffEvent{
+  HandoffEvent(int64_t t, int64_t x, int64_t p, tarsier::Lineage<3> lp):
+    t(t), x(x), p(p), lp(lp)
+  {}
+  HandoffEvent(const HandoffEvent& other):
+    t(other.t), x(other.x), p(other.p), lp(other.lp)
+  {
+    handoffCopies++;
+  }
+  HandoffEvent(HandoffEvent&&) = default;
+  int64_t t;
+  int64_t x;
+  int64_t p;
+  tarsier::Lineage<3> lp;
+};
+
+struct HandoffTsEvent{
+  HandoffTsEvent(const HandoffEvent& event, const std::array<double, TSSIZE>& context):
+    t(event.t), x(event.x), lp(event.lp), context(context)
+  {}
+  HandoffTsEvent(const HandoffTsEvent& other):
+    t(other.t), x(other.x), lp(other.lp), context(other.context)
+  {
+    handoffCopies++;
+  }
+  HandoffTsEvent(HandoffTsEvent&&) = default;
+  int64_t t;
+  int64_t x;
+  tarsier::Lineage<3> lp;
+  const std::array<double, TSSIZE>& context;
+};
+
+TEST_CASE("Hand events over between HOTS blocks without copies", "[Hots]") {
+  tarsier::Lineage<2> lineage;
+  REQUIRE(lineage.empty());
+  lineage.push_back(3);
+  auto copy = lineage;
+  lineage.push_back(5);
+  REQUIRE(lineage.size() == 2);
+  REQUIRE(lineage[0] == 3);
+  REQUIRE(lineage.back() == 5);
+  REQUIRE(copy.size() == 1);
+  REQUIRE_THROWS_AS(lineage.push_back(7), const std::length_error&);
+
+  std::array<std::array<double, TSSIZE>, NCENTERS> centers;
+  for(std::size_t i = 0; i < NCENTERS; i++){
+    for(std::size_t j = 0; j < TSSIZE; j++){
+      centers[i][j] = (j%NCENTERS == i ? 0.8 : 0.1);
+    }
+  }
+  std::vector<tarsier::Lineage<3>> lineages;
+  auto cluster = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, HandoffTsEvent, HandoffEvent>(
+    2e-4, 2e-4, 1., centers, tarsier::EuclideanMetric(),
+    [](HandoffTsEvent tsEvent, int64_t p){
+      HandoffEvent event(tsEvent.t, tsEvent.x, p, tsEvent.lp);
+      event.lp.push_back(p);
+      return event;
+    },
+    [&lineages](HandoffEvent event){
+      lineages.push_back(event.lp);
+    });
+  auto timeSurfaceGenerator = tarsier::make_timeSurfaceGenerator<40, 2, 5, -1000, HandoffEvent, HandoffTsEvent>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    [](HandoffEvent event, const std::array<double, TSSIZE>& context){
+      return HandoffTsEvent(event, context);
+    },
+    cluster);
+  handoffCopies = 0;
+  for(int64_t i = 0; i < 100; i++){
+    tarsier::Lineage<3> lp;
+    lp.push_back(i%2);
+    timeSurfaceGenerator(HandoffEvent(i*10, (i*7)%40, i%2, lp));
+  }
+  REQUIRE(handoffCopies == 0);
+  REQUIRE(lineages.size() == 100);
+  REQUIRE(lineages[99].size() == 2);
+  REQUIRE(lineages[99][0] == 1);
+}
+
+struct LayerEvent{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+  tarsier::Lineage<3> lp;
+};
+
+template<std::size_t contextSize>
+struct LayerTsEvent{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+  tarsier::Lineage<3> lp;
+  const std::array<double, contextSize>& context;
+};
+
+TEST_CASE("Run two HOTS layers without allocations", "[Hots]") {
+  typedef LayerTsEvent<(2*2+1)*2> LayerTsEvent1;
+  typedef LayerTsEvent<(2*3+1)*NCENTERS> LayerTsEvent2;
+  auto layerEventFromTsEvent = [](const LayerTsEvent2& tsEvent, int64_t p){
+    LayerEvent event{tsEvent.t, tsEvent.x, p, tsEvent.lp};
+    event.lp.push_back(p);
+    return event;
+  };
+  std::size_t count = 0;
+  auto L2 = tarsier::make_iiwkCluster<NCENTERS, (2*3+1)*NCENTERS, true, true, LayerTsEvent2, LayerEvent>(
+    2e-4, 2e-4, 1., tarsier::EuclideanMetric(), layerEventFromTsEvent,
+    [&count](LayerEvent event){
+      count += event.lp.size();
+    });
+  auto linkL1L2 = tarsier::make_timeSurfaceGenerator<40, NCENTERS, 3, -1000, LayerEvent, LayerTsEvent2>(
+    tarsier::ExponentialDecayKernel(200., 600),
+    [](const LayerEvent& event, const std::array<double, (2*3+1)*NCENTERS>& context){
+      return LayerTsEvent2{event.t, event.x, event.p, event.lp, context};
+    },
+    L2);
+  auto L1 = tarsier::make_iiwkCluster<NCENTERS, (2*2+1)*2, true, true, LayerTsEvent1, LayerEvent>(
+    2e-4, 2e-4, 1., tarsier::EuclideanMetric(),
+    [](const LayerTsEvent1& tsEvent, int64_t p){
+      LayerEvent event{tsEvent.t, tsEvent.x, p, tsEvent.lp};
+      event.lp.push_back(p);
+      return event;
+    },
+    linkL1L2);
+  auto hots = tarsier::make_timeSurfaceGenerator<40, 2, 2, -1000, LayerEvent, LayerTsEvent1>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    [](const LayerEvent& event, const std::array<double, (2*2+1)*2>& context){
+      return LayerTsEvent1{event.t, event.x, event.p, event.lp, context};
+    },
+    L1);
+  srand(2);
+  auto send = [&hots](int64_t begin, int64_t end){
+    for(int64_t i = begin; i < end; i++){
+      LayerEvent event{i*10, rand()%40, i%2, tarsier::Lineage<3>()};
+      event.lp.push_back(event.p);
+      hots(std::move(event));
+    }
+  };
+  // the first events fill the centers and the buffers of the blocks
+  send(0, 1000);
+  const auto allocationsBeforeEvents = allocations.load();
+  count = 0;
+  send(1000, 11000);
+  const auto allocationsDuringEvents = allocations.load() - allocationsBeforeEvents;
+  REQUIRE(count == 3*10000);
+  REQUIRE(allocationsDuringEvents == 0);
+}
+
+TEST_CASE("Resume learning from a checkpoint", "[Hots]") {
+  srand(2);
+  std::vector<TsEvent> events;
+  for(auto i = 0; i < 4000; i++){
+    TsEvent event;
+    const auto pattern = rand()%NCENTERS;
+    for(auto j = 0; j < TSSIZE; j++){
+      event.context[j] = (j%NCENTERS == pattern ? 0.8 : 0.1) + 0.2*static_cast<double>(rand())/RAND_MAX;
+    }
+    events.push_back(event);
+  }
+  auto fromEvent = [](TsEvent, int64_t p){
+    return p;
+  };
+  std::array<std::array<double, TSSIZE>, NCENTERS> centers;
+  for(auto&& center: centers){
+    for(auto&& value: center){
+      value = 0.3 + 0.4*static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  std::vector<int64_t> polarities;
+  std::vector<int64_t> resumedPolarities;
+  auto iiwk = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-3, 2e-3, 1., centers, tarsier::EuclideanMetric(), fromEvent, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  auto resumedIiwk = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    2e-3, 2e-3, 1., tarsier::EuclideanMetric(), fromEvent, [&resumedPolarities](int64_t p){
+      resumedPolarities.push_back(p);
+    });
+  auto standard = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    0.05, 2000., tarsier::CosineMetric(), fromEvent, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  auto resumedStandard = tarsier::make_stdCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t>(
+    0.05, 2000., tarsier::CosineMetric(), fromEvent, [&resumedPolarities](int64_t p){
+      resumedPolarities.push_back(p);
+    });
+  for(std::size_t i = 0; i < events.size()/2; i++){
+    iiwk(events[i]);
+    standard(events[i]);
+  }
+  std::stringstream iiwkCheckpoint;
+  iiwk.save(iiwkCheckpoint);
+  resumedIiwk.load(iiwkCheckpoint);
+  std::stringstream standardCheckpoint;
+  standard.save(standardCheckpoint);
+  const auto standardData = standardCheckpoint.str();
+  resumedStandard.load(standardData.data(), standardData.size());
+  polarities.clear();
+  for(std::size_t i = events.size()/2; i < events.size(); i++){
+    iiwk(events[i]);
+    standard(events[i]);
+    resumedIiwk(events[i]);
+    resumedStandard(events[i]);
+  }
+  REQUIRE(polarities.size() == events.size());
+  REQUIRE(resumedPolarities == polarities);
+  REQUIRE(maximumCenterDifference(iiwk.getCenters(), resumedIiwk.getCenters()) == 0);
+  REQUIRE(maximumCenterDifference(standard.getCenters(), resumedStandard.getCenters()) == 0);
+
+  REQUIRE_THROWS_AS(standard.load(iiwkCheckpoint.str().data(), iiwkCheckpoint.str().size()), const std::runtime_error&);
+  REQUIRE_THROWS_AS(iiwk.load(standardData.data(), standardData.size() - 8), const std::runtime_error&);
+  for(auto first: {static_cast<int64_t>(-3), static_cast<int64_t>(NCENTERS + 1)}){
+    auto corrupted = standardData;
+    std::memcpy(&corrupted[offsetof(tarsier::ClusterCheckpoint::Header, first)], &first, sizeof(first));
+    REQUIRE_THROWS_AS(standard.load(corrupted.data(), corrupted.size()), const std::runtime_error&);
+  }
+  auto fixedIiwk = tarsier::make_iiwkCluster<NCENTERS, TSSIZE, true, true, TsEvent, int64_t, tarsier::FixedPrecision16>(
+    2e-3, 2e-3, 1., tarsier::EuclideanMetric(), fromEvent, [](int64_t){});
+  REQUIRE_THROWS_AS(fixedIiwk.load(iiwkCheckpoint.str().data(), iiwkCheckpoint.str().size()), const std::runtime_error&);
+}
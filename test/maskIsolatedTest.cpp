@@ -18,3 +18,22 @@ TEST_CASE("Filter out events with low spatial or in time activity", "[MaskIsolat
     maskIsolated(Event{100, 100, 40});
     maskIsolated(Event{100, 101, 41});
 }
+
+TEST_CASE("Filter out events with low spatial or in time activity from a range of events", "[MaskIsolated]") {
+    std::size_t count = 0;
+    auto maskIsolated = tarsier::make_maskIsolated<Event, 304, 240, 10>([&count](Event* begin, Event* end) -> void {
+        REQUIRE(end - begin == 1);
+        REQUIRE(begin->x == 100);
+        REQUIRE(begin->y == 101);
+        ++count;
+    });
+    Event events[] = {
+        Event{200, 200, 0},
+        Event{200, 202, 1},
+        Event{200, 201, 20},
+        Event{100, 100, 40},
+        Event{100, 101, 41},
+    };
+    maskIsolated(events, events + 5);
+    REQUIRE(count == 1);
+}
@@ -12,3 +12,16 @@ TEST_CASE("Invert the x coordinate", "[MirrorX]") {
     });
     mirrorX(Event{203});
 }
+
+TEST_CASE("Invert the x coordinate of a range of events", "[MirrorX]") {
+    std::size_t count = 0;
+    auto mirrorX = tarsier::make_mirrorX<Event, 304>([&count](Event* begin, Event* end) -> void {
+        REQUIRE(end - begin == 2);
+        REQUIRE(begin[0].x == 100);
+        REQUIRE(begin[1].x == 303);
+        ++count;
+    });
+    Event events[] = {Event{203}, Event{0}};
+    mirrorX(events, events + 2);
+    REQUIRE(count == 1);
+}
@@ -0,0 +1,74 @@
+#include "../source/parallelComputeFlow.hpp"
+
+#include "catch.hpp"
+
+#include <mutex>
+
+struct Event {
+    uint16_t x;
+    uint16_t y;
+    uint64_t timestamp;
+} __attribute__((packed));
+
+struct FlowEvent {
+    uint64_t x;
+    uint64_t y;
+    uint64_t timestamp;
+    double vx;
+    double vy;
+};
+
+TEST_CASE("Compute the optical flow with several tiles", "[ParallelComputeFlow]") {
+    std::vector<FlowEvent> flowEvents;
+    std::vector<FlowEvent> parallelFlowEvents;
+    std::mutex mutex;
+    auto flowEventFromEvent = [](Event event, double vx, double vy) -> FlowEvent {
+        return FlowEvent{event.x, event.y, event.timestamp, vx, vy};
+    };
+    auto computeFlow = tarsier::make_computeFlow<Event, FlowEvent, 304, 240, 2, 10, 1000000>(
+        flowEventFromEvent,
+        [&flowEvents](FlowEvent flowEvent) -> void {
+            flowEvents.push_back(flowEvent);
+        }
+    );
+    std::vector<Event> events;
+    for (uint16_t x = 0; x < 304; ++x) {
+        for (uint16_t y = 0; y < 240; ++y) {
+            events.push_back(Event{x, y, static_cast<uint64_t>(2000000 + x * 2000 + ((y * 7) % 20) * 50)});
+        }
+    }
+    for (auto event : events) {
+        computeFlow(event);
+    }
+    {
+        auto parallelComputeFlow = tarsier::make_parallelComputeFlow<Event, FlowEvent, 304, 240, 2, 10, 1000000, 3, 2>(
+            flowEventFromEvent,
+            [&parallelFlowEvents, &mutex](FlowEvent flowEvent) -> void {
+                std::lock_guard<std::mutex> lock(mutex);
+                parallelFlowEvents.push_back(flowEvent);
+            },
+            256
+        );
+        for (std::size_t index = 0; index < events.size() / 2; ++index) {
+            parallelComputeFlow(events[index]);
+        }
+        for (std::size_t index = events.size() / 2; index < events.size(); index += 1000) {
+            parallelComputeFlow(events.data() + index, events.data() + std::min(index + 1000, events.size()));
+        }
+        parallelComputeFlow.flush();
+    }
+    const auto compare = [](const FlowEvent& first, const FlowEvent& second) -> bool {
+        return std::make_pair(first.timestamp, first.x + first.y * 304) < std::make_pair(second.timestamp, second.x + second.y * 304);
+    };
+    std::sort(flowEvents.begin(), flowEvents.end(), compare);
+    std::sort(parallelFlowEvents.begin(), parallelFlowEvents.end(), compare);
+    REQUIRE(!flowEvents.empty());
+    REQUIRE(flowEvents.size() == parallelFlowEvents.size());
+    for (std::size_t index = 0; index < flowEvents.size(); ++index) {
+        REQUIRE(flowEvents[index].x == parallelFlowEvents[index].x);
+        REQUIRE(flowEvents[index].y == parallelFlowEvents[index].y);
+        REQUIRE(flowEvents[index].timestamp == parallelFlowEvents[index].timestamp);
+        REQUIRE(flowEvents[index].vx == parallelFlowEvents[index].vx);
+        REQUIRE(flowEvents[index].vy == parallelFlowEvents[index].vy);
+    }
+}
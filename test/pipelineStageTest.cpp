@@ -0,0 +1,145 @@
+#include "../source/pipelineStage.hpp"
+#include "../source/timeSurfaceGenerator.hpp"
+#include "../source/sparseTimeSurfaceGenerator.hpp"
+#include "../source/hotsBlocs.hpp"
+
+#include "catch.hpp"
+
+#include <functional>
+
+struct PipelineEvent {
+    int64_t t;
+    int64_t x;
+    int64_t p;
+};
+
+template <std::size_t contextSize>
+struct PipelineTsEvent {
+    int64_t t;
+    int64_t x;
+    int64_t p;
+    std::array<double, contextSize> context;
+};
+
+TEST_CASE("Keep the event order through chained pipeline stages", "[PipelineStage]") {
+    std::vector<int64_t> output;
+    {
+        auto last = tarsier::make_pipelineStage<PipelineEvent>(
+            [&output](PipelineEvent event) -> void {
+                output.push_back(event.t);
+            },
+            16,
+            4
+        );
+        auto middle = tarsier::make_pipelineStage<PipelineEvent>(
+            [last](PipelineEvent event) mutable -> void {
+                if (event.t % 3 != 0) {
+                    last(event);
+                }
+            },
+            8
+        );
+        auto first = tarsier::make_pipelineStage<PipelineEvent>(middle, 32, 7);
+        std::vector<PipelineEvent> events;
+        for (int64_t t = 0; t < 100000; ++t) {
+            events.push_back(PipelineEvent{t, t % 13, 0});
+        }
+        for (std::size_t index = 0; index < events.size() / 2; ++index) {
+            first(events[index]);
+        }
+        for (std::size_t index = events.size() / 2; index < events.size(); index += 1000) {
+            first(events.data() + index, events.data() + std::min(index + 1000, events.size()));
+        }
+        first.flush();
+        middle.flush();
+        last.flush();
+        REQUIRE(output.size() == 66666);
+    }
+    auto ordered = true;
+    int64_t expected = 1;
+    for (auto t : output) {
+        ordered &= (t == expected);
+        expected += (expected % 3 == 1 ? 1 : 2);
+    }
+    REQUIRE(ordered);
+}
+
+#define PIPELINE_XSIZE 40
+#define PIPELINE_NP 2
+#define PIPELINE_NC1 4
+#define PIPELINE_NC2 8
+#define PIPELINE_R1 2
+#define PIPELINE_R2 3
+#define PIPELINE_CS1 (2 * PIPELINE_R1 + 1) * PIPELINE_NP
+#define PIPELINE_CS2 (2 * PIPELINE_R2 + 1) * PIPELINE_NC1
+
+/// PipelineEuclideanDistance is the squared Euclidean distance between a center and a context.
+struct PipelineEuclideanDistance {
+    template <typename Iterator>
+    double operator()(Iterator centerBegin, Iterator centerEnd, Iterator contextBegin) const {
+        auto distance = 0.;
+        for (; centerBegin != centerEnd; ++centerBegin, ++contextBegin) {
+            distance += (*centerBegin - *contextBegin) * (*centerBegin - *contextBegin);
+        }
+        return distance;
+    }
+};
+
+/// pipelinePolarities returns the output polarities of a learning two-layer HOTS network, whose second layer runs on its own thread if pipelined is true.
+std::vector<int64_t> pipelinePolarities(const std::vector<PipelineEvent>& events, bool pipelined) {
+    typedef PipelineTsEvent<PIPELINE_CS1> TsEvent1;
+    typedef PipelineTsEvent<PIPELINE_CS2> TsEvent2;
+    std::vector<int64_t> polarities;
+    const auto eventFromTsEvent1 = [](TsEvent1 tsEvent, int64_t p) -> PipelineEvent {
+        return PipelineEvent{tsEvent.t, tsEvent.x, p};
+    };
+    const auto eventFromTsEvent2 = [](TsEvent2 tsEvent, int64_t p) -> PipelineEvent {
+        return PipelineEvent{tsEvent.t, tsEvent.x, p};
+    };
+    const auto tsEvent1FromEvent = [](PipelineEvent event, std::array<double, PIPELINE_CS1> context) -> TsEvent1 {
+        return TsEvent1{event.t, event.x, event.p, context};
+    };
+    const auto tsEvent2FromEvent = [](PipelineEvent event, std::array<double, PIPELINE_CS2> context) -> TsEvent2 {
+        return TsEvent2{event.t, event.x, event.p, context};
+    };
+    auto layer2 = tarsier::make_sparseTimeSurfaceGenerator<PIPELINE_XSIZE, PIPELINE_NC1, PIPELINE_R2, PipelineEvent, TsEvent2>(
+        tarsier::ExponentialDecayKernel(200., 600),
+        600,
+        tsEvent2FromEvent,
+        tarsier::make_iiwkCluster<PIPELINE_NC2, PIPELINE_CS2, true, true, TsEvent2, PipelineEvent>(
+            2e-4, 2e-4, 1., PipelineEuclideanDistance(), eventFromTsEvent2, [&polarities](PipelineEvent event) -> void {
+                polarities.push_back(event.p);
+            }));
+    const auto layer1 = [&](std::function<void(PipelineEvent)> handleEvent) {
+        return tarsier::make_timeSurfaceGenerator<PIPELINE_XSIZE, PIPELINE_NP, PIPELINE_R1, -1000, PipelineEvent, TsEvent1>(
+            tarsier::ExponentialDecayKernel(100., 300),
+            tsEvent1FromEvent,
+            tarsier::make_iiwkCluster<PIPELINE_NC1, PIPELINE_CS1, true, true, TsEvent1, PipelineEvent>(
+                2e-4, 2e-4, 1., PipelineEuclideanDistance(), eventFromTsEvent1, handleEvent));
+    };
+    if (pipelined) {
+        auto stage = tarsier::make_pipelineStage<PipelineEvent>(layer2, 64, 16);
+        auto network = layer1(stage);
+        for (auto event : events) {
+            network(event);
+        }
+        stage.flush();
+    } else {
+        auto network = layer1(std::ref(layer2));
+        for (auto event : events) {
+            network(event);
+        }
+    }
+    return polarities;
+}
+
+TEST_CASE("Pipeline HOTS layers without changing their output", "[PipelineStage]") {
+    std::vector<PipelineEvent> events;
+    srand(0);
+    for (int64_t t = 0; t < 20000; ++t) {
+        events.push_back(PipelineEvent{t * 10, rand() % PIPELINE_XSIZE, rand() % PIPELINE_NP});
+    }
+    const auto polarities = pipelinePolarities(events, false);
+    REQUIRE(!polarities.empty());
+    REQUIRE(pipelinePolarities(events, true) == polarities);
+}
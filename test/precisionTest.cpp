@@ -0,0 +1,166 @@
+#include "../source/timeSurfaceGenerator.hpp"
+#include "../source/hotsBlocs.hpp"
+
+#include "catch.hpp"
+
+#define PRECISION_NP 2
+#define PRECISION_RADIUS 3
+#define PRECISION_XSIZE 40
+#define PRECISION_YSIZE 30
+#define PRECISION_NCENTERS 8
+#define PRECISION_NEIGHBORHOOD (2*PRECISION_RADIUS+1)*PRECISION_NP
+
+struct PrecisionEvent1d{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+};
+
+struct PrecisionEvent2d{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+};
+
+template<typename Value>
+struct PrecisionClusterEvent{
+  std::array<Value, PRECISION_NEIGHBORHOOD> context;
+};
+
+/// PrecisionEuclideanDistance accepts the compute type of every precision policy
+struct PrecisionEuclideanDistance{
+  template<typename Iterator>
+  double operator()(Iterator centerBegin, Iterator centerEnd, Iterator contextBegin) const {
+    auto distance = 0.;
+    for(; centerBegin != centerEnd; ++centerBegin, ++contextBegin){
+      distance += (*centerBegin - *contextBegin)*(*centerBegin - *contextBegin);
+    }
+    return std::sqrt(distance);
+  }
+};
+
+/// precisionContexts1d returns the decoded 1D contexts computed with the given precision
+template<typename Precision>
+std::vector<std::vector<double>> precisionContexts1d(const std::vector<PrecisionEvent1d>& events){
+  typedef std::array<typename Precision::Value, PRECISION_NEIGHBORHOOD> Context;
+  std::vector<std::vector<double>> contexts;
+  auto timeSurfaceGenerator = tarsier::make_timeSurfaceGenerator<PRECISION_XSIZE, PRECISION_NP, PRECISION_RADIUS, -1000, PrecisionEvent1d, int, tarsier::AutomaticStorage<>, Precision>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    [&contexts](PrecisionEvent1d, Context context){
+      contexts.emplace_back();
+      for(auto&& value: context){
+        contexts.back().push_back(Precision::decode(value));
+      }
+      return 0;
+    },
+    [](int){});
+  for(auto&& event: events){
+    timeSurfaceGenerator(event);
+  }
+  return contexts;
+}
+
+/// precisionContexts2d returns the decoded 2D contexts computed with the given precision
+template<typename Precision>
+std::vector<std::vector<double>> precisionContexts2d(const std::vector<PrecisionEvent2d>& events){
+  typedef std::array<typename Precision::Value, (2*PRECISION_RADIUS+1)*(2*PRECISION_RADIUS+1)*PRECISION_NP> Context;
+  std::vector<std::vector<double>> contexts;
+  auto timeSurfaceGenerator = tarsier::make_timeSurfaceGenerator<PRECISION_XSIZE, PRECISION_YSIZE, PRECISION_NP, PRECISION_RADIUS, -1000, PrecisionEvent2d, int, tarsier::ContextOrder::polarityMajor, tarsier::AutomaticStorage<>, Precision>(
+    tarsier::ApproximateExponentialDecayKernel(100., 300),
+    [&contexts](PrecisionEvent2d, Context context){
+      contexts.emplace_back();
+      for(auto&& value: context){
+        contexts.back().push_back(Precision::decode(value));
+      }
+      return 0;
+    },
+    [](int){});
+  for(auto&& event: events){
+    timeSurfaceGenerator(event);
+  }
+  return contexts;
+}
+
+/// maximumError returns the largest absolute difference between two sets of contexts
+double maximumError(const std::vector<std::vector<double>>& expected, const std::vector<std::vector<double>>& contexts){
+  auto error = 0.;
+  for(std::size_t i = 0; i < expected.size(); i++){
+    for(std::size_t j = 0; j < expected[i].size(); j++){
+      error = std::max(error, std::abs(expected[i][j] - contexts[i][j]));
+    }
+  }
+  return error;
+}
+
+/// precisionPolarities returns the polarities of an inference IiwkCluster with the given precision
+template<typename Precision>
+std::vector<int64_t> precisionPolarities(const std::vector<std::vector<double>>& contexts,
+                                         const std::array<std::array<double, PRECISION_NEIGHBORHOOD>, PRECISION_NCENTERS>& centers){
+  typedef PrecisionClusterEvent<typename Precision::Value> ClusterEvent;
+  std::vector<int64_t> polarities;
+  auto cluster = tarsier::make_iiwkCluster<PRECISION_NCENTERS, PRECISION_NEIGHBORHOOD, true, false, ClusterEvent, int64_t, Precision>(
+    2e-4, 2e-4, 1., centers, PrecisionEuclideanDistance(),
+    [](ClusterEvent, int64_t p){
+      return p;
+    },
+    [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  for(auto&& context: contexts){
+    ClusterEvent event;
+    for(std::size_t i = 0; i < context.size(); i++){
+      event.context[i] = Precision::encode(context[i]);
+    }
+    cluster(event);
+  }
+  return polarities;
+}
+
+/// agreement returns the fraction of identical polarities
+double agreement(const std::vector<int64_t>& expected, const std::vector<int64_t>& polarities){
+  auto identical = 0.;
+  for(std::size_t i = 0; i < expected.size(); i++){
+    if(expected[i] == polarities[i]){
+      identical++;
+    }
+  }
+  return identical/static_cast<double>(expected.size());
+}
+
+TEST_CASE("Compute timeSurfaces with reduced precisions", "[Precision]") {
+  std::vector<PrecisionEvent1d> events1d;
+  std::vector<PrecisionEvent2d> events2d;
+  srand(0);
+  for(int64_t i = 0; i < 2000; i++){
+    events1d.push_back(PrecisionEvent1d{i*5, rand()%PRECISION_XSIZE, rand()%PRECISION_NP});
+    events2d.push_back(PrecisionEvent2d{i*5, rand()%PRECISION_XSIZE, rand()%PRECISION_YSIZE, rand()%PRECISION_NP});
+  }
+
+  const auto contexts1d = precisionContexts1d<tarsier::DoublePrecision>(events1d);
+  REQUIRE(maximumError(contexts1d, precisionContexts1d<tarsier::SinglePrecision>(events1d)) < 1e-7);
+  REQUIRE(maximumError(contexts1d, precisionContexts1d<tarsier::FixedPrecision16>(events1d)) < 0.5/65535. + 1e-7);
+
+  const auto contexts2d = precisionContexts2d<tarsier::DoublePrecision>(events2d);
+  REQUIRE(maximumError(contexts2d, precisionContexts2d<tarsier::SinglePrecision>(events2d)) < 1e-7);
+  REQUIRE(maximumError(contexts2d, precisionContexts2d<tarsier::FixedPrecision16>(events2d)) < 0.5/65535. + 1e-7);
+}
+
+TEST_CASE("Cluster with reduced precisions", "[Precision]") {
+  std::vector<PrecisionEvent1d> events;
+  srand(1);
+  for(int64_t i = 0; i < 5000; i++){
+    events.push_back(PrecisionEvent1d{i*20, rand()%PRECISION_XSIZE, rand()%PRECISION_NP});
+  }
+  const auto contexts = precisionContexts1d<tarsier::DoublePrecision>(events);
+
+  // the centers are sampled among the contexts, so that the clusters are populated
+  std::array<std::array<double, PRECISION_NEIGHBORHOOD>, PRECISION_NCENTERS> centers;
+  for(std::size_t i = 0; i < PRECISION_NCENTERS; i++){
+    std::copy(contexts[(i + 1)*500].begin(), contexts[(i + 1)*500].end(), centers[i].begin());
+  }
+
+  const auto polarities = precisionPolarities<tarsier::DoublePrecision>(contexts, centers);
+  REQUIRE(agreement(polarities, precisionPolarities<tarsier::SinglePrecision>(contexts, centers)) > 0.999);
+  REQUIRE(agreement(polarities, precisionPolarities<tarsier::FixedPrecision16>(contexts, centers)) > 0.99);
+}
@@ -0,0 +1,116 @@
+#include "../source/productQuantizationCluster.hpp"
+#include "../source/hotsBlocs.hpp"
+
+#include "catch.hpp"
+
+#define PQ_NCENTERS 32
+#define PQ_NEIGHBORHOOD 64
+
+struct PqEvent{
+  std::array<double, PQ_NEIGHBORHOOD> context;
+};
+
+/// pqCenters returns sparse random centers, like the time surfaces of a trained layer
+std::array<std::array<double, PQ_NEIGHBORHOOD>, PQ_NCENTERS> pqCenters(){
+  std::array<std::array<double, PQ_NEIGHBORHOOD>, PQ_NCENTERS> centers;
+  for(auto&& center: centers){
+    for(auto&& value: center){
+      value = (rand()%4 == 0) ? static_cast<double>(rand())/RAND_MAX : 0.01;
+    }
+  }
+  return centers;
+}
+
+/// pqEvents returns noisy copies of the centers
+std::vector<PqEvent> pqEvents(const std::array<std::array<double, PQ_NEIGHBORHOOD>, PQ_NCENTERS>& centers, std::size_t size){
+  std::vector<PqEvent> events(size);
+  for(auto&& event: events){
+    const auto& center = centers[rand()%PQ_NCENTERS];
+    for(std::size_t j = 0; j < PQ_NEIGHBORHOOD; j++){
+      event.context[j] = center[j]*(0.7 + 0.6*static_cast<double>(rand())/RAND_MAX) + 0.1*static_cast<double>(rand())/RAND_MAX;
+    }
+  }
+  return events;
+}
+
+/// pqPolarities returns the polarities of an approximate cluster
+template<typename Metric>
+std::vector<int64_t> pqPolarities(const std::array<std::array<double, PQ_NEIGHBORHOOD>, PQ_NCENTERS>& centers,
+                                  const std::vector<PqEvent>& events,
+                                  std::size_t numberOfSubspaces,
+                                  std::size_t numberOfCodes,
+                                  std::size_t numberOfCandidates,
+                                  Metric metric){
+  std::vector<int64_t> polarities;
+  auto cluster = tarsier::make_productQuantizationCluster<PQ_NCENTERS, PQ_NEIGHBORHOOD, true, PqEvent, int64_t>(
+    centers, numberOfSubspaces, numberOfCodes, numberOfCandidates, metric, [](const PqEvent&, int64_t p){
+      return p;
+    }, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  for(auto&& event: events){
+    cluster(event);
+  }
+  return polarities;
+}
+
+/// exactPolarities returns the polarities of an inference cluster
+template<typename Metric>
+std::vector<int64_t> exactPolarities(const std::array<std::array<double, PQ_NEIGHBORHOOD>, PQ_NCENTERS>& centers, const std::vector<PqEvent>& events, Metric metric){
+  std::vector<int64_t> polarities;
+  auto cluster = tarsier::make_iiwkCluster<PQ_NCENTERS, PQ_NEIGHBORHOOD, true, false, PqEvent, int64_t>(
+    2e-4, 2e-4, 1., centers, metric, [](const PqEvent&, int64_t p){
+      return p;
+    }, [&polarities](int64_t p){
+      polarities.push_back(p);
+    });
+  for(auto&& event: events){
+    cluster(event);
+  }
+  return polarities;
+}
+
+/// recall returns the fraction of identical polarities
+double recall(const std::vector<int64_t>& polarities, const std::vector<int64_t>& expected){
+  std::size_t matches = 0;
+  for(std::size_t index = 0; index < expected.size(); index++){
+    matches += (polarities[index] == expected[index]) ? 1 : 0;
+  }
+  return static_cast<double>(matches)/expected.size();
+}
+
+TEST_CASE("Find the nearest center exactly with every center as a candidate", "[ProductQuantizationCluster]") {
+  srand(0);
+  const auto centers = pqCenters();
+  const auto events = pqEvents(centers, 2000);
+  const auto expected = exactPolarities(centers, events, tarsier::EuclideanMetric());
+  REQUIRE(pqPolarities(centers, events, 8, 4, PQ_NCENTERS, tarsier::EuclideanMetric()) == expected);
+  REQUIRE(pqPolarities(centers, events, 1, 1, PQ_NCENTERS, tarsier::EuclideanMetric()) == expected);
+  REQUIRE(pqPolarities(centers, events, 16, 8, PQ_NCENTERS, tarsier::BhattacharyyaMetric()) == exactPolarities(centers, events, tarsier::BhattacharyyaMetric()));
+}
+
+TEST_CASE("Approximate the nearest center with a short list", "[ProductQuantizationCluster]") {
+  srand(0);
+  const auto centers = pqCenters();
+  const auto events = pqEvents(centers, 2000);
+  const auto expected = exactPolarities(centers, events, tarsier::EuclideanMetric());
+  const auto coarse = recall(pqPolarities(centers, events, 4, 4, 1, tarsier::EuclideanMetric()), expected);
+  const auto fine = recall(pqPolarities(centers, events, 16, 16, 1, tarsier::EuclideanMetric()), expected);
+  const auto reranked = recall(pqPolarities(centers, events, 16, 16, 4, tarsier::EuclideanMetric()), expected);
+  REQUIRE(fine >= coarse);
+  REQUIRE(reranked >= fine);
+  REQUIRE(reranked > 0.95);
+  std::vector<int64_t> rangePolarities;
+  auto cluster = tarsier::make_productQuantizationCluster<PQ_NCENTERS, PQ_NEIGHBORHOOD, true, PqEvent, int64_t>(
+    centers, 16, 16, 4, tarsier::EuclideanMetric(), [](const PqEvent&, int64_t p){
+      return p;
+    }, [&rangePolarities](int64_t p){
+      rangePolarities.push_back(p);
+    });
+  auto rangeEvents = events;
+  cluster(rangeEvents.data(), rangeEvents.data() + rangeEvents.size());
+  REQUIRE(rangePolarities == pqPolarities(centers, events, 16, 16, 4, tarsier::EuclideanMetric()));
+  REQUIRE_THROWS_AS(pqPolarities(centers, events, 0, 16, 4, tarsier::EuclideanMetric()), const std::logic_error&);
+  REQUIRE_THROWS_AS(pqPolarities(centers, events, 16, 257, 4, tarsier::EuclideanMetric()), const std::logic_error&);
+  REQUIRE_THROWS_AS(pqPolarities(centers, events, 16, 16, PQ_NCENTERS + 1, tarsier::EuclideanMetric()), const std::logic_error&);
+}
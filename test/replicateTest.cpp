@@ -20,3 +20,21 @@ TEST_CASE("Replicate an event and trigger several callbacks", "[Replicate]") {
     replicate(Event{});
     REQUIRE(count == 3);
 }
+
+TEST_CASE("Replicate a range of events and trigger several callbacks", "[Replicate]") {
+    std::size_t count = 0;
+    auto replicate = tarsier::make_replicate<Event>(
+        [&count](Event* begin, Event* end) {
+            count += end - begin;
+        },
+        [&count](Event) {
+            ++count;
+        },
+        [&count](Event* begin, Event* end) {
+            count += end - begin;
+        }
+    );
+    Event events[4];
+    replicate(events, events + 4);
+    REQUIRE(count == 12);
+}
@@ -0,0 +1,50 @@
+#include "../source/ringBuffer.hpp"
+
+#include "catch.hpp"
+
+#include <thread>
+
+TEST_CASE("Transfer ranges through a ring buffer", "[RingBuffer]") {
+    tarsier::RingBuffer<uint64_t> ringBuffer(4);
+    REQUIRE(ringBuffer.capacity() == 4);
+    const uint64_t values[] = {1, 2, 3, 4, 5, 6};
+    REQUIRE(ringBuffer.push(values, values + 6) == 4);
+    REQUIRE(!ringBuffer.push(values[4]));
+    uint64_t output[6];
+    REQUIRE(ringBuffer.pop(output, 3) == 3);
+    REQUIRE(output[0] == 1);
+    REQUIRE(output[2] == 3);
+    REQUIRE(ringBuffer.push(values + 4, values + 6) == 2);
+    REQUIRE(ringBuffer.pop(output, 6) == 3);
+    REQUIRE(output[0] == 4);
+    REQUIRE(output[1] == 5);
+    REQUIRE(output[2] == 6);
+    uint64_t value;
+    REQUIRE(!ringBuffer.pop(value));
+}
+
+TEST_CASE("Transfer events between threads through a ring buffer", "[RingBuffer]") {
+    tarsier::RingBuffer<uint64_t> ringBuffer(64);
+    std::thread producer([&ringBuffer]() {
+        for (uint64_t value = 0; value < 100000; ++value) {
+            while (!ringBuffer.push(value)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    auto ordered = true;
+    uint64_t output[16];
+    while (expected < 100000) {
+        const auto count = ringBuffer.pop(output, 16);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (std::size_t index = 0; index < count; ++index) {
+            ordered &= (output[index] == expected);
+            ++expected;
+        }
+    }
+    producer.join();
+    REQUIRE(ordered);
+}
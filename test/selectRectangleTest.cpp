@@ -14,3 +14,16 @@ TEST_CASE("Filter out events outside the rectangle", "[SelectRectangle]") {
     selectRectangle(Event{300, 200});
     selectRectangle(Event{100, 100});
 }
+
+TEST_CASE("Filter out events outside the rectangle from a range of events", "[SelectRectangle]") {
+    std::size_t count = 0;
+    auto selectRectangle = tarsier::make_selectRectangle<Event, 50, 50, 204, 140>([&count](Event* begin, Event* end) -> void {
+        REQUIRE(end - begin == 2);
+        REQUIRE(begin[0].x == 100);
+        REQUIRE(begin[1].x == 253);
+        ++count;
+    });
+    Event events[] = {Event{300, 200}, Event{100, 100}, Event{49, 100}, Event{253, 189}, Event{253, 190}};
+    selectRectangle(events, events + 5);
+    REQUIRE(count == 1);
+}
@@ -13,3 +13,14 @@ TEST_CASE("Shift the x coordinate", "[ShiftX]") {
     shiftX(Event{300});
     shiftX(Event{200});
 }
+
+TEST_CASE("Shift the x coordinate of a range of events", "[ShiftX]") {
+    std::size_t count = 0;
+    auto shiftX = tarsier::make_shiftX<Event, 304, 10>([&count](Event event) -> void {
+        REQUIRE(event.x == 210);
+        ++count;
+    });
+    Event events[] = {Event{300}, Event{200}, Event{294}, Event{200}};
+    shiftX(events, events + 4);
+    REQUIRE(count == 2);
+}
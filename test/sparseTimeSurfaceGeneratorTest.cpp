@@ -0,0 +1,112 @@
+#include "../source/sparseTimeSurfaceGenerator.hpp"
+
+#include "catch.hpp"
+
+#define SPARSE_NP 32
+#define SPARSE_RADIUS_1D 4
+#define SPARSE_RADIUS_2D 2
+#define SPARSE_XSIZE 64
+#define SPARSE_YSIZE 48
+#define SPARSE_CONTEXT_SIZE_1D (2*SPARSE_RADIUS_1D + 1)*SPARSE_NP
+#define SPARSE_CONTEXT_SIZE_2D (2*SPARSE_RADIUS_2D + 1)*(2*SPARSE_RADIUS_2D + 1)*SPARSE_NP
+
+struct SparseEvent1d{
+  int64_t t;
+  int64_t x;
+  int64_t p;
+};
+
+struct SparseEvent2d{
+  int64_t t;
+  int64_t x;
+  int64_t y;
+  int64_t p;
+};
+
+TEST_CASE("Compute sparse 1D timeSurfaces identical to the dense ones", "[SparseTimeSurface]") {
+  typedef std::array<double, SPARSE_CONTEXT_SIZE_1D> Context;
+  auto contextFromEvent = [](SparseEvent1d, Context context){
+    return context;
+  };
+  auto kernel = [](SparseEvent1d evRef, SparseEvent1d evNeighbor){
+    auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+    return (diff < 300.) ? exp(-(diff)/100.) : 0;
+  };
+  std::vector<Context> denseContexts;
+  std::vector<Context> sparseContexts;
+  auto denseTs = tarsier::make_timeSurfaceGenerator<SPARSE_XSIZE, SPARSE_NP, SPARSE_RADIUS_1D, -1000, SparseEvent1d, Context>(
+    kernel,
+    contextFromEvent,
+    [&denseContexts](Context context){
+      denseContexts.push_back(context);
+    });
+  auto sparseTs = tarsier::make_sparseTimeSurfaceGenerator<SPARSE_XSIZE, SPARSE_NP, SPARSE_RADIUS_1D, SparseEvent1d, Context>(
+    kernel,
+    300,
+    contextFromEvent,
+    [&sparseContexts](Context context){
+      sparseContexts.push_back(context);
+    });
+
+  srand(0);
+  for(int64_t i = 0; i < 5000; i++){
+    const auto ev = SparseEvent1d{i*2 + (i/1000)*1000, rand()%SPARSE_XSIZE, rand()%SPARSE_NP};
+    denseTs(ev);
+    sparseTs(ev);
+  }
+  REQUIRE(denseContexts == sparseContexts);
+}
+
+TEST_CASE("Compute sparse 2D timeSurfaces identical to the dense ones", "[SparseTimeSurface]") {
+  typedef std::array<double, SPARSE_CONTEXT_SIZE_2D> Context;
+  auto contextFromEvent = [](SparseEvent2d, Context context){
+    return context;
+  };
+  std::vector<Context> denseContexts;
+  std::vector<Context> sparseContexts;
+  std::vector<Context> pixelMajorDenseContexts;
+  std::vector<Context> pixelMajorSparseContexts;
+  auto denseTs = tarsier::make_timeSurfaceGenerator<SPARSE_XSIZE, SPARSE_YSIZE, SPARSE_NP, SPARSE_RADIUS_2D, -1000, SparseEvent2d, Context>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    contextFromEvent,
+    [&denseContexts](Context context){
+      denseContexts.push_back(context);
+    });
+  auto sparseTs = tarsier::make_sparseTimeSurfaceGenerator<SPARSE_XSIZE, SPARSE_YSIZE, SPARSE_NP, SPARSE_RADIUS_2D, SparseEvent2d, Context>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    300,
+    contextFromEvent,
+    [&sparseContexts](Context context){
+      sparseContexts.push_back(context);
+    });
+  auto pixelMajorDenseTs = tarsier::make_timeSurfaceGenerator<SPARSE_XSIZE, SPARSE_YSIZE, SPARSE_NP, SPARSE_RADIUS_2D, -1000, SparseEvent2d, Context, tarsier::ContextOrder::pixelMajor>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    contextFromEvent,
+    [&pixelMajorDenseContexts](Context context){
+      pixelMajorDenseContexts.push_back(context);
+    });
+  auto pixelMajorSparseTs = tarsier::make_sparseTimeSurfaceGenerator<SPARSE_XSIZE, SPARSE_YSIZE, SPARSE_NP, SPARSE_RADIUS_2D, SparseEvent2d, Context, tarsier::ContextOrder::pixelMajor>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    300,
+    contextFromEvent,
+    [&pixelMajorSparseContexts](Context context){
+      pixelMajorSparseContexts.push_back(context);
+    });
+
+  // the events are clustered on a small patch, which moves every 1000 events
+  srand(0);
+  std::size_t maximumSize = 0;
+  for(int64_t i = 0; i < 5000; i++){
+    const auto ev = SparseEvent2d{i, (i/1000)*10 + rand()%8, (i/1000)*8 + rand()%8, rand()%SPARSE_NP};
+    denseTs(ev);
+    sparseTs(ev);
+    pixelMajorDenseTs(ev);
+    pixelMajorSparseTs(ev);
+    maximumSize = std::max(maximumSize, sparseTs.size());
+  }
+  REQUIRE(denseContexts == sparseContexts);
+  REQUIRE(pixelMajorDenseContexts == pixelMajorSparseContexts);
+
+  // one event per microsecond and a 300 microseconds horizon
+  REQUIRE(maximumSize <= 300);
+}
@@ -2,6 +2,8 @@
 
 #include "catch.hpp"
 #include <chrono>
+#include <functional>
+#include <memory>
 
 #define RADIUS_1D 5
 #define RADIUS_2D 2
@@ -145,3 +147,223 @@ TEST_CASE("Compute 1D timeSurfaces from the given events", "[TimeSurface]") {
 
   std::cout << "2D -> Speed: " << static_cast<double>(Nevents)/(static_cast<double>(duration.count())/1000.) << " evs/secs" << std::endl;*/
 }
+
+TEST_CASE("Compute timeSurfaces with lookup table kernels", "[TimeSurface]") {
+  auto tsEvent1dFromEvent = [](Event1d ev, std::array<double, CONTEXT_SIZE_1D> context){
+    return TsEvent1d{ev.t, ev.x, ev.p, context};
+  };
+  auto tsEvent2dFromEvent = [](Event2d ev, std::array<double, CONTEXT_SIZE_2D> context){
+    return TsEvent2d{ev.t, ev.x, ev.y, ev.p, context};
+  };
+  std::vector<std::array<double, CONTEXT_SIZE_1D>> contexts1d;
+  std::vector<std::array<double, CONTEXT_SIZE_1D>> tableContexts1d;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> contexts2d;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> tableContexts2d;
+
+  auto myTs1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS_1D, INIT_MEMORY, Event1d, TsEvent1d>(
+    [](Event1d evRef, Event1d evNeighbor){
+      auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+      return (diff < 3*100.) ? exp(-(diff)/100.) : 0;
+    },
+    tsEvent1dFromEvent,
+    [&contexts1d](TsEvent1d ev){
+      contexts1d.push_back(ev.context);
+    });
+  auto myTableTs1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS_1D, INIT_MEMORY, Event1d, TsEvent1d>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent1dFromEvent,
+    [&tableContexts1d](TsEvent1d ev){
+      tableContexts1d.push_back(ev.context);
+    });
+  auto myTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d>(
+    [](Event2d evRef, Event2d evNeighbor){
+      auto diff = static_cast<double>(evRef.t)-static_cast<double>(evNeighbor.t);
+      return (diff < 200) ? 1. - diff/200. : 0;
+    },
+    tsEvent2dFromEvent,
+    [&contexts2d](TsEvent2d ev){
+      contexts2d.push_back(ev.context);
+    });
+  auto myTableTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d>(
+    tarsier::LinearDecayKernel(200),
+    tsEvent2dFromEvent,
+    [&tableContexts2d](TsEvent2d ev){
+      tableContexts2d.push_back(ev.context);
+    });
+
+  for(int64_t i = 0; i < 1000; i++){
+    const auto x = (i*7)%XSIZE;
+    const auto y = (i*13)%YSIZE;
+    myTs1d(Event1d{i*3, x, i%NP});
+    myTableTs1d(Event1d{i*3, x, i%NP});
+    myTs2d(Event2d{i*3, x%20, y%20, i%NP});
+    myTableTs2d(Event2d{i*3, x%20, y%20, i%NP});
+  }
+  REQUIRE(contexts1d == tableContexts1d);
+  REQUIRE(contexts2d == tableContexts2d);
+  REQUIRE(tarsier::ExponentialDecayKernel(100., 300, 10)(1000, 1000-25) == exp(-20./100.));
+  REQUIRE(tarsier::ExponentialDecayKernel(100., 300, 10)(1000, 1000-300) == 0);
+}
+
+TEST_CASE("Compute 2D timeSurfaces in pixel-major order", "[TimeSurface]") {
+  auto tsEvent2dFromEvent = [](Event2d ev, std::array<double, CONTEXT_SIZE_2D> context){
+    return TsEvent2d{ev.t, ev.x, ev.y, ev.p, context};
+  };
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> polarityMajorContexts;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> pixelMajorContexts;
+  auto polarityMajorTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&polarityMajorContexts](TsEvent2d ev){
+      polarityMajorContexts.push_back(ev.context);
+    });
+  auto pixelMajorTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ContextOrder::pixelMajor>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&pixelMajorContexts](TsEvent2d ev){
+      pixelMajorContexts.push_back(ev.context);
+    });
+
+  // the events cover the sensor borders, where the window is clamped
+  for(int64_t i = 0; i < 1000; i++){
+    const auto ev = Event2d{i*3, (i*7)%XSIZE, (i*13)%YSIZE, i%NP};
+    polarityMajorTs2d(ev);
+    pixelMajorTs2d(ev);
+  }
+  REQUIRE(polarityMajorContexts.size() == pixelMajorContexts.size());
+  const auto side = 2*RADIUS_2D + 1;
+  for(std::size_t i = 0; i < polarityMajorContexts.size(); i++){
+    for(int64_t p = 0; p < NP; p++){
+      for(int64_t x = 0; x < side; x++){
+        for(int64_t y = 0; y < side; y++){
+          REQUIRE(polarityMajorContexts[i][(p*side + x)*side + y] == pixelMajorContexts[i][(y*side + x)*NP + p]);
+        }
+      }
+    }
+  }
+}
+
+TEST_CASE("Compute 2D timeSurfaces with each storage", "[TimeSurface]") {
+  auto tsEvent2dFromEvent = [](Event2d ev, std::array<double, CONTEXT_SIZE_2D> context){
+    return TsEvent2d{ev.t, ev.x, ev.y, ev.p, context};
+  };
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> inlineContexts;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> heapContexts;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> bufferContexts;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> hugePageContexts;
+  std::vector<int64_t> buffer(XSIZE*YSIZE*NP);
+
+  // a sensor of this size overflows the stack with inline storage
+  auto hugePageTs2d = tarsier::make_timeSurfaceGenerator<1280, 720, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ContextOrder::polarityMajor, tarsier::HugePageStorage>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&hugePageContexts](TsEvent2d ev){
+      hugePageContexts.push_back(ev.context);
+    });
+  auto inlineTs2d = std::unique_ptr<tarsier::TimeSurfaceGenerator2D<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ExponentialDecayKernel, decltype(tsEvent2dFromEvent), std::function<void(TsEvent2d)>, tarsier::ContextOrder::polarityMajor, tarsier::InlineStorage>>(
+    new tarsier::TimeSurfaceGenerator2D<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ExponentialDecayKernel, decltype(tsEvent2dFromEvent), std::function<void(TsEvent2d)>, tarsier::ContextOrder::polarityMajor, tarsier::InlineStorage>(
+      tarsier::ExponentialDecayKernel(100., 300),
+      tsEvent2dFromEvent,
+      [&inlineContexts](TsEvent2d ev){
+        inlineContexts.push_back(ev.context);
+      }));
+  auto heapTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ContextOrder::polarityMajor, tarsier::HeapStorage<>>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&heapContexts](TsEvent2d ev){
+      heapContexts.push_back(ev.context);
+    });
+  auto bufferTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d, tarsier::ContextOrder::polarityMajor, tarsier::BufferStorage>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&bufferContexts](TsEvent2d ev){
+      bufferContexts.push_back(ev.context);
+    },
+    {buffer.data(), buffer.size()});
+  REQUIRE(buffer[0] == INIT_MEMORY);
+
+  for(int64_t i = 0; i < 1000; i++){
+    const auto ev = Event2d{i*3, (i*7)%XSIZE, (i*13)%YSIZE, i%NP};
+    (*inlineTs2d)(ev);
+    heapTs2d(ev);
+    bufferTs2d(ev);
+    hugePageTs2d(ev);
+  }
+  REQUIRE(inlineContexts == heapContexts);
+  REQUIRE(inlineContexts == bufferContexts);
+  REQUIRE(inlineContexts == hugePageContexts);
+  REQUIRE(buffer[(999*13%YSIZE*XSIZE + 999*7%XSIZE)*NP + 1] == 999*3);
+
+  REQUIRE_THROWS_AS(tarsier::BufferStorage::memory<16>(buffer.data(), 15), const std::logic_error&);
+}
+
+TEST_CASE("Approximate the exponential decay on rows of timestamps", "[TimeSurface]") {
+  const tarsier::ApproximateExponentialDecayKernel kernel(100., 300);
+  std::vector<int64_t> neighborTimestamps;
+  for(int64_t i = -20; i < 400; i++){
+    neighborTimestamps.push_back(1000 - i);
+  }
+  neighborTimestamps.push_back(-1000000000000);
+  std::vector<double> decays(neighborTimestamps.size());
+  kernel(1000, neighborTimestamps.data(), decays.data(), decays.size());
+  for(std::size_t i = 0; i < neighborTimestamps.size(); i++){
+    const auto difference = 1000 - neighborTimestamps[i];
+    REQUIRE(decays[i] == kernel(1000, neighborTimestamps[i]));
+    if(difference < 0 || difference >= 300){
+      REQUIRE(decays[i] == 0);
+    }else{
+      REQUIRE(std::abs(decays[i] - exp(-difference/100.)) < 1e-12*exp(-difference/100.));
+    }
+  }
+
+  auto tsEvent1dFromEvent = [](Event1d ev, std::array<double, CONTEXT_SIZE_1D> context){
+    return TsEvent1d{ev.t, ev.x, ev.p, context};
+  };
+  auto tsEvent2dFromEvent = [](Event2d ev, std::array<double, CONTEXT_SIZE_2D> context){
+    return TsEvent2d{ev.t, ev.x, ev.y, ev.p, context};
+  };
+  std::vector<std::array<double, CONTEXT_SIZE_1D>> contexts1d;
+  std::vector<std::array<double, CONTEXT_SIZE_1D>> approximateContexts1d;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> contexts2d;
+  std::vector<std::array<double, CONTEXT_SIZE_2D>> approximateContexts2d;
+  auto myTs1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS_1D, INIT_MEMORY, Event1d, TsEvent1d>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent1dFromEvent,
+    [&contexts1d](TsEvent1d ev){
+      contexts1d.push_back(ev.context);
+    });
+  auto myApproximateTs1d = tarsier::make_timeSurfaceGenerator<XSIZE, NP, RADIUS_1D, INIT_MEMORY, Event1d, TsEvent1d>(
+    tarsier::ApproximateExponentialDecayKernel(100., 300),
+    tsEvent1dFromEvent,
+    [&approximateContexts1d](TsEvent1d ev){
+      approximateContexts1d.push_back(ev.context);
+    });
+  auto myTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d>(
+    tarsier::ExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&contexts2d](TsEvent2d ev){
+      contexts2d.push_back(ev.context);
+    });
+  auto myApproximateTs2d = tarsier::make_timeSurfaceGenerator<XSIZE, YSIZE, NP, RADIUS_2D, INIT_MEMORY, Event2d, TsEvent2d>(
+    tarsier::ApproximateExponentialDecayKernel(100., 300),
+    tsEvent2dFromEvent,
+    [&approximateContexts2d](TsEvent2d ev){
+      approximateContexts2d.push_back(ev.context);
+    });
+  for(int64_t i = 0; i < 1000; i++){
+    myTs1d(Event1d{i*3, (i*7)%XSIZE, i%NP});
+    myApproximateTs1d(Event1d{i*3, (i*7)%XSIZE, i%NP});
+    myTs2d(Event2d{i*3, (i*7)%20, (i*13)%20, i%NP});
+    myApproximateTs2d(Event2d{i*3, (i*7)%20, (i*13)%20, i%NP});
+  }
+  for(std::size_t i = 0; i < contexts1d.size(); i++){
+    for(std::size_t j = 0; j < contexts1d[i].size(); j++){
+      REQUIRE(std::abs(contexts1d[i][j] - approximateContexts1d[i][j]) < 1e-12);
+    }
+  }
+  for(std::size_t i = 0; i < contexts2d.size(); i++){
+    for(std::size_t j = 0; j < contexts2d[i].size(); j++){
+      REQUIRE(std::abs(contexts2d[i][j] - approximateContexts2d[i][j]) < 1e-12);
+    }
+  }
+}
@@ -1,5 +1,9 @@
 #include "../source/trackBlobs.hpp"
 
+#include <functional>
+#include <map>
+
+#include "allocationCounter.hpp"
 #include "catch.hpp"
 
 struct Event {
@@ -105,3 +109,416 @@ TEST_CASE("Track gaussian blobs of incoming events", "[TrackBlobs]") {
     REQUIRE(hiddenUpdatedStep);
     REQUIRE(deletedStep);
 }
+
+TEST_CASE("Track gaussian blobs with a grid winner search", "[TrackBlobs]") {
+    std::vector<std::tuple<std::size_t, std::size_t, double, double>> exhaustiveUpdates;
+    std::vector<std::tuple<std::size_t, std::size_t, double, double>> gridUpdates;
+    const auto makeHandle = [](std::vector<std::tuple<std::size_t, std::size_t, double, double>>& updates, std::size_t type) {
+        return [&updates, type](std::size_t id, const tarsier::Blob& blob) {
+            updates.emplace_back(type, id, blob.x, blob.y);
+        };
+    };
+    const auto initialBlobs = std::vector<tarsier::Blob>{
+        tarsier::Blob{25, 25, 70, 0, 70},
+        tarsier::Blob{75, 25, 70, 0, 70},
+        tarsier::Blob{25, 75, 70, 0, 70},
+        tarsier::Blob{75, 75, 70, 0, 70},
+    };
+    auto exhaustiveTrackBlobs = tarsier::make_trackBlobs<Event>(
+        initialBlobs, 1e3, 1e-4, 0.38, 0.2, 0.9, 0.9, 0.2, 10, 0.2, 30, 100,
+        makeHandle(exhaustiveUpdates, 0),
+        makeHandle(exhaustiveUpdates, 1),
+        makeHandle(exhaustiveUpdates, 2),
+        makeHandle(exhaustiveUpdates, 3),
+        makeHandle(exhaustiveUpdates, 4),
+        makeHandle(exhaustiveUpdates, 5),
+        makeHandle(exhaustiveUpdates, 6)
+    );
+    auto gridTrackBlobs = tarsier::make_trackBlobs<Event, tarsier::GridWinnerSearch<100, 100, 8>>(
+        initialBlobs, 1e3, 1e-4, 0.38, 0.2, 0.9, 0.9, 0.2, 10, 0.2, 30, 100,
+        makeHandle(gridUpdates, 0),
+        makeHandle(gridUpdates, 1),
+        makeHandle(gridUpdates, 2),
+        makeHandle(gridUpdates, 3),
+        makeHandle(gridUpdates, 4),
+        makeHandle(gridUpdates, 5),
+        makeHandle(gridUpdates, 6)
+    );
+    for (uint64_t timestamp = 0; timestamp < 40000; timestamp += 10) {
+        const auto corner = (timestamp / 10000) % 4;
+        const auto offset = static_cast<uint16_t>((timestamp / 10) % 7);
+        const auto event = Event{
+            static_cast<uint16_t>((corner % 2 == 0 ? 22 : 72) + offset),
+            static_cast<uint16_t>((corner / 2 == 0 ? 22 : 72) + (offset * 3) % 7),
+            timestamp,
+        };
+        exhaustiveTrackBlobs(event);
+        gridTrackBlobs(event);
+    }
+    REQUIRE(!exhaustiveUpdates.empty());
+    REQUIRE(exhaustiveUpdates == gridUpdates);
+}
+
+/// repulsionDeltas returns the x and y deltas computed by a repulsion.
+template <typename Repulsion>
+std::pair<std::vector<double>, std::vector<double>> repulsionDeltas(
+    Repulsion repulsion,
+    const std::vector<double>& xs,
+    const std::vector<double>& ys,
+    const std::vector<double>& squaredActivities) {
+    std::pair<std::vector<double>, std::vector<double>> deltas(std::vector<double>(xs.size(), 0), std::vector<double>(xs.size(), 0));
+    repulsion(xs.size(), xs.data(), ys.data(), squaredActivities.data(), 0.2, 10, deltas.first.data(), deltas.second.data());
+    return deltas;
+}
+
+TEST_CASE("Repel blobs with a cell list", "[TrackBlobs]") {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<double> squaredActivities;
+    uint64_t state = 1;
+    const auto random = [&state]() -> double {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<double>(state >> 11) / static_cast<double>(1ull << 53);
+    };
+    for (std::size_t index = 0; index < 500; ++index) {
+        xs.push_back(random() * 640);
+        ys.push_back(random() * 480);
+        squaredActivities.push_back(index % 7 == 0 ? 0 : random());
+    }
+    const auto pairwiseDeltas = repulsionDeltas(tarsier::PairwiseRepulsion(), xs, ys, squaredActivities);
+    {
+        const auto deltas = repulsionDeltas(tarsier::CellListRepulsion<100>(), xs, ys, squaredActivities);
+        for (std::size_t index = 0; index < xs.size(); ++index) {
+            REQUIRE(std::abs(deltas.first[index] - pairwiseDeltas.first[index]) < 1e-12);
+            REQUIRE(std::abs(deltas.second[index] - pairwiseDeltas.second[index]) < 1e-12);
+        }
+    }
+    {
+        // the all-pairs reference neglects the same repulsions as the cell list, hence a dropped neighbour cell shows up
+        const auto truncatedDeltas = repulsionDeltas(
+            [](std::size_t size,
+               const double* xs,
+               const double* ys,
+               const double* squaredActivities,
+               double repulsionStrength,
+               double repulsionLength,
+               double* xDeltas,
+               double* yDeltas) {
+                for (std::size_t index = 0; index < size; ++index) {
+                    for (auto otherIndex = index + 1; otherIndex < size; ++otherIndex) {
+                        if (std::pow(xs[index] - xs[otherIndex], 2) + std::pow(ys[index] - ys[otherIndex], 2) < std::pow(12 * repulsionLength, 2)) {
+                            tarsier::PairwiseRepulsion::repel(index, otherIndex, xs, ys, squaredActivities, repulsionStrength, repulsionLength, xDeltas, yDeltas);
+                        }
+                    }
+                }
+            },
+            xs,
+            ys,
+            squaredActivities);
+        const auto deltas = repulsionDeltas(tarsier::CellListRepulsion<12>(), xs, ys, squaredActivities);
+        for (std::size_t index = 0; index < xs.size(); ++index) {
+            REQUIRE(deltas.first[index] == Approx(truncatedDeltas.first[index]).epsilon(1e-9));
+            REQUIRE(deltas.second[index] == Approx(truncatedDeltas.second[index]).epsilon(1e-9));
+        }
+    }
+}
+
+TEST_CASE("Track gaussian blobs without allocations", "[TrackBlobs]") {
+    std::size_t promotions = 0;
+    std::size_t deletions = 0;
+    auto trackBlobs = tarsier::make_trackBlobs<Event, tarsier::ExhaustiveWinnerSearch, tarsier::CellListRepulsion<5>, 16>(
+        {
+            tarsier::Blob{25, 25, 70, 0, 70},
+            tarsier::Blob{75, 25, 70, 0, 70},
+            tarsier::Blob{25, 75, 70, 0, 70},
+            tarsier::Blob{75, 75, 70, 0, 70},
+        },
+        1e3, 0, 0.38, 0.2, 0.9, 0.9, 0.2, 10, 0.2, 30, 100,
+        [&promotions](std::size_t, const tarsier::Blob&) {
+            ++promotions;
+        },
+        [](std::size_t, const tarsier::Blob&) {},
+        [](std::size_t, const tarsier::Blob&) {},
+        [](std::size_t, const tarsier::Blob&) {},
+        [](std::size_t, const tarsier::Blob&) {},
+        [](std::size_t, const tarsier::Blob&) {},
+        [&deletions](std::size_t, const tarsier::Blob&) {
+            ++deletions;
+        }
+    );
+    const auto allocationsBeforeEvents = allocations.load();
+    for (uint64_t timestamp = 0; timestamp < 40000; timestamp += 10) {
+        const auto corner = (timestamp / 5000) % 4;
+        const auto offset = static_cast<uint16_t>((timestamp / 10) % 7);
+        trackBlobs(Event{
+            static_cast<uint16_t>((corner % 2 == 0 ? 22 : 72) + offset),
+            static_cast<uint16_t>((corner / 2 == 0 ? 22 : 72) + (offset * 3) % 7),
+            timestamp,
+        });
+    }
+    const auto allocationsDuringEvents = allocations.load() - allocationsBeforeEvents;
+    REQUIRE(promotions > 0);
+    REQUIRE(deletions > 0);
+    REQUIRE(allocationsDuringEvents == 0);
+}
+
+/// BlobHandler type-erases the callbacks of the trackers compared below.
+typedef std::function<void(std::size_t, const tarsier::Blob&)> BlobHandler;
+
+/// BlobState gathers the parameters, activity and status of a blob.
+struct BlobState {
+    tarsier::Blob blob;
+    double activity;
+    int status;
+};
+
+/// InspectedTrackBlobs exposes the blobs' states, with activities decayed to the given timestamp.
+class InspectedTrackBlobs
+    : public tarsier::TrackBlobs<Event, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler> {
+    public:
+        using tarsier::TrackBlobs<Event, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler, BlobHandler>::TrackBlobs;
+
+        /// state returns the blobs' states, indexed by id.
+        std::map<std::size_t, BlobState> state(uint64_t timestamp) const {
+            std::map<std::size_t, BlobState> idsToStates;
+            for (std::size_t index = 0; index < _ids.size(); ++index) {
+                idsToStates[_ids[index]] = BlobState{blobAt(index), activityAt(index, timestamp), static_cast<int>(_statuses[index])};
+            }
+            return idsToStates;
+        }
+};
+
+/// EagerTrackBlobs decays every activity on every event, and checks every blob against the thresholds.
+/// It is the reference for the crossings heap of TrackBlobs.
+class EagerTrackBlobs : public InspectedTrackBlobs {
+    public:
+        using InspectedTrackBlobs::InspectedTrackBlobs;
+
+        virtual void operator()(Event event) override {
+            {
+                const auto exponentialDecay = std::exp(-static_cast<double>(event.timestamp - _previousTimestamp) / _activityDecay);
+                for (std::size_t index = 0; index < _ids.size(); ++index) {
+                    _activities[index] *= exponentialDecay;
+                    _activityTimestamps[index] = event.timestamp;
+                }
+                _previousTimestamp = event.timestamp;
+                auto probability = 0.0;
+                const auto winner = _winnerSearch(
+                    event.x,
+                    event.y,
+                    tarsier::BlobsView{
+                        _ids.size(),
+                        _xs.data(),
+                        _ys.data(),
+                        _squaredSigmaXs.data(),
+                        _sigmaXYs.data(),
+                        _squaredSigmaYs.data(),
+                    },
+                    probability
+                );
+                probability /= (2 * M_PI);
+                if (winner < _ids.size() && probability > _minimumProbability) {
+                    _activities[winner] += probability;
+                    _xs[winner] = _meanInertia * _xs[winner] + (1 - _meanInertia) * static_cast<double>(event.x);
+                    _ys[winner] = _meanInertia * _ys[winner] + (1 - _meanInertia) * static_cast<double>(event.y);
+                    const auto xPosition = static_cast<double>(event.x) - _xs[winner];
+                    const auto yPosition = static_cast<double>(event.y) - _ys[winner];
+                    _squaredSigmaXs[winner] = _covarianceInertia * _squaredSigmaXs[winner]
+                        + (1 - _covarianceInertia) * std::pow(xPosition, 2);
+                    _sigmaXYs[winner] = _covarianceInertia * _sigmaXYs[winner]
+                        + (1 - _covarianceInertia) * xPosition * yPosition;
+                    _squaredSigmaYs[winner] = _covarianceInertia * _squaredSigmaYs[winner]
+                        + (1 - _covarianceInertia) * std::pow(yPosition, 2);
+                    const auto blob = blobAt(winner);
+                    _winnerSearch.update(winner, blob);
+                    if (_statuses[winner] == Status::promoted) {
+                        _handleUpdatedBlob(_ids[winner], blob);
+                    } else {
+                        _handleUpdatedHiddenBlob(_ids[winner], blob);
+                    }
+                }
+                std::vector<std::pair<tarsier::Blob, double>> promotedBlobs;
+                for (std::size_t index = 0; index < _ids.size();) {
+                    if (_statuses[index] == Status::hidden) {
+                        if (_activities[index] > _promotionActivity) {
+                            promotedBlobs.emplace_back(blobAt(index), _activities[index]);
+                            _handlePromotedBlob(_idOffset + promotedBlobs.size() - 1, promotedBlobs.back().first);
+                            setBlob(index, _initialBlobs[_ids[index]]);
+                            _activities[index] = 0;
+                            _winnerSearch.update(index, _initialBlobs[_ids[index]]);
+                            _handleUpdatedHiddenBlob(_ids[index], _initialBlobs[_ids[index]]);
+                        }
+                        ++index;
+                    } else if (_activities[index] <= _deletionActivity) {
+                        _handleDeletedBlob(_ids[index], blobAt(index));
+                        swapAndPop(index);
+                    } else if (_statuses[index] == Status::promoted && _activities[index] <= _promotionActivity) {
+                        const auto blob = blobAt(index);
+                        _handleDemotedBlob(_ids[index], blob);
+                        _handlePromotedHiddenBlob(_ids[index], blob);
+                        _statuses[index] = Status::demoted;
+                        ++index;
+                    } else if (_statuses[index] == Status::demoted && _activities[index] > _promotionActivity) {
+                        const auto blob = blobAt(index);
+                        _handlePromotedBlob(_ids[index], blob);
+                        _handleDemotedHiddenBlob(_ids[index], blob);
+                        _statuses[index] = Status::promoted;
+                        ++index;
+                    } else {
+                        ++index;
+                    }
+                }
+                for (auto&& promotedBlob : promotedBlobs) {
+                    pushBack(_idOffset, promotedBlob.first, promotedBlob.second, event.timestamp, Status::promoted);
+                    ++_idOffset;
+                }
+            }
+
+            if (_skippedEvents >= _pairwiseCalculationsToSkip) {
+                _skippedEvents = 0;
+                std::vector<double> xDeltas(_ids.size(), 0);
+                std::vector<double> yDeltas(_ids.size(), 0);
+                std::vector<double> squaredActivities(_ids.size());
+                for (std::size_t index = 0; index < _ids.size(); ++index) {
+                    squaredActivities[index] = std::pow(_activities[index], 2);
+                }
+                _repulsion(
+                    _ids.size(),
+                    _xs.data(),
+                    _ys.data(),
+                    squaredActivities.data(),
+                    _repulsionStrength,
+                    _repulsionLength,
+                    xDeltas.data(),
+                    yDeltas.data()
+                );
+                for (std::size_t index = 0; index < _initialBlobs.size(); ++index) {
+                    if (
+                        std::pow(_initialBlobs[index].x - _xs[index], 2) + std::pow(_initialBlobs[index].y - _ys[index], 2)
+                        < _attractionResetDistanceSquared
+                    ) {
+                        xDeltas[index] += _attractionStrength * (_initialBlobs[index].x - _xs[index]);
+                        yDeltas[index] += _attractionStrength * (_initialBlobs[index].y - _ys[index]);
+                    } else {
+                        xDeltas[index] = 0;
+                        yDeltas[index] = 0;
+                        setBlob(index, _initialBlobs[index]);
+                        _activities[index] = 0;
+                    }
+                }
+                for (std::size_t index = 0; index < _ids.size(); ++index) {
+                    _xs[index] += xDeltas[index];
+                    _ys[index] += yDeltas[index];
+                    const auto blob = blobAt(index);
+                    _winnerSearch.update(index, blob);
+                    if (_statuses[index] == Status::promoted) {
+                        _handleUpdatedBlob(_ids[index], blob);
+                    } else {
+                        _handleUpdatedHiddenBlob(_ids[index], blob);
+                    }
+                }
+            } else {
+                ++_skippedEvents;
+            }
+        }
+
+    protected:
+        uint64_t _previousTimestamp = 0;
+};
+
+/// Callback records a tracker callback, with the index of the event which triggered it.
+struct Callback {
+    std::size_t event;
+    std::size_t kind;
+    std::size_t id;
+    tarsier::Blob blob;
+};
+
+/// runTrackBlobs sends the event stream to a tracker, and returns its callbacks.
+/// The tracker reports the lifecycle callbacks of an event in crossing order rather than index order,
+/// hence the callbacks of each event are sorted by kind and id (the order of the updates of a blob is kept).
+template <typename Tracker>
+std::vector<Callback> runTrackBlobs(const std::vector<tarsier::Blob>& initialBlobs, const std::vector<Event>& events, std::map<std::size_t, BlobState>& state) {
+    std::vector<Callback> callbacks;
+    std::size_t eventIndex = 0;
+    const auto makeHandle = [&callbacks, &eventIndex](std::size_t kind) -> BlobHandler {
+        return [&callbacks, &eventIndex, kind](std::size_t id, const tarsier::Blob& blob) {
+            callbacks.push_back(Callback{eventIndex, kind, id, blob});
+        };
+    };
+    Tracker trackBlobs(
+        initialBlobs, 1e3, 1e-4, 0.38, 0.2, 0.9, 0.9, 0.2, 10, 0.2, 30, 50,
+        makeHandle(0),
+        makeHandle(1),
+        makeHandle(2),
+        makeHandle(3),
+        makeHandle(4),
+        makeHandle(5),
+        makeHandle(6)
+    );
+    for (auto&& event : events) {
+        ++eventIndex;
+        trackBlobs(event);
+    }
+    state = trackBlobs.state(events.back().timestamp);
+    std::stable_sort(callbacks.begin(), callbacks.end(), [](const Callback& first, const Callback& second) {
+        return std::tie(first.event, first.kind, first.id) < std::tie(second.event, second.kind, second.id);
+    });
+    return callbacks;
+}
+
+TEST_CASE("Decay the blobs' activities lazily", "[TrackBlobs]") {
+    const auto initialBlobs = std::vector<tarsier::Blob>{
+        tarsier::Blob{25, 25, 70, 0, 70},
+        tarsier::Blob{75, 25, 70, 0, 70},
+        tarsier::Blob{25, 75, 70, 0, 70},
+        tarsier::Blob{75, 75, 70, 0, 70},
+    };
+    std::vector<Event> events;
+    uint64_t state = 1;
+    for (uint64_t timestamp = 0; timestamp < 60000; timestamp += 10) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        // the active corner changes every 3 ms and goes silent now and then, so that blobs are demoted, promoted again and deleted
+        const auto corner = (timestamp / 3000 + (state >> 62)) % 4;
+        if ((timestamp / 3000) % 5 == 4 && (state >> 40) % 4 != 0) {
+            continue;
+        }
+        const auto offset = static_cast<uint16_t>((timestamp / 10) % 7);
+        events.push_back(Event{
+            static_cast<uint16_t>((corner % 2 == 0 ? 22 : 72) + offset),
+            static_cast<uint16_t>((corner / 2 == 0 ? 22 : 72) + (offset * 3) % 7),
+            timestamp,
+        });
+    }
+    std::map<std::size_t, BlobState> lazyState;
+    std::map<std::size_t, BlobState> eagerState;
+    const auto lazyCallbacks = runTrackBlobs<InspectedTrackBlobs>(initialBlobs, events, lazyState);
+    const auto eagerCallbacks = runTrackBlobs<EagerTrackBlobs>(initialBlobs, events, eagerState);
+    std::array<std::size_t, 7> kinds{};
+    for (auto&& callback : eagerCallbacks) {
+        ++kinds[callback.kind];
+    }
+    for (auto&& count : kinds) {
+        REQUIRE(count > 0);
+    }
+    REQUIRE(lazyCallbacks.size() == eagerCallbacks.size());
+    for (std::size_t index = 0; index < lazyCallbacks.size(); ++index) {
+        REQUIRE(lazyCallbacks[index].event == eagerCallbacks[index].event);
+        REQUIRE(lazyCallbacks[index].kind == eagerCallbacks[index].kind);
+        REQUIRE(lazyCallbacks[index].id == eagerCallbacks[index].id);
+        REQUIRE(lazyCallbacks[index].blob.x == Approx(eagerCallbacks[index].blob.x).epsilon(1e-9));
+        REQUIRE(lazyCallbacks[index].blob.y == Approx(eagerCallbacks[index].blob.y).epsilon(1e-9));
+    }
+    REQUIRE(lazyState.size() == eagerState.size());
+    for (auto&& idAndState : eagerState) {
+        REQUIRE(lazyState.count(idAndState.first) == 1);
+        const auto& lazyBlobState = lazyState[idAndState.first];
+        REQUIRE(lazyBlobState.status == idAndState.second.status);
+        REQUIRE(lazyBlobState.activity == Approx(idAndState.second.activity).epsilon(1e-9));
+        REQUIRE(lazyBlobState.blob.x == Approx(idAndState.second.blob.x).epsilon(1e-9));
+        REQUIRE(lazyBlobState.blob.y == Approx(idAndState.second.blob.y).epsilon(1e-9));
+        REQUIRE(lazyBlobState.blob.squaredSigmaX == Approx(idAndState.second.blob.squaredSigmaX).epsilon(1e-9));
+        REQUIRE(lazyBlobState.blob.sigmaXY == Approx(idAndState.second.blob.sigmaXY).epsilon(1e-9));
+        REQUIRE(lazyBlobState.blob.squaredSigmaY == Approx(idAndState.second.blob.squaredSigmaY).epsilon(1e-9));
+    }
+}